@@ -0,0 +1,77 @@
+/*
+ * Micro-benchmark of UTILS::unpackBits against a per-sample shift-and-mask loop, for 1, 2 and 4 bit samples.
+ *
+ * Usage: bench_unpack [packed MB (default 64)] [threads (default 0 = all cores)]
+ * Build with `make bench_unpack`. Exits with 1 if an unpacked output differs from the reference.
+ */
+#include "utils/bit_unpack.hpp"
+#include "utils/thread_pool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+    void unpackReference(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        const unsigned int perByte = 8 / nBits;
+        const uint8_t mask = static_cast<uint8_t>((1u << nBits) - 1);
+        for (std::size_t i = 0; i < nBytes; i++) {
+            for (unsigned int s = 0; s < perByte; s++) unpacked[i * perByte + s] = (packed[i] >> (s * nBits)) & mask;
+        }
+    }
+
+    /* the best of a few runs, in packed MB/s */
+    template <typename F>
+    double throughput(std::size_t nBytes, F &&unpack) {
+        double best = 0.0;
+        for (int run = 0; run < 5; run++) {
+            auto start = std::chrono::steady_clock::now();
+            unpack();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::max(best, nBytes / 1e6 / elapsed.count());
+        }
+        return best;
+    }
+
+};
+
+int main(int argc, char **argv) {
+    std::size_t nBytes = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64) * 1000000;
+    unsigned int nThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+    std::vector<uint8_t> packed(nBytes);
+    std::mt19937 generator(42);
+    for (uint8_t &byte : packed) byte = static_cast<uint8_t>(generator());
+
+    UTILS::ThreadPool threadPool(nThreads);
+    std::cout << "Unpacking " << nBytes / 1000000 << " MB with " << UTILS::unpackBitsISA() << ", "
+              << threadPool.getNThreads() << " threads" << std::endl;
+    std::cout << std::left << std::setw(6) << "nbits" << std::setw(14) << "scalar MB/s" << std::setw(14) << "simd MB/s"
+              << std::setw(14) << "threaded MB/s" << std::endl;
+
+    for (unsigned int nBits : {1u, 2u, 4u}) {
+        std::size_t nSamples = nBytes * 8 / nBits;
+        std::vector<uint8_t> reference(nSamples), unpacked(nSamples);
+
+        double scalar = throughput(nBytes, [&] { unpackReference(packed.data(), nBytes, nBits, reference.data()); });
+        double simd = throughput(nBytes, [&] { UTILS::unpackBits(packed.data(), nBytes, nBits, unpacked.data()); });
+        if (std::memcmp(reference.data(), unpacked.data(), nSamples) != 0) {
+            std::cerr << "FAIL: " << nBits << " bit unpacking differs from the reference" << std::endl;
+            return 1;
+        }
+        std::fill(unpacked.begin(), unpacked.end(), 0);
+        double threaded = throughput(nBytes, [&] { UTILS::unpackBits(packed.data(), nBytes, nBits, unpacked.data(), &threadPool); });
+        if (std::memcmp(reference.data(), unpacked.data(), nSamples) != 0) {
+            std::cerr << "FAIL: threaded " << nBits << " bit unpacking differs from the reference" << std::endl;
+            return 1;
+        }
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(6) << nBits << std::setw(14) << scalar
+                  << std::setw(14) << simd << std::setw(14) << threaded << std::endl;
+    }
+    return 0;
+}
@@ -207,6 +207,10 @@ namespace APP {
         TCLAP::ValueArg<std::string> argInputFile{"i", "input_file", "Input file name", true, "", "string"};
         TCLAP::ValueArg<std::string> argInputFormat{"", "input_format", "Input file format", false, "", "string"};
 
+        bool useMmap;
+
+        TCLAP::SwitchArg argMmap{"", "mmap", "Memory-map the input file instead of reading it into RAM"};
+
         std::string selectionUnits;
 
         std::string killFile;
@@ -226,6 +230,7 @@ namespace APP {
                              nSecs(-1),
                              inputFile(NULL_STR),
                              inputFormat("sigproc_filterbank"),
+                             useMmap(false),
                              selectionUnits(NULL_STR),
                              killFile(NULL_STR),
                              birdiesFile(NULL_STR) {
@@ -243,6 +248,7 @@ namespace APP {
 
             ArgsBase::cmd.add(argInputFile);
             ArgsBase::cmd.add(argInputFormat);
+            ArgsBase::cmd.add(argMmap);
 
             ArgsBase::cmd.add(argKillFile);
             ArgsBase::cmd.add(argBirdiesFile);
@@ -269,6 +275,7 @@ namespace APP {
 
             inputFile = argInputFile.getValue();
             inputFormat = argInputFormat.getValue();
+            useMmap = argMmap.getValue();
             killFile = argKillFile.getValue();
             birdiesFile = argBirdiesFile.getValue();
 
@@ -291,6 +298,8 @@ namespace APP {
                     inputFormat = "presto_timeseries";
                 else if (ext == "tim")
                     inputFormat = "sigproc_timeseries";
+                else if (ext == "dmc")
+                    inputFormat = "dm_cube";
                 else
                     throw CustomException("Could not guess input file format from extension. Please specify using -f option");
             }
@@ -309,7 +318,7 @@ namespace APP {
         std::string outputSuffix;
 
         TCLAP::ValueArg<std::string> argOutputDir{"o", "out_dir", "Output directory", true, "./", "string"};
-        TCLAP::ValueArg<std::string> argOutputFormat{"", "out_format", "Output file format", false, "presto_timeseries", "string"};
+        TCLAP::ValueArg<std::string> argOutputFormat{"", "out_format", "Output file format: presto_timeseries (one file per DM) or dm_cube (all DMs in one file)", false, "presto_timeseries", "string"};
         TCLAP::ValueArg<std::string> argOutputPrefix{"", "out_prefix", "Prefix for output file names", false, "", "string"};
         TCLAP::ValueArg<std::string> argOutputSuffix{"", "out_suffix", "Suffix for output file names", false, "", "string"};
 
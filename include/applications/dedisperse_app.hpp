@@ -33,9 +33,40 @@ class DedisperseCommandArgs: public APP::DataFileReadArgs, public APP::FileWrite
         std::string dmFile; /**< The file with a list of DMs to dedisperse to. */
         bool verbose; /**< Flag indicating if verbose mode is enabled. */
 
-        int barycentre; /**< Flag indicating if barycentring the data before dedispersion is enabled. */
+        int barycentre; /**< Flag indicating if the time series searched for periodic signals are barycentred. */
+        std::string ephemerisFile; /**< The Earth ephemeris the barycentring uses. */
         int numGpus; /**< The number of GPUs to use for dedispersion. */
-        int ramLimitGB; /**< The maximum amount of data to load into host RAM at a time (in GB). */
+        std::string backend; /**< The dedispersion engine to use (gpu, cpu, subband or fdmt). */
+        int numThreads; /**< The number of CPU threads to use for dedispersion (0 = all cores). */
+        int numSubbands; /**< The number of subbands for subband dedispersion (0 = automatic). */
+        float subbandSmearing; /**< The extra smearing (in samples) allowed by subband dedispersion. */
+        int readAhead; /**< The number of gulps to read ahead in the background (0 = read on demand). */
+        int numWriters; /**< The number of threads writing the dedispersed time series. */
+        int outNBits; /**< The number of bits per dedispersed output sample (8, 16 or 32). */
+        int maxBufferedGulps; /**< The number of dedispersed gulps that may wait for the writers. */
+        bool normalise; /**< Flag indicating if the channels are normalised before dedispersion. */
+        std::string bandpassFile; /**< The file the per-gulp channel statistics are read from or written to. */
+        bool rfiFlag; /**< Flag indicating if RFI is flagged automatically in every gulp. */
+        float rfiThreshold; /**< The number of robust sigmas beyond which a channel is flagged as RFI. */
+        bool zeroDM; /**< Flag indicating if the zero-DM time series is subtracted from every channel. */
+        float clipSigma; /**< The number of robust sigmas above which zero-DM time samples are clipped (0 = off). */
+        bool fftSearch; /**< Flag indicating if the dedispersed time series are searched for periodic signals. */
+        int fftNumHarmonics; /**< The largest number of harmonics summed by the periodicity search. */
+        float fftSigma; /**< The significance periodicity candidates must reach. */
+        float fftMinFreq; /**< The lowest frequency searched, in Hz. */
+        float fftMaxFreq; /**< The highest frequency searched, in Hz (0 = Nyquist). */
+        float accelMax; /**< The largest acceleration searched, in m/s^2 (0 = no acceleration search). */
+        bool whiten; /**< Flag indicating if red noise is removed from the spectra of the periodicity search. */
+        float zMax; /**< The largest Fourier drift searched in the Fourier domain, in bins (0 = off). */
+        float wMax; /**< The largest change of the Fourier drift searched, in bins (0 = no jerk search). */
+        bool spSearch; /**< Flag indicating if every dedispersed gulp is searched for single pulses. */
+        int spMaxWidth; /**< The widest boxcar of the single pulse search, in samples. */
+        float spSigma; /**< The signal-to-noise ratio single pulse events must reach. */
+        bool sift; /**< Flag indicating if the candidates are clustered and written as binary tables. */
+        float siftDmLink; /**< The friends-of-friends link length in DM trials. */
+        float siftTimeLink; /**< The friends-of-friends link length of single pulses in samples. */
+        float siftFreqLink; /**< The friends-of-friends link length of periodicity candidates in Fourier bins. */
+        int ramLimitGB; /**< The host RAM the gulps and buffers are sized to fit, in GB. */
 
         TCLAP::ValueArg<float> argDmStart{"", "dm_start", "First DM to dedisperse to. (default =0)",false, 0.0, "float"};
         TCLAP::ValueArg<float> argDmEnd{"", "dm_end","Last DM to dedisperse to. (default = 2000)",false, 2000.0, "float"};
@@ -43,9 +74,40 @@ class DedisperseCommandArgs: public APP::DataFileReadArgs, public APP::FileWrite
         TCLAP::ValueArg<float> argDmPulseWidth{"", "dm_pulse_width","minimum intrinsic pulse width in us (default=64 us)",false, 64.0, "float"};
         TCLAP::ValueArg<std::string> argDmFile{"", "dm_file","File with list of DMs to dedisperse to",false, "", "float"};
         TCLAP::ValueArg<size_t> argDedispGulp{"", "dedisp_gulp","Number of samples to dedisperse at a time",false, 0, "size_t"};
-        TCLAP::SwitchArg argBarycentre{"", "barycentre", "Barycentre the data before dedispersion"};
-        TCLAP::ValueArg<int> argNumGpus{"", "num_gpus", "Number of GPUs to use for dedispersion",false, 1, "int"};
-        TCLAP::ValueArg<int> argRamLimitGB{"", "", "Maximum amount of data to load into host RAM at a time (in GB)",false, 100, "int"};
+        TCLAP::SwitchArg argBarycentre{"", "barycentre", "Barycentre the time series searched by --fft_search, by adding and dropping samples"};
+        TCLAP::ValueArg<std::string> argEphemerisFile{"", "ephemeris_file", "Earth ephemeris for --barycentre: MJD and x, y, z relative to the solar system barycentre in light-seconds on every line",false, "", "string"};
+        TCLAP::ValueArg<int> argNumGpus{"", "num_gpus", "Number of GPUs to use for dedispersion with the gpu backend; only 1 is supported",false, 1, "int"};
+        TCLAP::ValueArg<std::string> argBackend{"", "backend", "Dedispersion backend: gpu, cpu, subband or fdmt (default = gpu if built with CUDA, else cpu)",false, "", "string"};
+        TCLAP::ValueArg<int> argNumThreads{"", "num_threads", "Number of CPU threads to use for dedispersion (default = 0, all cores)",false, 0, "int"};
+        TCLAP::ValueArg<int> argNumSubbands{"", "num_subbands", "Number of subbands for the subband backend (default = 0, about sqrt(nchans))",false, 0, "int"};
+        TCLAP::ValueArg<float> argSubbandSmearing{"", "subband_smearing", "Extra smearing in samples the subband backend may add (default = 1)",false, 1.0, "float"};
+        TCLAP::ValueArg<int> argReadAhead{"", "read_ahead", "Number of gulps to read ahead on a background thread (default = 2, 0 to read on demand)",false, 2, "int"};
+        TCLAP::ValueArg<int> argNumWriters{"", "num_writers", "Number of threads writing the dedispersed time series (default = 4)",false, 4, "int"};
+        TCLAP::ValueArg<int> argOutNBits{"", "out_nbits", "Bits per dedispersed output sample: 8 or 16 (scaled per DM, presto or dm_cube output) or 32 (default = 32)",false, 32, "int"};
+        TCLAP::ValueArg<int> argMaxBufferedGulps{"", "max_buffered_gulps", "Number of dedispersed gulps that may wait to be written before dedispersion pauses (default = 1)",false, 1, "int"};
+        TCLAP::SwitchArg argNormalise{"", "normalise", "Normalise every channel of each gulp to a common mean and sigma before dedispersion"};
+        TCLAP::ValueArg<std::string> argBandpassFile{"", "bandpass_file", "Channel statistics for --normalise, reused if present (default = <out_dir>/<input name>.bandpass)",false, "", "string"};
+        TCLAP::SwitchArg argRfiFlag{"", "rfi_flag", "Mask the channels of every gulp that fail the spectral kurtosis or bandpass tests"};
+        TCLAP::ValueArg<float> argRfiThreshold{"", "rfi_threshold", "Robust sigmas beyond which --rfi_flag masks a channel (default = 5)",false, 5.0, "float"};
+        TCLAP::SwitchArg argZeroDM{"", "zero_dm", "Subtract the zero-DM time series from every channel before dedispersion"};
+        TCLAP::ValueArg<float> argClipSigma{"", "clip_sigma", "Replace time samples whose zero-DM value exceeds this many robust sigmas by the channel means (default = 0, off)",false, 0.0, "float"};
+        TCLAP::SwitchArg argFftSearch{"", "fft_search", "Search the dedispersed time series for periodic signals and write <prefix>.fftcands"};
+        TCLAP::ValueArg<int> argFftNumHarmonics{"", "fft_nharm", "Largest number of harmonics summed by --fft_search: 1, 2, 4, 8, 16 or 32 (default = 16)",false, 16, "int"};
+        TCLAP::ValueArg<float> argFftSigma{"", "fft_sigma", "Significance a periodicity candidate must reach (default = 6)",false, 6.0, "float"};
+        TCLAP::ValueArg<float> argFftMinFreq{"", "fft_min_freq", "Lowest frequency searched by --fft_search in Hz (default = 1)",false, 1.0, "float"};
+        TCLAP::ValueArg<float> argFftMaxFreq{"", "fft_max_freq", "Highest frequency searched by --fft_search in Hz (default = 0, Nyquist)",false, 0.0, "float"};
+        TCLAP::ValueArg<float> argAccelMax{"", "accel_max", "Largest acceleration in m/s^2 searched by --fft_search, by resampling the time series (default = 0, off)",false, 0.0, "float"};
+        TCLAP::SwitchArg argWhiten{"", "whiten", "Remove red noise from every spectrum of --fft_search with a running median; birdies in --birdies_file are zapped as well"};
+        TCLAP::ValueArg<float> argZMax{"", "zmax", "Largest Fourier drift in bins of the highest harmonic searched by --fft_search with Fourier-domain templates (default = 0, off)",false, 0.0, "float"};
+        TCLAP::ValueArg<float> argWMax{"", "wmax", "Largest change of the Fourier drift in bins searched with --zmax, for jerk (default = 0, off)",false, 0.0, "float"};
+        TCLAP::SwitchArg argSpSearch{"", "sp_search", "Search every dedispersed gulp for single pulses with boxcar filters and write <prefix>.singlepulse"};
+        TCLAP::ValueArg<int> argSpMaxWidth{"", "sp_max_width", "Widest boxcar in samples tried by --sp_search, a power of two (default = 64)",false, 64, "int"};
+        TCLAP::ValueArg<float> argSpSigma{"", "sp_sigma", "Signal-to-noise ratio a single pulse must reach (default = 6)",false, 6.0, "float"};
+        TCLAP::SwitchArg argSift{"", "sift", "Cluster the candidates of --sp_search and --fft_search and write the best of each to <prefix>.singlepulse.bin and <prefix>.fftcands.bin"};
+        TCLAP::ValueArg<float> argSiftDmLink{"", "sift_dm_link", "Largest distance in DM trials between candidates of one cluster (default = 2)",false, 2.0, "float"};
+        TCLAP::ValueArg<float> argSiftTimeLink{"", "sift_time_link", "Largest distance in samples between single pulses of one cluster (default = 64)",false, 64.0, "float"};
+        TCLAP::ValueArg<float> argSiftFreqLink{"", "sift_freq_link", "Largest distance in Fourier bins between periodicity candidates of one cluster (default = 1)",false, 1.0, "float"};
+        TCLAP::ValueArg<int> argRamLimitGB{"", "ram_limit_gb", "Host RAM in GB the dedispersion may use: the gulp size, read-ahead and buffered gulps are chosen to fit (default = 100)",false, 100, "int"};
 
         /**
          * @brief Constructs a DedisperseCommandArgs object with default values.
@@ -57,7 +119,38 @@ class DedisperseCommandArgs: public APP::DataFileReadArgs, public APP::FileWrite
                                 dedispGulp(0),  
                                 dmFile(""), 
                                 barycentre(0),
+                                ephemerisFile(""),
                                 numGpus(1),
+                                backend(""),
+                                numThreads(0),
+                                numSubbands(0),
+                                subbandSmearing(1.0),
+                                readAhead(2),
+                                numWriters(4),
+                                outNBits(32),
+                                maxBufferedGulps(1),
+                                normalise(false),
+                                bandpassFile(""),
+                                rfiFlag(false),
+                                rfiThreshold(5.0),
+                                zeroDM(false),
+                                clipSigma(0.0),
+                                fftSearch(false),
+                                fftNumHarmonics(16),
+                                fftSigma(6.0),
+                                fftMinFreq(1.0),
+                                fftMaxFreq(0.0),
+                                accelMax(0.0),
+                                whiten(false),
+                                zMax(0.0),
+                                wMax(0.0),
+                                spSearch(false),
+                                spMaxWidth(64),
+                                spSigma(6.0),
+                                sift(false),
+                                siftDmLink(2.0),
+                                siftTimeLink(64.0),
+                                siftFreqLink(1.0),
                                 ramLimitGB(100)
         {
             ArgsBase::registerParser(typeid(*this).name(), [this](int argc, char** argv) { DedisperseCommandArgs::parse(argc, argv); });
@@ -68,7 +161,38 @@ class DedisperseCommandArgs: public APP::DataFileReadArgs, public APP::FileWrite
             ArgsBase::cmd.add(argDmFile);
             ArgsBase::cmd.add(argDedispGulp);
             ArgsBase::cmd.add(argBarycentre);
+            ArgsBase::cmd.add(argEphemerisFile);
             ArgsBase::cmd.add(argNumGpus);
+            ArgsBase::cmd.add(argBackend);
+            ArgsBase::cmd.add(argNumThreads);
+            ArgsBase::cmd.add(argNumSubbands);
+            ArgsBase::cmd.add(argSubbandSmearing);
+            ArgsBase::cmd.add(argReadAhead);
+            ArgsBase::cmd.add(argNumWriters);
+            ArgsBase::cmd.add(argOutNBits);
+            ArgsBase::cmd.add(argMaxBufferedGulps);
+            ArgsBase::cmd.add(argNormalise);
+            ArgsBase::cmd.add(argBandpassFile);
+            ArgsBase::cmd.add(argRfiFlag);
+            ArgsBase::cmd.add(argRfiThreshold);
+            ArgsBase::cmd.add(argZeroDM);
+            ArgsBase::cmd.add(argClipSigma);
+            ArgsBase::cmd.add(argFftSearch);
+            ArgsBase::cmd.add(argFftNumHarmonics);
+            ArgsBase::cmd.add(argFftSigma);
+            ArgsBase::cmd.add(argFftMinFreq);
+            ArgsBase::cmd.add(argFftMaxFreq);
+            ArgsBase::cmd.add(argAccelMax);
+            ArgsBase::cmd.add(argWhiten);
+            ArgsBase::cmd.add(argZMax);
+            ArgsBase::cmd.add(argWMax);
+            ArgsBase::cmd.add(argSpSearch);
+            ArgsBase::cmd.add(argSpMaxWidth);
+            ArgsBase::cmd.add(argSpSigma);
+            ArgsBase::cmd.add(argSift);
+            ArgsBase::cmd.add(argSiftDmLink);
+            ArgsBase::cmd.add(argSiftTimeLink);
+            ArgsBase::cmd.add(argSiftFreqLink);
             ArgsBase::cmd.add(argRamLimitGB);
         }
         
@@ -92,7 +216,92 @@ class DedisperseCommandArgs: public APP::DataFileReadArgs, public APP::FileWrite
             gulping = argDedispGulp.isSet();
             dedispGulp = argDedispGulp.getValue();
             barycentre = argBarycentre.getValue();
+            ephemerisFile = argEphemerisFile.getValue();
             numGpus = argNumGpus.getValue();
+            backend = argBackend.getValue();
+            numThreads = argNumThreads.getValue();
+            numSubbands = argNumSubbands.getValue();
+            subbandSmearing = argSubbandSmearing.getValue();
+            if (numThreads < 0 || numSubbands < 0) {
+                throw CustomException("num_threads and num_subbands cannot be negative");
+            }
+            if (subbandSmearing <= 0) {
+                throw CustomException("subband_smearing must be positive");
+            }
+            readAhead = argReadAhead.getValue();
+            if (readAhead < 0) {
+                throw CustomException("read_ahead cannot be negative");
+            }
+            numWriters = argNumWriters.getValue();
+            if (numWriters < 1) {
+                throw CustomException("num_writers must be at least 1");
+            }
+            outNBits = argOutNBits.getValue();
+            if (outNBits != 8 && outNBits != 16 && outNBits != 32) {
+                throw CustomException("out_nbits must be 8, 16 or 32");
+            }
+            maxBufferedGulps = argMaxBufferedGulps.getValue();
+            if (maxBufferedGulps < 1) {
+                throw CustomException("max_buffered_gulps must be at least 1");
+            }
+            normalise = argNormalise.getValue();
+            bandpassFile = argBandpassFile.getValue();
+            rfiFlag = argRfiFlag.getValue();
+            rfiThreshold = argRfiThreshold.getValue();
+            if (rfiThreshold <= 0) {
+                throw CustomException("rfi_threshold must be positive");
+            }
+            zeroDM = argZeroDM.getValue();
+            clipSigma = argClipSigma.getValue();
+            if (clipSigma < 0) {
+                throw CustomException("clip_sigma cannot be negative");
+            }
+            fftSearch = argFftSearch.getValue();
+            fftNumHarmonics = argFftNumHarmonics.getValue();
+            fftSigma = argFftSigma.getValue();
+            fftMinFreq = argFftMinFreq.getValue();
+            fftMaxFreq = argFftMaxFreq.getValue();
+            if (fftNumHarmonics < 1 || fftNumHarmonics > 32 || (fftNumHarmonics & (fftNumHarmonics - 1)) != 0) {
+                throw CustomException("fft_nharm must be 1, 2, 4, 8, 16 or 32");
+            }
+            if (fftMinFreq < 0 || fftMaxFreq < 0) {
+                throw CustomException("fft_min_freq and fft_max_freq cannot be negative");
+            }
+            accelMax = argAccelMax.getValue();
+            if (accelMax < 0) {
+                throw CustomException("accel_max cannot be negative");
+            }
+            whiten = argWhiten.getValue();
+            zMax = argZMax.getValue();
+            wMax = argWMax.getValue();
+            if (zMax < 0 || wMax < 0) {
+                throw CustomException("zmax and wmax cannot be negative");
+            }
+            if (accelMax > 0 && (zMax > 0 || wMax > 0)) {
+                throw CustomException("You cannot set both accel_max and zmax or wmax");
+            }
+            spSearch = argSpSearch.getValue();
+            spMaxWidth = argSpMaxWidth.getValue();
+            spSigma = argSpSigma.getValue();
+            if (spMaxWidth < 1 || (spMaxWidth & (spMaxWidth - 1)) != 0) {
+                throw CustomException("sp_max_width must be a power of two");
+            }
+            if (spSigma <= 0) {
+                throw CustomException("sp_sigma must be positive");
+            }
+            if (barycentre && (!fftSearch || ephemerisFile.empty())) {
+                throw CustomException("barycentre needs fft_search and an ephemeris_file");
+            }
+            sift = argSift.getValue();
+            siftDmLink = argSiftDmLink.getValue();
+            siftTimeLink = argSiftTimeLink.getValue();
+            siftFreqLink = argSiftFreqLink.getValue();
+            if (siftDmLink <= 0 || siftTimeLink <= 0 || siftFreqLink <= 0) {
+                throw CustomException("sift_dm_link, sift_time_link and sift_freq_link must be positive");
+            }
             ramLimitGB = argRamLimitGB.getValue();
+            if (ramLimitGB < 1) {
+                throw CustomException("ram_limit_gb must be at least 1");
+            }
         }
 };
@@ -0,0 +1,87 @@
+/**
+ * @file fold_app.hpp
+ * @brief Contains the declaration of the FoldCommandArgs class.
+ */
+
+#include <tclap/CmdLine.h>
+#include <string>
+#include <iostream>
+#include "exceptions.hpp"
+#include "applications/common_arguments.hpp"
+#include <typeinfo>
+
+/**
+ * @class FoldCommandArgs
+ * @brief Represents the command line arguments for the fold application.
+ *
+ * This class inherits from APP::DataFileReadArgs, APP::FileWriteArgs, and APP::CommonArgs.
+ * It provides additional arguments specific to the fold application.
+ */
+class FoldCommandArgs: public APP::DataFileReadArgs, public APP::FileWriteArgs, public APP::CommonArgs
+{
+    public:
+        std::string candidatesFile; /**< The candidates to fold. */
+        int numBins; /**< The number of phase bins per period. */
+        int numSubints; /**< The number of sub-integrations. */
+        int numSubbands; /**< The number of subbands. */
+        int numThreads; /**< The number of threads the candidates are folded on (0 = all cores). */
+        std::size_t foldGulp; /**< The number of samples read at a time. */
+        int readAhead; /**< The number of gulps to read ahead in the background (0 = read on demand). */
+
+        TCLAP::ValueArg<std::string> argCandidatesFile{"c", "candidates", "Candidates to fold: a binary table written by --sift, or a text file of period(ms) DM [acceleration(m/s^2)] lines",true, "", "string"};
+        TCLAP::ValueArg<int> argNumBins{"", "nbins", "Number of phase bins per period (default = 64)",false, 64, "int"};
+        TCLAP::ValueArg<int> argNumSubints{"", "nsubints", "Number of sub-integrations (default = 32)",false, 32, "int"};
+        TCLAP::ValueArg<int> argNumSubbands{"", "nsubbands", "Number of subbands, which must divide the number of channels (default = 32)",false, 32, "int"};
+        TCLAP::ValueArg<int> argNumThreads{"", "num_threads", "Number of CPU threads the candidates are folded on (default = 0, all cores)",false, 0, "int"};
+        TCLAP::ValueArg<size_t> argFoldGulp{"", "fold_gulp", "Number of samples to read at a time (default = 65536)",false, 65536, "size_t"};
+        TCLAP::ValueArg<int> argReadAhead{"", "read_ahead", "Number of gulps to read ahead on a background thread (default = 2, 0 to read on demand)",false, 2, "int"};
+
+        /**
+         * @brief Constructs a FoldCommandArgs object with default values.
+         */
+        FoldCommandArgs():candidatesFile(""),
+                          numBins(64),
+                          numSubints(32),
+                          numSubbands(32),
+                          numThreads(0),
+                          foldGulp(65536),
+                          readAhead(2)
+        {
+            ArgsBase::registerParser(typeid(*this).name(), [this](int argc, char** argv) { FoldCommandArgs::parse(argc, argv); });
+            ArgsBase::cmd.add(argCandidatesFile);
+            ArgsBase::cmd.add(argNumBins);
+            ArgsBase::cmd.add(argNumSubints);
+            ArgsBase::cmd.add(argNumSubbands);
+            ArgsBase::cmd.add(argNumThreads);
+            ArgsBase::cmd.add(argFoldGulp);
+            ArgsBase::cmd.add(argReadAhead);
+        }
+
+        /**
+         * @brief Parses the command line arguments.
+         *
+         * @param argc The number of command line arguments.
+         * @param argv The array of command line arguments.
+         */
+        inline void parse(int argc, char **argv) override{
+            candidatesFile = argCandidatesFile.getValue();
+            numBins = argNumBins.getValue();
+            numSubints = argNumSubints.getValue();
+            numSubbands = argNumSubbands.getValue();
+            if (numBins < 1 || numSubints < 1 || numSubbands < 1) {
+                throw CustomException("nbins, nsubints and nsubbands must be at least 1");
+            }
+            numThreads = argNumThreads.getValue();
+            if (numThreads < 0) {
+                throw CustomException("num_threads cannot be negative");
+            }
+            foldGulp = argFoldGulp.getValue();
+            if (foldGulp == 0) {
+                throw CustomException("fold_gulp must be positive");
+            }
+            readAhead = argReadAhead.getValue();
+            if (readAhead < 0) {
+                throw CustomException("read_ahead cannot be negative");
+            }
+        }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace IO {
+
+    /**
+     * @brief Header of a candidate table file. nRecords records of recordBytes bytes each follow it.
+     */
+    struct CandidateTableHeader
+    {
+        char magic[8];
+        uint32_t kind;              /**< CandidateTable::SINGLE_PULSE or CandidateTable::PERIODICITY. */
+        uint32_t recordBytes;
+        uint64_t nRecords;
+        double tsamp;               /**< Sampling time of the dedispersed time series in seconds. */
+        double observationLength;   /**< Length of the searched time series in seconds (0 if unknown). */
+    };
+
+    /**
+     * @brief The strongest single pulse event of a cluster.
+     */
+    struct SinglePulseRecord
+    {
+        float dm;
+        float snr;
+        uint64_t sample;   /**< First sample of the boxcar in the dedispersed time series. */
+        uint32_t width;    /**< Boxcar width in samples. */
+        uint32_t nMembers; /**< Number of events in the cluster. */
+        float dmMin;       /**< Lowest DM of the cluster. */
+        float dmMax;       /**< Highest DM of the cluster. */
+    };
+
+    /**
+     * @brief The strongest periodicity candidate of a cluster.
+     */
+    struct PeriodicityRecord
+    {
+        double frequency;     /**< Fundamental frequency in Hz. */
+        float dm;
+        float acceleration;   /**< m/s^2 */
+        float jerk;           /**< m/s^3 */
+        float power;
+        float sigma;
+        uint32_t nHarmonics;  /**< Number of harmonics summed. */
+        uint32_t nMembers;    /**< Number of candidates in the cluster. */
+        uint32_t nRelated;    /**< Number of weaker clusters at harmonically related frequencies merged into it. */
+    };
+
+    /**
+     * @brief Compact binary table of sifted candidates: a CandidateTableHeader and the records as stored in memory,
+     * strongest first.
+     */
+    class CandidateTable
+    {
+        template <typename RECORD>
+        static void write(const std::string &fileName, uint32_t kind, const std::vector<RECORD> &records, double tsamp,
+                          double observationLength);
+
+        template <typename RECORD>
+        static CandidateTableHeader read(const std::string &fileName, uint32_t kind, std::vector<RECORD> &records);
+
+        template <typename RECORD>
+        static CandidateTableHeader parse(const std::string &data, const std::string &name, uint32_t kind, std::vector<RECORD> &records);
+
+    public:
+        static const char MAGIC[8];
+        static const uint32_t SINGLE_PULSE = 1;
+        static const uint32_t PERIODICITY = 2;
+
+        static void write(const std::string &fileName, const std::vector<SinglePulseRecord> &records, double tsamp,
+                          double observationLength);
+        static void write(const std::string &fileName, const std::vector<PeriodicityRecord> &records, double tsamp,
+                          double observationLength);
+
+        /**
+         * @brief Reads a table of the matching kind into records and returns its header.
+         *
+         * @throws FileFormatNotRecognised if the file is not a candidate table of that kind.
+         */
+        static CandidateTableHeader read(const std::string &fileName, std::vector<SinglePulseRecord> &records);
+        static CandidateTableHeader read(const std::string &fileName, std::vector<PeriodicityRecord> &records);
+
+        /**
+         * @brief Like read(), for a table already read into memory, e.g. from a pipe that cannot be opened twice.
+         *
+         * @param name The name of the file the data came from, for error messages.
+         */
+        static CandidateTableHeader parse(const std::string &data, const std::string &name, std::vector<PeriodicityRecord> &records);
+    };
+
+};
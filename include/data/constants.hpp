@@ -31,7 +31,6 @@ const std::string FOFF = "foff";
 const std::string CHANNELBW = "foff";
 
 
-const std::string HEADER_KEYS_FILE ="resources/header_keys.info";
 const std::string INT = "int";
 const std::string DOUBLE = "double";
 const std::string FLOAT = "float";
@@ -40,6 +39,9 @@ const std::string LONG = "long";
 const std::string NULL_STR = "null";
 
 
+const double DISPERSION_CONSTANT = 4.15e3; // MHz^2 pc^-1 cm^3 s, same value as dedisp
+
+
 const std::string BYTES = "bytes";
 const std::string SAMPLES = "samples";
 const std::string SECONDS = "seconds";
@@ -3,6 +3,7 @@
 #include <memory>
 #include <cstring> 
 #include <vector>
+#include <stdexcept>
 
 namespace IO {
     class DataBufferBase;
@@ -60,6 +61,12 @@ namespace IO {
 
         virtual double getDoubleValueAt(std::size_t idx) = 0;   
 
+        /**
+         * @brief Retrieves the start of the underlying memory, whatever the element type. The memory of a
+         * DataBufferView is read-only.
+         */
+        virtual void *getData() = 0;
+
 
         template <typename DTYPE>
         void loadData(std::size_t startByte, std::shared_ptr<std::vector<DTYPE>> dataBuffer) {
@@ -141,6 +148,23 @@ namespace IO {
                 nBytes = 0;
             }
 
+            /**
+             * @brief Reuses the buffer for a new chunk, reallocating only if the new chunk is larger than any before.
+             *
+             * @param startByte The starting byte index of the new chunk.
+             * @param nBytes The number of bytes in the new chunk.
+             */
+            void resize(std::size_t startByte, std::size_t nBytes) {
+                if (buffer->size() < nBytes) buffer->resize(nBytes);
+                this->startByte = startByte;
+                this->nBytes = nBytes;
+                nElements = nBytes / sizeof(DTYPE);
+            }
+
+            void *getData() override {
+                return buffer->data();
+            }
+
             /**
              * @brief Retrieves the number of elements in the buffer.
              * 
@@ -164,5 +188,57 @@ namespace IO {
 
             
             
+    };
+
+    /**
+     * @brief Non-owning buffer that points at data held elsewhere, such as a memory-mapped file.
+     *
+     * The view keeps whatever owns the memory alive through a shared_ptr, but never copies or frees the data itself.
+     * getBuffer<DTYPE>() is not available on a view; use getData() instead.
+     */
+    template <class DTYPE>
+    class DataBufferView : public DataBufferBase
+    {
+            const DTYPE *data; /**< The first element of the view. */
+            std::size_t nElements; /**< The number of elements in the view. */
+            std::shared_ptr<const void> owner; /**< Keeps the memory behind data alive. */
+
+        public:
+            /**
+             * @brief Constructs a DataBufferView object.
+             *
+             * @param startByte The starting byte index of the buffer.
+             * @param nBytes The number of bytes in the buffer.
+             * @param data The first element of the data to view.
+             * @param owner The object owning the data.
+             */
+            DataBufferView(std::size_t startByte, std::size_t nBytes, const DTYPE *data, std::shared_ptr<const void> owner)
+                : DataBufferBase(startByte, nBytes), data(data), nElements(nBytes / sizeof(DTYPE)), owner(owner)
+            {
+            }
+
+            /**
+             * @brief Detaches the view from its data.
+             */
+            void clearBuffer() override {
+                data = nullptr;
+                owner.reset();
+                nElements = 0;
+                startByte = 0;
+                nBytes = 0;
+            }
+
+            int getNElements() override {
+                return nElements;
+            }
+
+            double getDoubleValueAt(std::size_t idx) override {
+                if (idx >= nElements) throw std::out_of_range("DataBufferView index out of range");
+                return static_cast<double>(data[idx]);
+            }
+
+            void *getData() override {
+                return const_cast<DTYPE *>(data);
+            }
     };
 };
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include "data/constants.hpp"
+
+namespace IO {
+
+    /**
+     * @brief A stretch of dedispersed samples of a contiguous range of DMs, as handed to a DedispersedConsumer.
+     *
+     * The samples of DM dmStart + i are getSeries(i)[0 .. nSamples), and are sample startSample onwards of that
+     * DM's time series. The data belong to the dedisperser and are only valid during the call to consume().
+     */
+    struct DedispersedBlock
+    {
+        const DEDISP_OUTPUT_TYPE *data; /**< nDMs time series of nSamples samples, one after the other. */
+        const float *dms;               /**< The nDMs DMs of the block. */
+        std::size_t dmStart;            /**< Index of the first DM of the block in the DM list. */
+        std::size_t nDMs;
+        std::size_t startSample;        /**< Index of the first sample in the dedispersed time series. */
+        std::size_t nSamples;
+
+        const DEDISP_OUTPUT_TYPE *getSeries(std::size_t iDM) const {
+            return data + iDM * nSamples;
+        }
+    };
+
+    /**
+     * @brief A downstream stage that takes dedispersed time series in memory instead of from disk.
+     *
+     * consume() runs on the writer threads of MultiTimeSeries. The blocks of one DM range arrive one at a time and in
+     * time order, while different DM ranges may be consumed concurrently. Consumers that need whole time series
+     * accumulate the blocks themselves.
+     */
+    class DedispersedConsumer
+    {
+    public:
+        virtual ~DedispersedConsumer() = default;
+
+        virtual void consume(const DedispersedBlock &block) = 0;
+
+        /**
+         * @brief Called once, after the last block has been consumed.
+         */
+        virtual void finish() {}
+    };
+
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include "data/search_mode_file.hpp"
+#include "data/constants.hpp"
+#include "data/quantisation.hpp"
+
+namespace IO {
+
+    /**
+     * @brief Fixed part of a DM-time cube header. The DM list follows it, then for data of fewer than 32 bits the offsets
+     * and scales of every DM (see QuantisationParams), and the data start at headerBytes.
+     */
+    struct DMTimeCubeHeader
+    {
+        char magic[8];
+        uint64_t headerBytes;
+        uint64_t nSamples;
+        uint64_t blockNSamples;
+        uint32_t nDMs;
+        uint32_t nBits;
+        int32_t telescopeId;
+        int32_t machineId;
+        uint32_t barycentric;
+        uint32_t reserved;
+        double tsamp;
+        double tstart;
+        double fch1;
+        double foff;
+        double srcRaj;
+        double srcDej;
+    };
+
+    /**
+     * @brief All dedispersed time series of a beam in a single file.
+     *
+     * The data are stored in time blocks of blockNSamples samples. Each block holds the samples of every DM one DM after
+     * the other, so a block is one contiguous read for searches that go through time, and one DM is nBlocks reads of
+     * blockNSamples samples each for searches that go through DMs. The last block holds only the remaining samples,
+     * again DM after DM. The data start on a page boundary so that the file can be memory-mapped with enableMemoryMap().
+     *
+     * With setOutputNBits() the samples are stored as 8 or 16 bit integers, with the offset and scale of every DM fitted
+     * to the first gulp appended; later samples outside those levels are clipped and counted. readDM() converts them
+     * back to floats; readTimeBlock() and readNBytes() give them as stored.
+     *
+     * In the SearchModeFile header, nchans is the number of DMs and a sample is one time step of every DM.
+     */
+    class DMTimeCube : public SearchModeFile
+    {
+        std::vector<float> dmList;
+        std::size_t blockNSamples;
+        std::size_t totalNSamples;
+        unsigned int outputNBits;
+        std::vector<QuantisationParams> quantParams; /**< One per DM, empty until fitted for quantised data. */
+
+        std::vector<DEDISP_OUTPUT_TYPE> blockData; /**< Block being filled by appendSamples(). */
+        std::vector<uint8_t> storedBlock; /**< Quantised or compacted copy of blockData, as written. */
+        std::size_t blockFill;
+        std::size_t nSamplesAppended;
+        std::size_t nSamplesClipped; /**< Quantised samples outside the fitted levels. */
+        bool finalised;
+
+        std::size_t getBlockOffset(std::size_t iBlock);
+        std::size_t getQuantisationOffset();
+        void fitAndWriteQuantisation(const DEDISP_OUTPUT_TYPE *gulp, std::size_t nSamples);
+        void writeBlock(std::size_t nSamplesInBlock);
+        void readRawBytes(std::size_t fileByte, std::size_t nBytes);
+        template <typename STORED_TYPE>
+        void readRawBytesOfType(std::size_t fileByte, std::size_t nBytes);
+
+    public:
+        static const char MAGIC[8];
+        static const std::size_t DEFAULT_BLOCK_NSAMPLES = 16384;
+        static const std::size_t DATA_ALIGNMENT = 4096;
+
+        DMTimeCube(std::string fileName, std::string mode);
+        ~DMTimeCube();
+
+        bool isHeaderSeparate();
+
+        void readHeader();
+        void writeHeader();
+
+        void readAllData();
+        void writeAllData();
+
+        /**
+         * @brief Reads nBytes of the data region as stored, i.e. in blocks. Served from the mapping if there is one.
+         */
+        void readNBytes(std::size_t startByte, std::size_t nBytes);
+        void writeNBytes();
+
+        void setDMList(const std::vector<float> &dmList);
+        void setTotalNSamples(std::size_t totalNSamples);
+        void setBlockNSamples(std::size_t blockNSamples);
+
+        /**
+         * @brief Stores the samples with 8, 16 or the default 32 bits. Must be called before writeHeader().
+         */
+        void setOutputNBits(unsigned int nBits);
+        unsigned int getOutputNBits() {
+            return outputNBits;
+        }
+        /**
+         * @brief The mapping from stored samples of DM iDM to floats; the identity for 32 bit data.
+         */
+        QuantisationParams getQuantisation(std::size_t iDM);
+
+        /**
+         * @brief The number of samples written so far that fell outside the quantisation levels and were clipped.
+         */
+        std::size_t getNSamplesClipped() {
+            return nSamplesClipped;
+        }
+
+        const std::vector<float> &getDMList() {
+            return dmList;
+        }
+        std::size_t getNDMs() {
+            return dmList.size();
+        }
+        std::size_t getBlockNSamples() {
+            return blockNSamples;
+        }
+        std::size_t getNBlocks();
+        std::size_t getBlockLength(std::size_t iBlock);
+
+        /**
+         * @brief Appends a gulp holding nSamples samples of every DM, laid out DM after DM.
+         */
+        void appendSamples(const DEDISP_OUTPUT_TYPE *gulp, std::size_t nSamples);
+
+        /**
+         * @brief Writes the last partial block and the final number of samples. Called by the destructor if needed.
+         */
+        void finalise();
+
+        /**
+         * @brief Reads nSamples samples of one DM, starting at startSample, as floats.
+         */
+        void readDM(std::size_t iDM, std::size_t startSample, std::size_t nSamples, DEDISP_OUTPUT_TYPE *out);
+
+        /**
+         * @brief Reads one time block into the container: getBlockLength(iBlock) samples of every DM, DM after DM.
+         * The container holds the samples as stored, i.e. uint8_t or uint16_t for quantised data.
+         */
+        void readTimeBlock(std::size_t iBlock);
+    };
+
+};
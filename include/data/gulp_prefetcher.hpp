@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include "data/search_mode_file.hpp"
+#include "data/data_buffer.hpp"
+
+namespace IO {
+
+    /**
+     * @brief Reads the gulps of a contiguous byte range ahead of time on a background thread.
+     *
+     * The prefetcher opens its own reader on the file, so its reads never move the file position of the caller's
+     * SearchModeFile. Up to nBuffers gulps are in flight at once: while the consumer works on one, the next ones are
+     * already loading. Buffers are recycled through release() and never reallocated after the first (largest) gulp; with
+     * CUDA they are also page-locked so that host-to-device copies of a gulp can use DMA.
+     */
+    class GulpPrefetcher
+    {
+        struct Gulp
+        {
+            std::size_t startByte;
+            std::size_t nBytes;
+        };
+
+        std::shared_ptr<SearchModeFile> reader;
+        std::vector<Gulp> gulps;
+        std::size_t nextGulp; /**< Index of the next gulp handed out by next(). */
+
+        std::deque<std::shared_ptr<DataBufferBase>> freeBuffers;
+        std::deque<std::shared_ptr<DataBufferBase>> readyBuffers; /**< Loaded gulps, in order. */
+        std::vector<void *> pinnedRegions;
+
+        std::mutex bufferMutex;
+        std::condition_variable bufferCondition;
+        bool stopping;
+        std::exception_ptr readError;
+        std::thread worker;
+
+        void readLoop();
+        void pin(const std::shared_ptr<DataBufferBase> &buffer);
+
+    public:
+        /**
+         * @brief Constructs a GulpPrefetcher object and starts reading.
+         *
+         * @param fileName The file to read.
+         * @param fileType The format of the file, as accepted by SearchModeFile::createInstance.
+         * @param startByte The first byte (after the header) of the range to read.
+         * @param nBytes The number of bytes in the range.
+         * @param gulpBytes The number of bytes in every gulp but the last.
+         * @param nBuffers The number of gulps that may be loaded, or in use, at the same time.
+         * @param nReadThreads The threads the reader may convert the data on, as for SearchModeFile::setNReadThreads.
+         */
+        GulpPrefetcher(std::string fileName, std::string fileType, std::size_t startByte, std::size_t nBytes,
+                       std::size_t gulpBytes, unsigned int nBuffers = 2, unsigned int nReadThreads = 0);
+        ~GulpPrefetcher();
+
+        GulpPrefetcher(const GulpPrefetcher &) = delete;
+        GulpPrefetcher &operator=(const GulpPrefetcher &) = delete;
+
+        /**
+         * @brief Waits for the next gulp to be loaded and hands it out.
+         *
+         * Gulps must be requested in the order they were scheduled. Any error raised while reading is rethrown here.
+         *
+         * @param startByte The first byte of the gulp the caller expects.
+         * @param nBytes The number of bytes the caller expects.
+         * @return The loaded gulp, to be given back with release() once the caller is done with it.
+         */
+        std::shared_ptr<DataBufferBase> next(std::size_t startByte, std::size_t nBytes);
+
+        /**
+         * @brief Gives a buffer handed out by next() back to the prefetcher, to be filled with a later gulp.
+         */
+        void release(std::shared_ptr<DataBufferBase> buffer);
+
+        bool isDone() {
+            return nextGulp == gulps.size();
+        }
+    };
+
+};
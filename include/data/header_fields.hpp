@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+namespace IO {
+
+    /**
+     * @brief The header values that the processing reads, as typed fields.
+     *
+     * SearchModeFile keeps one of these next to its map of header parameters and updates it whenever a known key is
+     * read or set, so that per-gulp code reads plain members instead of looking up and casting map entries. Which keys
+     * are known, and which field each of them goes to, is fixed at compile time by the tables of set(). The map still
+     * holds every key, for writing and printing headers and for the keys listed here only by name.
+     */
+    struct HeaderFields
+    {
+        int nChans = 0;
+        int nBits = 0;
+        int nIFs = 1;
+        long nSamples = 0;
+        double tsamp = 0.0;       /**< Sampling time in seconds. */
+        double tstart = 0.0;      /**< MJD of the first sample. */
+        double fch1 = 0.0;        /**< Frequency of the first channel in MHz. */
+        double foff = 0.0;        /**< Channel width in MHz, negative if the frequencies decrease. */
+        double bandwidth = 0.0;   /**< nChans * foff of the original filterbank, in MHz. */
+        double srcRaj = 0.0;      /**< Right ascension in sigproc hhmmss.s format. */
+        double srcDej = 0.0;      /**< Declination in sigproc ddmmss.s format. */
+        double refDM = 0.0;
+        int telescopeId = 0;
+        int machineId = 0;
+        int barycentric = 0;
+
+        /**
+         * @brief Stores value in the field of key, converted to its type. Returns false, and stores nothing, if key
+         * has no field.
+         */
+        bool set(const std::string &key, double value);
+    };
+
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+namespace IO {
+
+    /**
+     * @brief A sigproc header key and the dtype its value is stored as, one of those of data/constants.hpp.
+     */
+    struct HeaderKey
+    {
+        const char *key;
+        const char *dtype;
+    };
+
+    /**
+     * @brief Every key a sigproc header may hold. Compiled in, so that opening a file reads no table from disk and
+     * works from any working directory.
+     */
+    constexpr HeaderKey SIGPROC_HEADER_KEYS[] = {
+        {"HEADER_START", "null"},
+        {"HEADER_END", "null"},
+        {"rawdatafile", "null"},
+        {"source_name", "string"},
+        {"FREQUENCY_START", "float"},
+        {"FREQUENCY_END", "float"},
+        {"az_start", "float"},
+        {"za_start", "float"},
+        {"src_raj", "float"},
+        {"src_dej", "float"},
+        {"tstart", "float"},
+        {"tsamp", "float"},
+        {"period", "float"},
+        {"fch1", "float"},
+        {"fchannel", "float"},
+        {"foff", "float"},
+        {"nchans", "int"},
+        {"telescope_id", "int"},
+        {"machine_id", "int"},
+        {"data_type", "int"},
+        {"ibeam", "int"},
+        {"nbeams", "int"},
+        {"nbits", "int"},
+        {"barycentric", "int"},
+        {"pulsarcentric", "int"},
+        {"nbins", "int"},
+        {"nsamples", "long"},
+        {"nifs", "int"},
+        {"npuls", "int"},
+        {"refdm", "float"},
+    };
+
+};
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <memory_resource>
+#include <new>
+#include <utility>
 /**
  * @namespace IO
  * @brief Contains classes related to file types and header parameters.
@@ -15,7 +18,7 @@ namespace IO {
     {
     public:
         bool inheader; /**< Flag indicating if the parameter is present in the header of the data. */
-        std::string dtype; /**< Data type of the parameter. Specified in header_keys.dat */
+        std::string dtype; /**< Data type of the parameter. Specified in data/header_keys.hpp */
         std::string key; /**< Key associated with the parameter. */
 
 
@@ -80,7 +83,11 @@ namespace IO {
         virtual void print() = 0;
 
 
-        virtual HeaderParamBase* clone() = 0;
+        /**
+         * @brief Copies the parameter into memory from arena. The copy is destroyed by calling its destructor, not
+         * delete, and its memory is given back with the arena.
+         */
+        virtual HeaderParamBase* clone(std::pmr::memory_resource *arena) = 0;
 
         /**
          * @brief Destructor for the HeaderParamBase class.
@@ -103,7 +110,7 @@ namespace IO {
     {
 
     public:
-        T value;
+        T value{};
 
         /**
          * @brief Represents a header parameter.
@@ -187,12 +194,23 @@ namespace IO {
             return std::to_string(this->value).length();
         }
 
-        HeaderParamBase* clone(){
-            return new HeaderParam<T>(this);
+        HeaderParamBase* clone(std::pmr::memory_resource *arena){
+            void *memory = arena->allocate(sizeof(HeaderParam<T>), alignof(HeaderParam<T>));
+            return new (memory) HeaderParam<T>(this);
         }
         
 
     };
+
+    /**
+     * @brief Constructs a HeaderParam<T> from args in memory from arena, to be destroyed like a clone().
+     */
+    template <class T, typename... Args>
+    HeaderParam<T> *makeHeaderParam(std::pmr::memory_resource *arena, Args &&...args) {
+        void *memory = arena->allocate(sizeof(HeaderParam<T>), alignof(HeaderParam<T>));
+        return new (memory) HeaderParam<T>(std::forward<Args>(args)...);
+    }
+
     template <> 
     int HeaderParam<char*>::getValueLength();
 
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace IO {
+
+    /**
+     * @brief Read-only, shared memory mapping of a whole file.
+     *
+     * The mapping is backed by the page cache, so several processes mapping the same file share one copy of its pages.
+     * It stays valid for as long as the object lives; buffers that point into it hold a shared_ptr to keep it alive.
+     */
+    class MappedFile
+    {
+        int fd;
+        uint8_t *address;
+        std::size_t length;
+
+    public:
+        /**
+         * @brief Maps fileName into memory and hints the kernel that it will be read sequentially.
+         */
+        explicit MappedFile(std::string fileName);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        std::size_t getLength() const {
+            return length;
+        }
+
+        /**
+         * @brief Returns a pointer to nBytes of the file starting at startByte, and asks the kernel to start paging in
+         * the bytes that follow so that the next contiguous request finds them resident.
+         *
+         * @throws FileIOError if the range runs past the end of the file.
+         */
+        const uint8_t *getBytes(std::size_t startByte, std::size_t nBytes);
+
+        void adviseWillNeed(std::size_t startByte, std::size_t nBytes);
+    };
+
+};
@@ -3,15 +3,51 @@
 #include <memory>
 #include <string>
 #include <iostream>
+#include <future>
+#include <deque>
+#include <atomic>
 #include "data/search_mode_file.hpp"
+#include "data/dm_time_cube.hpp"
+#include "data/presto_timeseries.hpp"
+#include "data/quantisation.hpp"
+#include "data/dedispersed_consumer.hpp"
+#include "utils/thread_pool.hpp"
 namespace IO {
     class MultiTimeSeries {
         private:
             std::shared_ptr<std::vector<float>> dmList;
             std::vector<std::shared_ptr<SearchModeFile>> outFiles;
+            std::vector<std::shared_ptr<PrestoTimeSeries>> quantisedFiles; /**< outFiles as PRESTO files when outputNBits < 32. */
+            std::vector<QuantisationParams> quantParams; /**< Per DM, fitted to the first gulp written. */
+            std::atomic<std::size_t> nSamplesClipped{0}; /**< Quantised samples of later gulps outside those levels. */
+            std::shared_ptr<DMTimeCube> cubeFile; /**< Set instead of outFiles when all DMs go to a single DM-time cube. */
             std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> dedispersedData;
             std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> fullDedispersedData;
 
+            /**
+             * @brief A gulp handed to the writer threads, with the tasks still writing or consuming it.
+             */
+            struct GulpInFlight {
+                std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> data;
+                std::vector<std::shared_future<void>> tasks;
+            };
+
+            struct ConsumerEntry {
+                std::shared_ptr<DedispersedConsumer> consumer;
+                std::size_t dmsPerBlock;
+                std::vector<std::shared_future<void>> chains; /**< Last task of every DM block, so blocks stay in order. */
+            };
+
+            std::deque<GulpInFlight> gulpsInFlight;
+            std::vector<std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>>> spareBuffers; /**< Written gulps, reused for the next ones. */
+            std::vector<std::shared_future<void>> writeChains; /**< Last write of every block of output files. */
+            std::vector<ConsumerEntry> consumers;
+            std::size_t maxBufferedGulps;
+
+            std::unique_ptr<UTILS::ThreadPool> writerPool;
+            unsigned int nWriterThreads;
+            unsigned int outputNBits;
+
             std::size_t totalNSamples; 
             std::size_t gulpNSamples;  
             std::size_t nSamplesWritten;          
@@ -20,6 +56,7 @@ namespace IO {
             std::string outPrefix;
             std::string outSuffix;
             bool shouldWriteToFile;
+            bool hasOutputFiles;
 
         public:
             MultiTimeSeries(std::shared_ptr<std::vector<float>> dmList, std::size_t gulpNSamples, std::size_t totalNSamples, bool shouldWriteToFile);
@@ -28,12 +65,67 @@ namespace IO {
 
             void initOutputOptions(std::string outDir, std::string outPrefix, std::string outSuffix, std::string outputFormat, std::shared_ptr<IO::SearchModeFile> searchModeFile);
             std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> getCurrentDedispersedDataPtr();
-            void flush();
-            virtual ~MultiTimeSeries() = default;
+
+            /**
+             * @brief The whole dedispersed output, DM after DM, when it is kept in memory instead of written to file.
+             */
+            std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> getFullDedispersedData() {
+                return fullDedispersedData;
+            }
+            void setTotalNSamples(std::size_t totalNSamples);
+
+            /**
+             * @brief Sets the largest number of samples per DM a gulp holds. Must be called before the first flush().
+             */
+            void setGulpNSamples(std::size_t gulpNSamples);
+            void flush(std::size_t nSamplesOut);
+
+            /**
+             * @brief Sets how many threads write the per-DM files. Each thread owns a contiguous block of DMs.
+             */
+            void setNWriterThreads(unsigned int nWriterThreads);
+
+            /**
+             * @brief Stores the dedispersed samples with 8, 16 or the default 32 bits, scaled per DM. Only the PRESTO
+             * and DM-time cube formats support fewer than 32 bits. Must be called before initOutputOptions().
+             */
+            void setOutputNBits(unsigned int outputNBits);
+
+            /**
+             * @brief The number of quantised samples written so far that fell outside the levels fitted to the first
+             * gulp and were clipped. Only exact once waitForWrites() has returned.
+             */
+            std::size_t getNSamplesClipped();
+
+            /**
+             * @brief Hands every gulp to consumer as well, in blocks of dmsPerBlock DMs (0 splits the DMs evenly over
+             * the writer threads). Register consumers before the first flush().
+             */
+            void addConsumer(std::shared_ptr<DedispersedConsumer> consumer, std::size_t dmsPerBlock = 0);
+
+            /**
+             * @brief Sets how many gulps may wait for the writers and consumers at once. flush() blocks once that
+             * many are outstanding, which holds back the dedispersion until the slowest of them catches up.
+             */
+            void setMaxBufferedGulps(std::size_t maxBufferedGulps);
+
+            /**
+             * @brief Blocks until every gulp handed to flush() is on disk and consumed, and rethrows the first error.
+             */
+            void waitForWrites();
+
+            /**
+             * @brief Waits for all writes, completes the output files and finishes the consumers. Call once, after the
+             * last flush().
+             */
+            void finish();
+            virtual ~MultiTimeSeries();
 
 
         private:
-            void writeToFile();
+            void dispatchGulp(std::size_t nSamplesOut);
+            void submitInOrder(std::shared_future<void> &chain, GulpInFlight &gulp, std::function<void()> job);
+            void waitForOldestGulp();
 
             // DEDISP_OUTPUT_TYPE& operator()(std::size_t iDm, std::size_t iSample){
             //     return this->dedispersedData.get()[iDm * this->dmListSize + iSample];
@@ -1,9 +1,17 @@
+#pragma once
 #include "data/search_mode_file.hpp"
+#include "data/quantisation.hpp"
 
 namespace IO{
 
     typedef float PRESTO_DAT_TYPE;
 
+    /**
+     * @brief A PRESTO .dat time series with its .inf header.
+     *
+     * The samples are 32 bit floats as PRESTO expects, unless setQuantisation() asked for 8 or 16 bit integers. The
+     * mapping back to floats is then kept in the notes of the .inf file, and readNBytes() always gives floats.
+     */
     class PrestoTimeSeries : public SearchModeFile, DedispersedFile{
         public:
             PrestoTimeSeries(std::string fileName, std::string mode);
@@ -19,11 +27,29 @@ namespace IO{
             void readAllData();
             void writeAllData();
 
+            /**
+             * @brief Reads nBytes bytes of the .dat file, starting at startByte, into a container of floats.
+             */
             void readNBytes(std::size_t startByte, std::size_t nBytes); 
             void writeNBytes();
 
+            /**
+             * @brief Records that the samples are stored with nBits (8, 16 or 32) bits and rewrites the .inf file.
+             */
+            void setQuantisation(unsigned int nBits, const QuantisationParams &params);
+            unsigned int getStoredNBits() {
+                return storedNBits;
+            }
+            QuantisationParams getQuantisation() {
+                return quantisation;
+            }
+
         private:
-            void readInfLineValStr(std::ifstream& infofile, std::string& valstr, const std::string& errdesc);
+            unsigned int storedNBits = sizeof(PRESTO_DAT_TYPE) * BITS_PER_BYTE;
+            QuantisationParams quantisation;
+            std::vector<uint8_t> storedData; /**< Quantised samples read by readNBytes(). */
+
+            static bool splitInfLine(const std::string& line, std::string& description, std::string& valstr);
 
 
            
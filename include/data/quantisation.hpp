@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "exceptions.hpp"
+
+namespace IO {
+
+    /**
+     * @brief Linear mapping between stored integers and the float values they stand for: value = offset + scale * stored.
+     */
+    struct QuantisationParams
+    {
+        float offset = 0.0f;
+        float scale = 1.0f;
+    };
+
+    /**
+     * @brief Picks the mapping of one dedispersed time series from a stretch of its samples.
+     *
+     * The lowest level sits 4 sigma below the mean and one level is sigma / 8 for 8 bits or sigma / 1024 for 16 bits,
+     * leaving room for about 28 and 60 sigma above the mean with rounding noise of at most 4% of sigma. If the samples
+     * themselves reach further, the levels are widened so that none of them is clipped; only pulses later in the file
+     * that are stronger still are, and quantise() counts those.
+     */
+    inline QuantisationParams fitQuantisation(const float *data, std::size_t nSamples, unsigned int nBits) {
+        QuantisationParams params;
+        if (nSamples == 0) return params;
+
+        double sum = 0.0, sumSq = 0.0;
+        float minValue = data[0], maxValue = data[0];
+        for (std::size_t i = 0; i < nSamples; i++) {
+            sum += data[i];
+            sumSq += static_cast<double>(data[i]) * data[i];
+            minValue = std::min(minValue, data[i]);
+            maxValue = std::max(maxValue, data[i]);
+        }
+        double mean = sum / nSamples;
+        double sigma = std::sqrt(std::max(0.0, sumSq / nSamples - mean * mean));
+        if (sigma == 0.0) sigma = 1.0;
+
+        double maxLevel = nBits == 8 ? 255.0 : 65535.0;
+        double offset = std::min(mean - 4.0 * sigma, static_cast<double>(minValue));
+        double scale = std::max(sigma / (nBits == 8 ? 8.0 : 1024.0), (maxValue - offset) / maxLevel);
+        params.offset = static_cast<float>(offset);
+        params.scale = static_cast<float>(scale);
+        return params;
+    }
+
+    /**
+     * @brief Quantises nSamples floats into out. Returns the number of samples outside the levels, which are clipped.
+     */
+    template <typename QTYPE>
+    std::size_t quantise(const float *in, std::size_t nSamples, const QuantisationParams &params, QTYPE *out) {
+        const float maxLevel = static_cast<float>(std::numeric_limits<QTYPE>::max());
+        const float inverseScale = 1.0f / params.scale;
+        std::size_t nClipped = 0;
+        for (std::size_t i = 0; i < nSamples; i++) {
+            float level = std::nearbyint((in[i] - params.offset) * inverseScale);
+            nClipped += (level < 0.0f) | (level > maxLevel);
+            out[i] = static_cast<QTYPE>(std::min(std::max(level, 0.0f), maxLevel));
+        }
+        return nClipped;
+    }
+
+    template <typename QTYPE>
+    void dequantise(const QTYPE *in, std::size_t nSamples, const QuantisationParams &params, float *out) {
+        for (std::size_t i = 0; i < nSamples; i++) {
+            out[i] = params.offset + params.scale * static_cast<float>(in[i]);
+        }
+    }
+
+    /**
+     * @brief Quantises nSamples floats to nBits (8 or 16) into out, which is resized to hold them. Returns the number
+     * of clipped samples.
+     */
+    inline std::size_t quantiseToBytes(const float *in, std::size_t nSamples, unsigned int nBits, const QuantisationParams &params, std::vector<uint8_t> &out) {
+        out.resize(nSamples * nBits / 8);
+        if (nBits == 8) return quantise<uint8_t>(in, nSamples, params, out.data());
+        else if (nBits == 16) return quantise<uint16_t>(in, nSamples, params, reinterpret_cast<uint16_t *>(out.data()));
+        else throw InvalidInputs("Dedispersed output can only be quantised to 8 or 16 bits");
+    }
+
+    /**
+     * @brief Converts nSamples stored samples of nBits (8, 16 or 32) bits back to floats.
+     */
+    inline void dequantiseFromBytes(const void *in, std::size_t nSamples, unsigned int nBits, const QuantisationParams &params, float *out) {
+        if (nBits == 8) dequantise<uint8_t>(static_cast<const uint8_t *>(in), nSamples, params, out);
+        else if (nBits == 16) dequantise<uint16_t>(static_cast<const uint16_t *>(in), nSamples, params, out);
+        else std::copy(static_cast<const float *>(in), static_cast<const float *>(in) + nSamples, out);
+    }
+
+};
@@ -12,11 +12,15 @@
 #include <algorithm>
 #include "data/constants.hpp"
 #include "data/header_params.hpp"
+#include "data/header_fields.hpp"
 #include "data/data_buffer.hpp"
+#include "data/mapped_file.hpp"
 #include "exceptions.hpp"
 #include <variant>
 #include <memory>
 #include <map>
+#include <memory_resource>
+#include <type_traits>
 
 
 
@@ -49,7 +53,15 @@ namespace IO
             bool headerFileOpen = false;
             FILE *headerFile;
             std::size_t headerBytes;
-            std::map<std::string, HeaderParamBase *> headerParams;         //map of header params
+
+            /**
+             * Holds the map nodes and the parameters of headerParams, so that a file's header costs a single
+             * allocation however many keys it has. Memory is only given back when the file is destroyed.
+             */
+            static const std::size_t HEADER_ARENA_BYTES = 8192;
+            std::pmr::monotonic_buffer_resource headerArena{HEADER_ARENA_BYTES};
+            std::pmr::map<std::string, HeaderParamBase *> headerParams{&headerArena};         //map of header params
+            HeaderFields headerFields; /**< The known keys of headerParams as typed fields, kept in step with it. */
             std::string headerFileOpenMode;
 
             struct stat headerFileStat;
@@ -75,6 +87,8 @@ namespace IO
             std::size_t nBytesOnRam;
             std::size_t gulpSize;
             std::shared_ptr<DataBufferBase> container;
+            std::shared_ptr<MappedFile> mappedFile; /**< Set when reads are served from a memory mapping of the file. */
+            unsigned int nReadThreads = 0; /**< Threads a reader may convert the data it reads on (0 = all cores). */
         
 
             
@@ -119,6 +133,24 @@ namespace IO
 
             void clearBuffer();
 
+            /**
+             * @brief Serves later reads from a read-only memory mapping of the data file instead of copying them.
+             *
+             * Readers that support it then hand out DataBufferView containers pointing into the mapping.
+             */
+            void enableMemoryMap();
+            bool isMemoryMapped() const {
+                return mappedFile != nullptr;
+            }
+
+            /**
+             * @brief Limits the threads later reads convert the data on, e.g. unpack sub-byte samples, to nThreads
+             * (0 = all cores). Must be called before the first read.
+             */
+            void setNReadThreads(unsigned int nThreads) {
+                nReadThreads = nThreads;
+            }
+
 
             std::size_t samplesToBytes(std::size_t nSamples);
             std::size_t bytesToSamples(std::size_t nSamples);
@@ -134,6 +166,8 @@ namespace IO
                 this->container->loadData<DTYPE>(startByte, dataChunk);
             }
 
+            void writeRawBytes(const void *data, std::size_t nBytes);
+
             template <typename DTYPE>
             void writeNBytes(std::size_t startByte, std::shared_ptr<std::vector<DTYPE>> dataChunk) {
                 this->loadData<DTYPE>(startByte, dataChunk);
@@ -146,18 +180,28 @@ namespace IO
                 if(isParamInHeader(key)) {
                     HeaderParamBase *base = getHeaderParam(key);
                     static_cast<HeaderParam<T> *>(base)->value = value;
-    
+                    base->inheader = true;
                 }
                 else {
-                    HeaderParam<T> *param = new HeaderParam<T>(key, dtype, value);
-                    headerParams.insert(std::pair<std::string, HeaderParamBase *>(key, param));
+                    HeaderParam<T> *param = makeHeaderParam<T>(&headerArena, key, dtype, value);
+                    headerParams.emplace(key, param);
                 }
+                if constexpr (std::is_arithmetic_v<T>) headerFields.set(key, static_cast<double>(value));
+            }
+
+            /**
+             * @brief Adds a key stored as a float, keeping the full precision of value, e.g. of tstart, in its typed field.
+             */
+            void addFloatToHeader(const std::string key, double value) {
+                addToHeader<float>(key, FLOAT, static_cast<float>(value));
+                headerFields.set(key, value);
             }
 
             template<typename T>
             void updateHeaderValue(const std::string key, T value) {
                 HeaderParamBase *base = getHeaderParam(key);
                 if (base != NULL) static_cast<HeaderParam<T> *>(base)->value = value;
+                if constexpr (std::is_arithmetic_v<T>) headerFields.set(key, static_cast<double>(value));
             }
             
             template <typename T>
@@ -176,6 +220,7 @@ namespace IO
             inline void setValueForKey(const std::string key, T value){
                 HeaderParamBase *base = getHeaderParam(key);
                 if (base != NULL) static_cast<HeaderParam<T> *>(base)->value = value;
+                if constexpr (std::is_arithmetic_v<T>) headerFields.set(key, static_cast<double>(value));
             }
 
             // template <typename DTYPE>
@@ -215,11 +260,18 @@ namespace IO
                 return tsamp;
             }
 
+            /**
+             * @brief The typed header values. Prefer these to getValueForKey() outside of header I/O.
+             */
+            const HeaderFields &getHeaderFields() const {
+                return headerFields;
+            }
+
             virtual ~SearchModeFile()
             {
             
-            for (std::map<std::string, HeaderParamBase *>::iterator it = headerParams.begin(); it != headerParams.end(); ++it)
-                delete it->second;
+            for (auto it = headerParams.begin(); it != headerParams.end(); ++it)
+                it->second->~HeaderParamBase();
             
             if (headerFile)
                 fclose(headerFile);
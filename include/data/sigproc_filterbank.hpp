@@ -5,9 +5,13 @@
 #include "data/data_buffer.hpp"
 #include "exceptions.hpp"
 #include "utils/sigproc_utils.hpp"
+#include "utils/bit_unpack.hpp"
+#include "utils/thread_pool.hpp"
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <cstring>
 
 
 namespace IO
@@ -21,6 +25,8 @@ namespace IO
     public:
         bool verbose;
         std::size_t header_size;
+        std::vector<uint8_t> packedBuffer; /**< Raw bytes of the last sub-byte read, kept to avoid reallocating per gulp. */
+        std::unique_ptr<UTILS::ThreadPool> unpackPool; /**< nReadThreads threads for unpacking sub-byte data, created on first use. */
 
         void readHeaderKeys();
         bool isHeaderSeparate();
@@ -40,36 +46,46 @@ namespace IO
 
             this->nBytesOnDisk = nBytes;
             this->nBytesOnRam = this->nBytesOnDisk * BITS_PER_BYTE / this->nBits;
-            this->container = std::make_shared<DataBuffer<DTYPE>>(startByte, nBytesOnRam);
-          
-            
+            unsigned int nBits = this->nBits;
+
+            /* With a mapping, >= 8 bit data that are suitably aligned are handed out in place without any copy. */
+            const uint8_t *mapped = nullptr;
+            if (this->mappedFile) {
+                mapped = this->mappedFile->getBytes(startByte, nBytesOnDisk);
+                if (nBits >= 8 && reinterpret_cast<std::uintptr_t>(mapped) % alignof(DTYPE) == 0) {
+                    this->container = std::make_shared<DataBufferView<DTYPE>>(startByte, nBytesOnRam, reinterpret_cast<const DTYPE *>(mapped), this->mappedFile);
+                    return;
+                }
+            }
+
+            /* Reuse the previous gulp's buffer when it has the right type, so that streaming does not reallocate. */
+            std::shared_ptr<DataBuffer<DTYPE>> reusable = std::dynamic_pointer_cast<DataBuffer<DTYPE>>(this->container);
+            if (reusable) reusable->resize(startByte, nBytesOnRam);
+            else this->container = std::make_shared<DataBuffer<DTYPE>>(startByte, nBytesOnRam);
+
             std::shared_ptr<std::vector<DTYPE>> buffer = this->container->getBuffer<DTYPE>();
 
-            unsigned int nBits = this->nBits;
-            this->openDataFile();
-            this->goToByte(startByte);
+            if (!mapped) {
+                this->openDataFile();
+                this->goToByte(startByte);
+            }
 
             if (nBits >= 8) { // easy, just read the whole thing into buffer directly
-                readFromFileAndVerify<DTYPE>(this->dataFile, nBytesOnDisk, buffer->data());
+                if (mapped) std::memcpy(buffer->data(), mapped, nBytesOnDisk);
+                else readFromFileAndVerify<DTYPE>(this->dataFile, nBytesOnDisk / sizeof(DTYPE), buffer->data());
                 return;
             }
 
             else {
-                int bufferIdx = 0;
                 /* In this case, we read nBytesOnDisk from disk using temporary buffer, and convert to nBytesOnRam */
-                std::unique_ptr<std::vector<uint8_t>> tempBuffer = std::make_unique<std::vector<uint8_t>>(nBytesOnDisk);
-                readFromFileAndVerify<uint8_t>(this->dataFile, nBytesOnDisk,tempBuffer->data());
-
-                if (nBits < 8) { // eg: 2 bits
-                    for (int byte = 0; byte < nBytesOnDisk; byte++) { // for each byte
-                        for (int bitGroup = 0; bitGroup < BITS_PER_BYTE / nBits; bitGroup++) { 
-                            buffer->at(bufferIdx) = extractBitsFromByte(tempBuffer->at(byte), static_cast<uint8_t>(bitGroup * nBits), static_cast<uint8_t>((bitGroup + 1) * nBits)); 
-                            bufferIdx++;
-                        }
-                       
-                    }
+                const uint8_t *packed = mapped;
+                if (!packed) {
+                    if (packedBuffer.size() < nBytesOnDisk) packedBuffer.resize(nBytesOnDisk);
+                    readFromFileAndVerify<uint8_t>(this->dataFile, nBytesOnDisk, packedBuffer.data());
+                    packed = packedBuffer.data();
                 }
-                
+                if (!unpackPool) unpackPool = std::make_unique<UTILS::ThreadPool>(this->nReadThreads);
+                UTILS::unpackBits(packed, nBytesOnDisk, nBits, reinterpret_cast<uint8_t *>(buffer->data()), unpackPool.get());
             }
 
         }
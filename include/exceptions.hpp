@@ -1,10 +1,12 @@
 #pragma once
 #include <iostream>
 #include <sstream>
+#ifdef USE_CUDA
 #include "dedisp.h"
 #include "cuda.h"
 #include "cuda_runtime.h"
 #include "cufft.h"
+#endif
 #include <fstream>
 #include <execinfo.h>
 
@@ -87,6 +89,7 @@ class InvalidInputs : public CustomException
 */
 class ErrorChecker {
 public:
+#ifdef USE_CUDA
   static void check_dedisp_error(dedisp_error error, std::string function_name)
   {
     if (error != DEDISP_NO_ERROR) {
@@ -95,6 +98,7 @@ public:
       throw std::runtime_error(error_msg.str());
     }
   }
+#endif
   
   static void checkFileError(std::ifstream& infile, std::string fileName){
     if(!infile.good()) {
@@ -132,6 +136,7 @@ public:
     }
   }
 
+#ifdef USE_CUDA
   static void check_cuda_error(std::string msg="Unspecified location"){
     cudaDeviceSynchronize();
     cudaError_t error = cudaGetLastError();
@@ -144,6 +149,8 @@ public:
     }
   }
 
+#endif
+
   /*
   static void check_cuda_error(cudaError_t error){
     check_cuda_error(error,"");
@@ -154,7 +161,8 @@ public:
     throw std::runtime_error(msg.c_str());
   }
 
-  
+
+#ifdef USE_CUDA
   static void check_cufft_error(cufftResult error){
     if (error!=CUFFT_SUCCESS){
       std::stringstream error_msg;
@@ -205,6 +213,7 @@ public:
       throw std::runtime_error(error_msg.str());
     }
   }
+#endif
 
   static void print_stack_trace(unsigned int max_depth){
     int trace_depth;    
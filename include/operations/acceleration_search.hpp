@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include "operations/periodicity_search.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Periodicity search of binary pulsars by time-domain resampling over a grid of constant accelerations.
+     *
+     * A pulsar with line-of-sight acceleration a arrives at t + a t^2 / (2c), which smears its power over many Fourier
+     * bins. For each trial acceleration the time series is resampled as if observed in the pulsar's frame, out[i] =
+     * in[i + k * i * (i - N)] with k = a * tsamp / (2c), which moves no sample at either end of the N sample series
+     * and at most k N^2 / 4 samples in the middle. The grid step is the acceleration that shifts the middle by one
+     * sample, 8 c tsamp / T^2 for an observation of T seconds, so a signal is never more than half a sample off its
+     * best trial. Every resampled series is then searched like the plain one, with the FFT plan shared by all trials,
+     * and the DM and acceleration pairs are spread over the thread pool.
+     */
+    class AccelerationSearch : public PeriodicitySearch
+    {
+        std::vector<float> accelerations;
+
+        std::size_t getNTrials() const override {
+            return accelerations.size();
+        }
+
+        void searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t trial,
+                         std::vector<PeriodicityCandidate> &found) override;
+
+    public:
+        static const std::size_t RESAMPLE_BLOCK = 4096;
+
+        /**
+         * @brief Constructs an AccelerationSearch object.
+         *
+         * @param maxAcceleration The largest acceleration searched, in m/s^2. The grid runs from -maxAcceleration to
+         * +maxAcceleration and always includes 0.
+         */
+        AccelerationSearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                           const PeriodicitySearchOptions &options, float maxAcceleration);
+
+        const std::vector<float> &getAccelerations() const {
+            return accelerations;
+        }
+
+        /**
+         * @brief Resamples the first nSamples samples of in to out for acceleration (m/s^2), with nearest neighbours.
+         */
+        static void resample(const float *in, std::size_t nSamples, double tsamp, float acceleration, float *out);
+    };
+
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include "utils/thread_pool.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Per-channel statistics of one gulp of filterbank data.
+     */
+    struct BandpassStatistics
+    {
+        std::size_t startSample = 0; /**< First sample of the gulp in the file. */
+        std::size_t nSamples = 0;
+        std::vector<float> mean;
+        std::vector<float> rms;
+        std::vector<float> median;
+        std::vector<float> mad; /**< Median absolute deviation from the median. */
+
+        void resize(unsigned int nChans);
+
+        /**
+         * @brief The robust standard deviation of channel chan, 1.4826 * MAD, or the RMS where the MAD is 0.
+         */
+        float getSigma(unsigned int chan) const;
+    };
+
+    /**
+     * @brief Computes per-channel mean, RMS, median and MAD of time-major filterbank gulps in a single pass.
+     *
+     * 8 bit data go into a histogram per channel, from which every statistic follows; the median and MAD are
+     * interpolated within the histogram bins, so they stay meaningful for data unpacked from 1, 2 or 4 bits. 16 and 32
+     * bit data are summed a row of channels at a time, which the compiler vectorises, and the median and MAD are taken
+     * from up to MAX_ROBUST_SAMPLES rows spread evenly over the gulp. Channels are split over a thread pool.
+     */
+    class ChannelStatistics
+    {
+        unsigned int nChans;
+        std::unique_ptr<UTILS::ThreadPool> threadPool;
+
+        void computeFromHistograms(std::size_t nSamples, const uint8_t *data, BandpassStatistics &stats);
+
+        template <typename DTYPE>
+        void computeFromSums(std::size_t nSamples, const DTYPE *data, BandpassStatistics &stats);
+
+    public:
+        static const std::size_t MAX_ROBUST_SAMPLES = 4096;
+
+        ChannelStatistics(unsigned int nChans, unsigned int nThreads);
+
+        /**
+         * @brief Computes the statistics of nSamples time samples of inNBits (8, 16 or 32) bits per channel.
+         */
+        void compute(std::size_t nSamples, const uint8_t *data, unsigned int inNBits, BandpassStatistics &stats);
+
+        UTILS::ThreadPool *getThreadPool() {
+            return threadPool.get();
+        }
+    };
+
+    /**
+     * @brief Rescales every channel of each gulp to a common mean and standard deviation before dedispersion.
+     *
+     * Each gulp is normalised with its own median and robust sigma, so slow bandpass changes are followed. The data keep
+     * their word size: 8 bit samples are mapped to mean 64 and sigma 16, 16 bit samples to mean 16384 and sigma 1024,
+     * and 32 bit samples to mean 0 and sigma 1. Channels without any variation are set to the mean.
+     *
+     * The statistics of every gulp are stored in a bandpass file. When that file already exists, for the same number of
+     * channels and bits, the statistics are read from it and the statistics pass is skipped for every gulp it holds
+     * with the same first sample and length. Gulps depend on the memory plan, so as soon as one gulp is not in the file
+     * the file is written afresh with the gulps of this run, and the next run with the same plan reads all of them.
+     */
+    class BandpassNormaliser
+    {
+        struct BandpassFileHeader
+        {
+            char magic[8];
+            uint32_t nChans;
+            uint32_t nBits;
+        };
+
+        unsigned int nChans;
+        unsigned int nBits;
+        ChannelStatistics statistics;
+        BandpassStatistics current;
+        std::vector<float> gains;
+        std::vector<float> offsets;
+
+        std::string bandpassFileName;
+        std::map<std::size_t, BandpassStatistics> storedStatistics; /**< Read from the bandpass file, by startSample. */
+        std::vector<std::size_t> reusedStarts; /**< Gulps served from storedStatistics before the file is rewritten. */
+        FILE *bandpassFile; /**< Open for writing once a gulp is not in the file. */
+
+        void readBandpassFile();
+        void appendToBandpassFile(const BandpassStatistics &stats);
+
+        template <typename DTYPE>
+        void normaliseOfType(std::size_t nSamples, const DTYPE *in, DTYPE *out, float maxValue);
+
+    public:
+        static const char MAGIC[8];
+
+        /**
+         * @brief Constructs a BandpassNormaliser object.
+         *
+         * @param nChans The number of channels.
+         * @param nBits The number of bits per sample of the data to normalise (8, 16 or 32).
+         * @param bandpassFileName The bandpass file to read the statistics from or write them to. Empty to do neither.
+         * @param nThreads The number of threads (0 = all cores).
+         */
+        BandpassNormaliser(unsigned int nChans, unsigned int nBits, std::string bandpassFileName, unsigned int nThreads);
+        ~BandpassNormaliser();
+
+        BandpassNormaliser(const BandpassNormaliser &) = delete;
+        BandpassNormaliser &operator=(const BandpassNormaliser &) = delete;
+
+        /**
+         * @brief Normalises nSamples samples starting at sample startSample of the file from in to out.
+         */
+        void normalise(std::size_t startSample, std::size_t nSamples, const uint8_t *in, uint8_t *out);
+
+        /**
+         * @brief The statistics the last gulp was normalised with.
+         */
+        const BandpassStatistics &getStatistics() {
+            return current;
+        }
+
+        /**
+         * @brief Whether the statistics come from an existing bandpass file.
+         */
+        bool isReadingBandpassFile() {
+            return !storedStatistics.empty();
+        }
+    };
+
+};
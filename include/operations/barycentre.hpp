@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace OPS {
+
+    /**
+     * @brief The position of the Earth relative to the solar system barycentre at one epoch.
+     */
+    struct EphemerisPoint
+    {
+        double mjd;        /**< Epoch as an MJD. */
+        double position[3]; /**< Equatorial (ICRS) x, y and z in light-seconds. */
+    };
+
+    /**
+     * @brief Maps topocentric time series onto a uniform barycentric time grid by adding and dropping samples.
+     *
+     * The Roemer delay r . n of the source direction n is computed once per observation, from the Earth positions of
+     * a tabulated ephemeris interpolated with 4-point Lagrange polynomials, on a grid of GRID_SECONDS steps. The drift
+     * d(i) of sample i against the barycentric grid, in samples, is linear between grid points, so every crossing of
+     * a half-integer level of d is found directly: a rising crossing at sample i means the barycentric series needs
+     * sample i twice, a falling one that it needs it not at all. These events depend on the observation only, so one
+     * sorted table of them is shared by every DM trial, and barycentring a time series is a copy of the runs between
+     * events, the same cost as appending it unchanged.
+     */
+    class Barycentre
+    {
+        /**
+         * @brief A sample that is repeated (add) or skipped (drop) in the barycentric series.
+         */
+        struct Event
+        {
+            std::size_t sample;
+            bool add;
+        };
+
+        std::size_t totalNSamples;
+        std::vector<Event> events; /**< In sample order. */
+        std::size_t nAdded = 0;
+        std::size_t nDropped = 0;
+
+        /**
+         * @brief The Earth position at mjd, in light-seconds.
+         */
+        static void interpolate(const std::vector<EphemerisPoint> &ephemeris, double mjd, double position[3]);
+
+    public:
+        static constexpr double GRID_SECONDS = 10.0;
+
+        /**
+         * @brief Constructs a Barycentre object and its table of added and dropped samples.
+         *
+         * @param ephemeris The Earth positions, in time order, covering the observation with a point to spare at each end.
+         * @param raj The right ascension of the source, in sigproc hhmmss.s format.
+         * @param decj The declination of the source, in sigproc ddmmss.s format.
+         * @param tstart The MJD of the first sample.
+         * @param tsamp The sampling time in seconds.
+         * @param totalNSamples The number of samples of every topocentric time series.
+         */
+        Barycentre(const std::vector<EphemerisPoint> &ephemeris, double raj, double decj, double tstart, double tsamp,
+                   std::size_t totalNSamples);
+
+        /**
+         * @brief Appends the barycentric version of in, samples startSample .. startSample + nSamples - 1 of a time
+         * series, to out. Calls for one series must come in sample order. Safe to call from several threads at once.
+         */
+        void append(const float *in, std::size_t startSample, std::size_t nSamples, std::vector<float> &out) const;
+
+        /**
+         * @brief The number of samples a barycentred series of totalNSamples samples has.
+         */
+        std::size_t getNOutputSamples() const {
+            return totalNSamples + nAdded - nDropped;
+        }
+
+        std::size_t getNAdded() const {
+            return nAdded;
+        }
+
+        std::size_t getNDropped() const {
+            return nDropped;
+        }
+
+        /**
+         * @brief Reads an ephemeris from a text file with the MJD and the x, y and z of the Earth relative to the
+         * solar system barycentre in light-seconds on every line. Lines starting with # are skipped.
+         */
+        static std::vector<EphemerisPoint> readEphemeris(const std::string &fileName);
+    };
+
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include "data/candidate_table.hpp"
+#include "operations/periodicity_search.hpp"
+#include "operations/single_pulse_search.hpp"
+
+namespace OPS {
+
+    struct SiftingOptions
+    {
+        float dmLink = 2.0f;             /**< Largest distance between friends in DM trials. */
+        float sampleLink = 64.0f;        /**< Largest distance between the centres of friendly single pulses, in samples. */
+        float frequencyLink = 1.0f;      /**< Largest distance between friendly periodicity candidates, in Fourier bins. */
+        unsigned int maxHarmonicRatio = 16; /**< Clusters at p / q times a stronger one's frequency, p, q <= this, are merged. */
+    };
+
+    /**
+     * @brief Groups the raw detections of the searches into clusters and keeps the strongest of each.
+     *
+     * Clusters are found with friends-of-friends: two detections are friends if they are within the link lengths in
+     * both coordinates, and a cluster is every detection reachable through friends. The detections are hashed into
+     * cells of the link lengths, so only the detections of neighbouring cells are ever compared and sifting stays
+     * close to linear in the number of detections. Single pulses are linked in DM and time. Periodicity candidates
+     * are linked in DM and frequency, whatever their acceleration, and every cluster weaker than one at a
+     * harmonically related frequency, at any DM, is then merged into it.
+     */
+    class CandidateSifter
+    {
+        SiftingOptions options;
+        std::vector<float> dmList;
+
+        /**
+         * @brief The position of dm in the DM list, interpolated between trials.
+         */
+        double dmTrial(float dm) const;
+
+    public:
+        /**
+         * @brief Constructs a CandidateSifter object.
+         *
+         * @param dmList The DMs of the trials, in increasing order, as given to the Dedisperser.
+         */
+        CandidateSifter(const std::vector<float> &dmList, const SiftingOptions &options);
+
+        /**
+         * @brief The strongest event of every cluster of single pulses, strongest first.
+         */
+        std::vector<IO::SinglePulseRecord> sift(const std::vector<SinglePulseEvent> &events) const;
+
+        /**
+         * @brief The strongest candidate of every cluster of periodicity candidates not related to a stronger one,
+         * strongest first.
+         *
+         * @param observationLength The length of the searched time series in seconds, which sets the Fourier bin.
+         */
+        std::vector<IO::PeriodicityRecord> sift(const std::vector<PeriodicityCandidate> &candidates, double observationLength) const;
+
+        /**
+         * @brief Friends-of-friends clustering of points (x[i], y[i]) linked within linkX in x and linkY in y.
+         *
+         * @return The cluster of every point, numbered from 0 in order of the first point of each cluster.
+         */
+        static std::vector<std::size_t> friendsOfFriends(const std::vector<double> &x, const std::vector<double> &y,
+                                                         double linkX, double linkY);
+    };
+
+};
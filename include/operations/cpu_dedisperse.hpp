@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "operations/dedispersion_backend.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Multithreaded brute-force dedispersion on the CPU.
+     *
+     * Each gulp is first transposed to channel-major order so that, for a given DM, every channel contributes a
+     * contiguous run of samples. The inner accumulation loop is then a unit-stride add over a block of output samples
+     * that the compiler vectorises, and DMs are spread over a thread pool.
+     */
+    class CPUDedisperser : public DedispersionBackend
+    {
+    protected:
+        std::unique_ptr<UTILS::ThreadPool> threadPool;
+        std::vector<uint8_t> transposedData; /**< Channel-major copy of the current gulp, reused across gulps. */
+
+        template <typename DTYPE>
+        void transpose(std::size_t nSamplesIn, const DTYPE *inData, DTYPE *outData);
+
+        template <typename DTYPE>
+        DTYPE *transposeGulp(std::size_t nSamplesIn, const DTYPE *inData);
+
+    private:
+        template <typename DTYPE>
+        void dedisperseTransposed(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData);
+
+        template <typename DTYPE>
+        void executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData);
+
+    public:
+        static const std::size_t SAMPLES_PER_BLOCK = 4096; /**< Output samples accumulated at once, sized to stay in L1/L2. */
+
+        CPUDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads);
+
+        std::string getName() {
+            return "cpu";
+        }
+
+        void execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData);
+
+        /**
+         * @brief The transposed copy of the gulp, and a block accumulator per thread.
+         */
+        BackendMemory getWorkingMemory(unsigned int inNBits);
+    };
+
+};
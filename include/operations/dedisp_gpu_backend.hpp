@@ -0,0 +1,38 @@
+#pragma once
+#ifdef USE_CUDA
+#include "dedisp.h"
+#include "operations/dedispersion_backend.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Dedispersion on the GPU through the dedisp library.
+     */
+    class DedispGPUBackend : public DedispersionBackend
+    {
+        dedisp_plan plan;
+
+    public:
+        /**
+         * @brief Constructs a DedispGPUBackend object on the current device.
+         *
+         * @param numGpus The number of GPUs asked for. Throws InvalidInputs if more than one, which is not supported.
+         */
+        DedispGPUBackend(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int numGpus);
+
+        virtual ~DedispGPUBackend()
+        {
+            dedisp_destroy_plan(plan);
+        }
+
+        std::string getName() {
+            return "gpu";
+        }
+
+        void setDMList(const std::vector<float> &dmList);
+        void setKillMask(const std::vector<DEDISP_BOOL> &killmask);
+        void execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData);
+    };
+
+};
+#endif
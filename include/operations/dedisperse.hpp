@@ -1,5 +1,4 @@
 #pragma once
-#include "dedisp.h"
 #include <cstdlib>
 #include <vector>
 #include <string>
@@ -9,6 +8,11 @@
 #include "data/search_mode_file.hpp"
 #include "data/multi_timeseries.hpp"
 #include "data/data_buffer.hpp"
+#include "data/gulp_prefetcher.hpp"
+#include "operations/dedispersion_backend.hpp"
+#include "operations/bandpass.hpp"
+#include "operations/rfi_flagger.hpp"
+#include "operations/zero_dm_filter.hpp"
 #include <type_traits>
 #include <memory>
 
@@ -19,8 +23,7 @@ namespace OPS {
 
     class Dedisperser
     {
-        dedisp_plan plan;
-        unsigned int numGpus;
+        std::unique_ptr<DedispersionBackend> backend;
 
         std::shared_ptr<IO::SearchModeFile> searchModeFile;
 
@@ -34,7 +37,17 @@ namespace OPS {
         bool gulping;
         std::size_t gulpNSamples;
 
-        
+        std::vector<uint8_t> overlapBuffer; /**< Last maxDelaySamples input samples of the previous gulp, followed by the current gulp. */
+        std::size_t nOverlapSamples; /**< Number of samples carried over from the previous gulp. */
+        std::size_t streamEndByte; /**< One past the last byte of the previous gulp. */
+
+        std::shared_ptr<IO::GulpPrefetcher> prefetcher; /**< Source of gulps read ahead in the background, if set. */
+        std::shared_ptr<BandpassNormaliser> normaliser; /**< Rescales the channels of every gulp before dedispersion, if set. */
+        std::shared_ptr<RFIFlagger> rfiFlagger; /**< Masks the channels hit by RFI in every gulp, if set. */
+        std::shared_ptr<ZeroDMFilter> zeroDMFilter; /**< Removes broadband RFI from every gulp, if set. */
+        std::vector<DEDISP_BOOL> gulpKillmask; /**< killmask combined with the RFI flags, as last given to the backend. */
+
+        void setGulpSize(std::size_t gulpNSamples);
 
     public:
     
@@ -43,16 +56,22 @@ namespace OPS {
                         double tSamp, double f0, double channelBW, int nChans);
 
     public:
-        Dedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int numGpus, std::shared_ptr<std::vector<float>> dmList, bool writeToFile, std::size_t gulpNSamples);
+        /**
+         * @brief Constructs a Dedisperser object.
+         *
+         * @param searchModeFile The file to dedisperse.
+         * @param options Which dedispersion engine to use and how to configure it.
+         * @param dmList The DMs to dedisperse to.
+         * @param writeToFile Whether the dedispersed time series are written to disk.
+         * @param gulpNSamples The number of samples to dedisperse at a time. 0 dedisperses the whole file at once.
+         */
+        Dedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, const DedispersionOptions &options, std::shared_ptr<std::vector<float>> dmList, bool writeToFile, std::size_t gulpNSamples);
 
 
        void setOutputOptions(std::string outputDir, std::string outputPrefix, std::string outputSuffix, 
                        std::string outputFormat, std::shared_ptr<IO::SearchModeFile> searchModeFile);
 
-        virtual ~Dedisperser()
-        {
-            dedisp_destroy_plan(plan);
-        }
+        virtual ~Dedisperser() = default;
 
         std::shared_ptr<std::vector<float>> getDMList()
         {
@@ -61,6 +80,14 @@ namespace OPS {
         std::size_t getMaxDelaySamples(){
             return maxDelaySamples;
         }   
+        std::string getBackendName(){
+            return backend->getName();
+        }
+
+        /**
+         * @brief The host memory the backend works in, for the input words it is given. Only valid once the DM list is set.
+         */
+        BackendMemory getBackendMemory();
 
         void setDMList(std::shared_ptr<std::vector<float>> dmList);
         void setKillMask(std::shared_ptr<std::vector<int>> killmask_in);
@@ -69,53 +96,84 @@ namespace OPS {
         // void dedisperse(IO::SearchModeFile *search_file, DEDISP_OUTPUT_TYPE *out_data);
         // void dedisperse(DEDISP_BYTE* input_data, DEDISP_OUTPUT_TYPE* out_data);
 
-        void dedisperse(std::size_t startByte, std::size_t nBytesToRead){
-
-
-            searchModeFile->readNBytes(startByte, nBytesToRead);
-
-
-            std::size_t nSamplesIn = searchModeFile->bytesToSamples(nBytesToRead);
-            std::size_t nSamplesOut = nSamplesIn - maxDelaySamples;
-
-
-            std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> dedispersedData = multiTimeSeries->getCurrentDedispersedDataPtr();
-
-
-            dedisp_error error;
-            switch (searchModeFile->getValueForKey<int>(NBITS)) // check and shorten this to reinterpret_cast on getting buffer.. 
-            {
-                case 1:
-                case 2:
-                case 4:
-                case 8:
-                {
-                    std::shared_ptr<std::vector<uint8_t>> inBuffer = searchModeFile->container->getBuffer<uint8_t>();
-                    error = dedisp_execute(this->plan, nSamplesIn, inBuffer->data(), 8, reinterpret_cast<uint8_t*>(dedispersedData->data()),  32, (unsigned) 0);
-                    break;
-                }
-                case 16:
-                {
-                    std::shared_ptr<std::vector<short>> inBuffer = searchModeFile->container->getBuffer<short>();
-                    error = dedisp_execute(plan, nSamplesIn, reinterpret_cast<uint8_t*>(inBuffer->data()), 16, reinterpret_cast<uint8_t*>(dedispersedData->data()),  32, (unsigned) 0);
-                    break;
-                }
-                case 32:
-                {
-                    std::shared_ptr<std::vector<int>> inBuffer = searchModeFile->container->getBuffer<int>();
-                    error = dedisp_execute(plan, nSamplesIn, reinterpret_cast<uint8_t*>(inBuffer->data()), 32, reinterpret_cast<uint8_t*>(dedispersedData->data()),  32, (unsigned) 0);
-                    break;
-                }
-                default:
-                    break;
-            }
-            ErrorChecker::check_dedisp_error(error,"execute");
-            multiTimeSeries->flush();
-
-        }
-        
-
-
+        void setNSamplesToProcess(std::size_t nSamples);
+
+        /**
+         * @brief Changes the number of samples dedispersed at a time, e.g. to the one a MemoryPlanner chose. 0
+         * dedisperses the whole file at once. Must be called before the first dedisperse().
+         */
+        void setGulpNSamples(std::size_t gulpNSamples);
+        void resetOverlap();
+
+        /**
+         * @brief Takes gulps from a prefetcher instead of reading them on demand. Pass nullptr to read on demand again.
+         *
+         * The prefetcher must have been scheduled with the same gulps, in the same order, as the calls to dedisperse().
+         */
+        void setPrefetcher(std::shared_ptr<IO::GulpPrefetcher> prefetcher);
+
+        /**
+         * @brief Normalises the channels of every new gulp before it is dedispersed. Pass nullptr to stop normalising.
+         */
+        void setNormaliser(std::shared_ptr<BandpassNormaliser> normaliser);
+
+        /**
+         * @brief Flags RFI in every new gulp and dedisperses it with those channels masked as well as the killmask.
+         * Pass nullptr to go back to the killmask alone.
+         */
+        void setRFIFlagger(std::shared_ptr<RFIFlagger> rfiFlagger);
+
+        /**
+         * @brief Zero-DM filters and clips every new gulp, after normalisation and over the unmasked channels, before
+         * it is dedispersed. Pass nullptr to stop filtering.
+         */
+        void setZeroDMFilter(std::shared_ptr<ZeroDMFilter> zeroDMFilter);
+
+        /**
+         * @brief Sets the number of bits per written output sample (8, 16 or 32). Call before setOutputOptions().
+         */
+        void setOutputNBits(unsigned int outputNBits);
+
+        /**
+         * @brief The number of 8 or 16 bit output samples clipped because they fell outside the levels fitted to the
+         * first gulp. Call after finish().
+         */
+        std::size_t getNOutputSamplesClipped();
+
+        /**
+         * @brief Sets how many threads write the dedispersed time series to disk.
+         */
+        void setNWriterThreads(unsigned int nWriterThreads);
+
+        /**
+         * @brief Hands the dedispersed time series of every gulp to consumer in memory, in blocks of dmsPerBlock DMs
+         * (0 = one block per writer thread). With the "none" output format nothing is written to disk.
+         */
+        void addConsumer(std::shared_ptr<IO::DedispersedConsumer> consumer, std::size_t dmsPerBlock = 0);
+
+        /**
+         * @brief Sets how many dedispersed gulps may wait for the writers and consumers before dedisperse() blocks.
+         */
+        void setMaxBufferedGulps(std::size_t maxBufferedGulps);
+
+        /**
+         * @brief Waits until all dedispersed output is written. Call after the last dedisperse() to see write errors.
+         */
+        void finish();
+
+        /**
+         * @brief Reads and dedisperses the next gulp of a contiguous stream.
+         *
+         * The last maxDelaySamples input samples of every gulp are kept and prepended to the next one, so consecutive calls
+         * over contiguous byte ranges produce contiguous output without re-reading any data. Each call writes
+         * nOverlap + nNew - maxDelaySamples samples per DM. Call resetOverlap() before jumping to an unrelated byte range.
+         * When the file is memory-mapped the carried-over samples are re-read from the mapping in place instead of copied.
+         *
+         * @param startByte The first byte (after the header) of the new gulp.
+         * @param nBytesToRead The number of bytes in the new gulp.
+         * @return The number of output samples produced per DM.
+         */
+        std::size_t dedisperse(std::size_t startByte, std::size_t nBytesToRead);
 
     };
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include "data/constants.hpp"
+#include "data/search_mode_file.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Runtime options used to pick and configure a dedispersion backend.
+     */
+    struct DedispersionOptions
+    {
+        std::string backendName = ""; /**< gpu, cpu, subband or fdmt. Empty selects the default for this build. */
+        unsigned int nWorkers = 0; /**< GPUs for the gpu backend (at most 1), else CPU threads (0 = all cores). */
+        unsigned int nSubbands = 0; /**< Number of subbands for the subband backend (0 = about sqrt(nChans)). */
+        float subbandSmearing = 1.0f; /**< Extra smearing in samples the subband backend may add to any DM trial. */
+    };
+
+    /**
+     * @brief Host memory a backend works in besides its input and output: bytesPerSample for every input sample of a
+     * gulp, plus fixedBytes whatever the gulp.
+     */
+    struct BackendMemory
+    {
+        std::size_t bytesPerSample = 0;
+        std::size_t fixedBytes = 0;
+    };
+
+    /**
+     * @brief Base class for dedispersion engines.
+     *
+     * A backend turns a gulp of time-major filterbank data (all channels of sample 0, then sample 1, ...) into
+     * nDMs contiguous time series of nSamplesIn - maxDelaySamples samples each, i.e. the same layout dedisp_execute produces.
+     * Backends are chosen at runtime by name through createInstance, in the same way SearchModeFile picks a file format.
+     */
+    class DedispersionBackend
+    {
+    protected:
+        unsigned int nChans;
+        float tsamp;
+        float fch1;
+        float foff;
+
+        std::vector<float> dmList;
+        std::vector<DEDISP_BOOL> killmask;
+        std::vector<float> delayTable; /**< Delay of each channel in samples per unit DM, relative to the top of the band. */
+        std::size_t maxDelaySamples;
+
+        void generateDelayTable();
+
+    public:
+        static std::unique_ptr<DedispersionBackend> createInstance(const DedispersionOptions &options, std::shared_ptr<IO::SearchModeFile> searchModeFile);
+        static std::string defaultBackendName();
+
+        DedispersionBackend(std::shared_ptr<IO::SearchModeFile> searchModeFile);
+        virtual ~DedispersionBackend() = default;
+
+        virtual std::string getName() = 0;
+
+        virtual void setDMList(const std::vector<float> &dmList);
+        virtual void setKillMask(const std::vector<DEDISP_BOOL> &killmask);
+
+        /**
+         * @brief Dedisperses one gulp.
+         *
+         * @param nSamplesIn The number of time samples in inData. Must be larger than getMaxDelaySamples().
+         * @param inData Time-major input data, one word of inNBits per channel per sample.
+         * @param inNBits The number of bits per input word (8, 16 or 32).
+         * @param outData Output of nDMs * (nSamplesIn - getMaxDelaySamples()) samples, DM-major.
+         */
+        virtual void execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData) = 0;
+
+        /**
+         * @brief The host memory execute() works in for input words of inNBits bits, for the MemoryPlanner. Only valid
+         * once the DM list is set. Backends that keep nothing on the host besides their input and output use none.
+         */
+        virtual BackendMemory getWorkingMemory([[maybe_unused]] unsigned int inNBits) {
+            return BackendMemory{};
+        }
+
+        std::size_t getMaxDelaySamples() {
+            return maxDelaySamples;
+        }
+
+        float getDelayPerDM(unsigned int chan) {
+            return delayTable[chan];
+        }
+
+        std::size_t getDelaySamples(float dm, unsigned int chan) {
+            return static_cast<std::size_t>(dm * delayTable[chan] + 0.5f);
+        }
+
+        const std::vector<float> &getDMList() {
+            return dmList;
+        }
+    };
+
+};
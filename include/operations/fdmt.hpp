@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "operations/cpu_dedisperse.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Fast Dispersion Measure Transform (Zackay & Ofek 2017) on the CPU.
+     *
+     * Channels start as single-channel subbands holding, for every delay across the channel, the mean of the samples
+     * that delay spans. Adjacent subbands are then merged pairwise, log2(nChans) times, so that each merged delay row is
+     * the sum of one row of the upper half and one time-shifted row of the lower half. The last iteration holds the full
+     * DM-time plane at every integer delay across the band, in O(nSamples * nChans * log2(nChans)) operations. Each DM in
+     * the list is then given the row whose band-crossing delay is nearest to its own.
+     */
+    class FDMTDedisperser : public CPUDedisperser
+    {
+        /**
+         * @brief One frequency range of an FDMT iteration, with a row of nSamplesIn samples for every delay 0..maxDelay.
+         */
+        struct FDMTSubband
+        {
+            double fHigh;
+            double fLow;
+            std::size_t maxDelay;
+            std::vector<float> rows;
+        };
+
+        std::vector<std::size_t> dmRows; /**< Row of the final DM-time plane used for each DM in dmList. */
+        std::size_t maxFDMTDelay;
+        float maxDM; /**< The largest DM in dmList. */
+
+        double getBandDelayPerDM(double fLow, double fHigh);
+
+        /**
+         * @brief The largest delay in samples across fLow .. fHigh of any DM in dmList.
+         */
+        std::size_t getSubbandMaxDelay(double fLow, double fHigh);
+
+        /**
+         * @brief The most delay rows, over all subbands, held at once: those of one iteration and of the next while
+         * they are merged.
+         */
+        std::size_t getPeakRows();
+
+        template <typename DTYPE>
+        void initialise(std::size_t nSamplesIn, const DTYPE *transposed, std::vector<FDMTSubband> &subbands);
+
+        void merge(std::size_t nSamplesIn, std::vector<FDMTSubband> &subbands, std::vector<FDMTSubband> &merged);
+
+        template <typename DTYPE>
+        void executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData);
+
+    public:
+        FDMTDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads);
+
+        std::string getName() {
+            return "fdmt";
+        }
+
+        void setDMList(const std::vector<float> &dmList);
+        void execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData);
+
+        /**
+         * @brief The transposed copy of the gulp, the rows of two iterations and a running sum per thread, all of
+         * nSamplesIn samples.
+         */
+        BackendMemory getWorkingMemory(unsigned int inNBits);
+    };
+
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <complex>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace OPS {
+
+    typedef std::complex<float> FFT_COMPLEX_TYPE;
+
+    /**
+     * @brief A complex FFT of a fixed length whose only prime factors are 2, 3 and 5.
+     *
+     * The transform is a self-sorting (Stockham) decimation in frequency: every radix-4, 2, 3 or 5 pass reads one buffer
+     * and writes the other, so no bit reversal is needed, and the twiddles of all passes are computed once, in double
+     * precision, when the plan is made. A plan is never modified after construction and can be used by any number of
+     * threads at once, each with its own work buffer.
+     */
+    class ComplexFFT
+    {
+        struct Pass
+        {
+            unsigned int radix;
+            std::size_t length;                  /**< Length of the sub-transforms this pass splits. */
+            std::size_t stride;                  /**< Number of interleaved sub-transforms. */
+            std::vector<FFT_COMPLEX_TYPE> twiddles; /**< (radix - 1) twiddles for every butterfly of a sub-transform. */
+        };
+
+        std::size_t length;
+        std::vector<Pass> passes;
+
+        static void runPass(const Pass &pass, const FFT_COMPLEX_TYPE *in, FFT_COMPLEX_TYPE *out);
+
+    public:
+        explicit ComplexFFT(std::size_t length);
+
+        std::size_t getLength() const {
+            return length;
+        }
+
+        /**
+         * @brief Transforms data in place, with the exp(-2 pi i k t / n) convention and no scaling.
+         *
+         * @param work A buffer of at least getLength() elements, overwritten.
+         */
+        void forward(FFT_COMPLEX_TYPE *data, FFT_COMPLEX_TYPE *work) const;
+
+        /**
+         * @brief Transforms data in place with exp(+2 pi i k t / n) and no scaling, so forward then inverse multiplies
+         * by getLength().
+         */
+        void inverse(FFT_COMPLEX_TYPE *data, FFT_COMPLEX_TYPE *work) const;
+
+        /**
+         * @brief Whether length has no prime factors other than 2, 3 and 5.
+         */
+        static bool isSupportedLength(std::size_t length);
+    };
+
+    /**
+     * @brief A real-to-complex FFT of a fixed even length n, done as a complex FFT of n / 2 points whose output is then
+     * split into the spectrum of the even and odd samples.
+     */
+    class RealFFT
+    {
+        std::size_t length;
+        ComplexFFT halfFFT;
+        std::vector<FFT_COMPLEX_TYPE> twiddles; /**< exp(-2 pi i k / n) for k = 0 .. n / 2. */
+
+    public:
+        explicit RealFFT(std::size_t length);
+
+        std::size_t getLength() const {
+            return length;
+        }
+
+        /**
+         * @brief The number of elements forward() needs in its work buffer.
+         */
+        std::size_t getWorkLength() const {
+            return length / 2;
+        }
+
+        /**
+         * @brief Writes the n / 2 + 1 non-negative frequency bins of the length real samples in.
+         *
+         * @param out A buffer of at least length / 2 + 1 elements.
+         * @param work A buffer of at least getWorkLength() elements, overwritten.
+         */
+        void forward(const float *in, FFT_COMPLEX_TYPE *out, FFT_COMPLEX_TYPE *work) const;
+
+        /**
+         * @brief The largest even length not above maxLength that RealFFT supports. Time series are truncated to it,
+         * which loses at most a few per cent of the samples.
+         */
+        static std::size_t goodLength(std::size_t maxLength);
+    };
+
+    /**
+     * @brief Makes each FFT plan once and shares it between all the threads and searches that use the same length.
+     */
+    class FFTPlanCache
+    {
+        std::mutex cacheMutex;
+        std::map<std::size_t, std::shared_ptr<const ComplexFFT>> complexPlans;
+        std::map<std::size_t, std::shared_ptr<const RealFFT>> realPlans;
+
+    public:
+        std::shared_ptr<const ComplexFFT> getComplexPlan(std::size_t length);
+        std::shared_ptr<const RealFFT> getRealPlan(std::size_t length);
+    };
+
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include "utils/thread_pool.hpp"
+
+namespace OPS {
+
+    struct FoldCandidate
+    {
+        double period;      /**< Period in seconds at the middle of the folded data. */
+        float dm;
+        float acceleration; /**< Line-of-sight acceleration in m/s^2, positive away from the observer. */
+    };
+
+    struct FoldingOptions
+    {
+        unsigned int nBins = 64;      /**< Phase bins per period. */
+        unsigned int nSubints = 32;   /**< Sub-integrations the data are split into. */
+        unsigned int nSubbands = 32;  /**< Subbands the channels are summed into; must divide the number of channels. */
+        unsigned int nThreads = 0;    /**< Threads the candidates are spread over (0 = all cores). */
+    };
+
+    /**
+     * @brief Header of a file of folded candidates. Every candidate follows as a FoldedCandidateHeader and its
+     * nSubints x nSubbands x nBins cube of mean values, bins fastest.
+     */
+    struct FoldFileHeader
+    {
+        char magic[8];
+        uint32_t nCandidates;
+        uint32_t nSubints;
+        uint32_t nSubbands;
+        uint32_t nBins;
+        uint64_t nSamples;  /**< Samples folded. */
+        double tsamp;
+        double fch1;        /**< Frequency of the first channel in MHz. */
+        double subbandBW;   /**< Width of a subband in MHz, negative if the frequency decreases with the subband. */
+    };
+
+    struct FoldedCandidateHeader
+    {
+        double period;
+        float dm;
+        float acceleration;
+        float snr;     /**< Significance of the integrated profile, see CandidateFold::getProfileSNR(). */
+        uint32_t reserved;
+    };
+
+    /**
+     * @brief The sub-integration x subband x phase cube of one candidate, accumulated one gulp of filterbank data at
+     * a time.
+     *
+     * A sample of channel c at time t was emitted at t - delay(c), whose phase, with P the period and a the
+     * acceleration at the reference epoch t_ref in the middle of the data, is
+     * (t - a ((t - t_ref)^2 - t_ref^2) / 2c) / P. Delays are rounded to whole samples, so for every gulp the bin and
+     * sub-integration of each emission sample are looked up once and shared by all channels, and folding a channel
+     * sample costs a table lookup and an add. The number of samples in every cell is counted per subband from the
+     * range of emission samples each channel covers, rather than per channel sample.
+     */
+    class CandidateFold
+    {
+        FoldCandidate candidate;
+        FoldingOptions options;
+        std::size_t totalNSamples;
+        double tsamp;
+
+        std::vector<std::size_t> channelDelays; /**< In samples, relative to the highest frequency. */
+        std::size_t maxDelay;
+        std::vector<double> sums;     /**< subint, subband, bin */
+        std::vector<uint64_t> counts; /**< subint, subband, bin */
+
+        std::vector<std::size_t> cellOf;   /**< Cube offset (subband 0) of every emission sample of the gulp. */
+        std::vector<int64_t> coverage;     /**< Channels of a subband covering every emission sample of the gulp. */
+
+        template <typename DTYPE>
+        void foldOfType(std::size_t startSample, std::size_t nSamples, const DTYPE *data);
+
+    public:
+        /**
+         * @brief Constructs a CandidateFold object.
+         *
+         * @param channelFrequencies The frequency of every channel in MHz.
+         * @param totalNSamples The number of samples that will be folded, which sets the sub-integrations.
+         */
+        CandidateFold(const FoldCandidate &candidate, const FoldingOptions &options, const std::vector<double> &channelFrequencies,
+                      std::size_t totalNSamples, double tsamp);
+
+        /**
+         * @brief Folds nSamples time-major samples of every channel, starting at sample startSample of the folded data.
+         *
+         * @param nBits 8, 16 or 32 bits per value, as given to the dedisperser.
+         */
+        void fold(std::size_t startSample, std::size_t nSamples, const uint8_t *data, unsigned int nBits);
+
+        const FoldCandidate &getCandidate() const {
+            return candidate;
+        }
+
+        /**
+         * @brief The cube of mean values, subint after subint, subband after subband. Empty cells are 0.
+         */
+        std::vector<float> getCube() const;
+
+        /**
+         * @brief The mean profile over all sub-integrations and subbands.
+         */
+        std::vector<float> getProfile() const;
+
+        /**
+         * @brief The best signal-to-noise ratio of a boxcar over the profile, with the noise taken from the median
+         * absolute deviation of the profile bins.
+         */
+        float getProfileSNR() const;
+    };
+
+    /**
+     * @brief Folds many candidates in one pass over a filterbank, with every gulp handed to all of them and the
+     * candidates spread over a thread pool.
+     */
+    class Folder
+    {
+        std::vector<std::unique_ptr<CandidateFold>> folds;
+        std::unique_ptr<UTILS::ThreadPool> threadPool;
+        FoldingOptions options;
+        std::size_t totalNSamples;
+        double tsamp;
+        double fch1;
+        double subbandBW;
+
+    public:
+        static const char MAGIC[8];
+
+        /**
+         * @brief Constructs a Folder object.
+         *
+         * @param fch1 The frequency of the first channel in MHz.
+         * @param foff The channel width in MHz.
+         * @param totalNSamples The number of samples that will be folded.
+         */
+        Folder(const std::vector<FoldCandidate> &candidates, const FoldingOptions &options, unsigned int nChans, double fch1,
+               double foff, std::size_t totalNSamples, double tsamp);
+
+        /**
+         * @brief Folds the next gulp into every candidate. See CandidateFold::fold().
+         */
+        void fold(std::size_t startSample, std::size_t nSamples, const uint8_t *data, unsigned int nBits);
+
+        const std::vector<std::unique_ptr<CandidateFold>> &getFolds() const {
+            return folds;
+        }
+
+        /**
+         * @brief Writes a FoldFileHeader, then the header and cube of every candidate.
+         */
+        void write(const std::string &fileName) const;
+
+        /**
+         * @brief Reads candidates from a periodicity IO::CandidateTable, or from a text file with the period in ms,
+         * the DM and optionally the acceleration in m/s^2 on every line.
+         */
+        static std::vector<FoldCandidate> readCandidates(const std::string &fileName);
+    };
+
+};
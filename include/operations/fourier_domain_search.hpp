@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "operations/periodicity_search.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Responses of a Fourier bin to signals whose frequency drifts by z bins (and whose drift changes by w
+     * bins) over the observation, on a grid of z and w, ready for overlap-save correlation.
+     *
+     * The response to a signal of mean Fourier frequency r at bin r + d is R(d) = int_0^1 exp(2 pi i (psi(u) - d u)) du,
+     * with psi(u) = z u^2 / 2 + w u^3 / 6 - (z / 2 + w / 6) u. Sampled finely in u this integral is a DFT, so each
+     * template comes from one FFT of the chirp exp(2 pi i psi). Templates span the bins the signal drifts over plus
+     * HALF_WIDTH_MARGIN on either side, are scaled to unit energy, and are kept both at integer and half-integer
+     * offsets, the latter giving the interbinned half-bins. Each is stored already conjugated, reversed and Fourier
+     * transformed at the block length of the correlation, so that correlating a block costs one multiply per bin.
+     */
+    class FourierTemplateBank
+    {
+    public:
+        struct Template
+        {
+            float z;
+            float w;
+            std::size_t halfWidth;                   /**< The template spans bins -halfWidth .. halfWidth. */
+            std::vector<FFT_COMPLEX_TYPE> kernels[2]; /**< Transformed kernels for offsets 0 and -1/2 bin, i.e. bins b and b + 1/2. */
+        };
+
+    private:
+        std::size_t nZ;
+        std::size_t nW;
+        float zStep;
+        float wStep;
+        std::size_t blockLength;
+        std::shared_ptr<const ComplexFFT> blockFFT;
+        std::vector<Template> templates; /**< z index + nZ * w index. */
+
+        void makeTemplate(Template &response, FFTPlanCache &planCache);
+
+    public:
+        static const std::size_t HALF_WIDTH_MARGIN = 16;
+        static const std::size_t MIN_BLOCK_LENGTH = 2048;
+
+        /**
+         * @brief Makes the templates of z = -zMax .. zMax in steps of zStep and w = -wMax .. wMax in steps of wStep.
+         */
+        FourierTemplateBank(float zMax, float zStep, float wMax, float wStep, FFTPlanCache &planCache, UTILS::ThreadPool &threadPool);
+
+        std::size_t getNTemplates() const {
+            return templates.size();
+        }
+
+        /**
+         * @brief The memory the kernels of every template take.
+         */
+        std::size_t getBytes() const;
+
+        const Template &getTemplate(std::size_t index) const {
+            return templates[index];
+        }
+
+        /**
+         * @brief The index of the template nearest to z and w, clamped to the grid.
+         */
+        std::size_t findTemplate(float z, float w) const;
+
+        std::size_t getBlockLength() const {
+            return blockLength;
+        }
+
+        const ComplexFFT &getBlockFFT() const {
+            return *blockFFT;
+        }
+    };
+
+    /**
+     * @brief Fourier-domain acceleration and jerk search (Ransom et al. 2002; Andersen & Ransom 2018).
+     *
+     * Every DM trial is transformed once and its spectrum normalised so that noise bins have unit mean power. Each
+     * template of a FourierTemplateBank, shared by all DMs, is then correlated with the spectrum by overlap-save FFT
+     * convolution, which gives that slice of the frequency / f-dot (/ f-dot-dot) volume at half-bin resolution. As in
+     * PRESTO, z and w are those of the highest harmonic summed: for every chunk of that harmonic's frequencies the
+     * slices of the lower harmonics h / nHarmonics are correlated with the templates of z h / nHarmonics and
+     * w h / nHarmonics, which costs about (nHarmonics + 1) / 2 times a single slice, and the harmonics of every
+     * stage are summed and thresholded as in the plain search. The templates, i.e. the (z, w) pairs, are the trials
+     * spread over the thread pool with the DMs.
+     */
+    class FourierDomainSearch : public PeriodicitySearch
+    {
+        std::unique_ptr<FourierTemplateBank> templateBank; /**< Trial i searches with template i. */
+        std::vector<std::vector<FFT_COMPLEX_TYPE>> spectra; /**< Normalised spectrum of every DM, made in finish(). */
+
+        std::size_t getNTrials() const override {
+            return templateBank->getNTemplates();
+        }
+
+        void searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t trial,
+                         std::vector<PeriodicityCandidate> &found) override;
+
+        /**
+         * @brief Transforms the time series and scales the spectrum to unit mean noise power over the searched bins.
+         */
+        void makeSpectrum(const float *timeSeries, std::size_t nSamples, std::vector<FFT_COMPLEX_TYPE> &spectrum);
+
+        /**
+         * @brief Writes the powers of half-bins 2 * binStart .. 2 * binEnd - 1 of the spectrum correlated with a template.
+         */
+        void correlate(const std::vector<FFT_COMPLEX_TYPE> &spectrum, const FourierTemplateBank::Template &response,
+                       std::size_t binStart, std::size_t binEnd, float *powers) const;
+
+        void searchSpectrum(const std::vector<FFT_COMPLEX_TYPE> &spectrum, float dm, std::size_t trial,
+                            std::vector<PeriodicityCandidate> &found);
+
+    public:
+        static const std::size_t CHUNK_HALF_BINS = 1 << 16;
+
+        /**
+         * @brief Constructs a FourierDomainSearch object.
+         *
+         * @param zMax The largest drift of the highest harmonic, in Fourier bins.
+         * @param wMax The largest change of that drift, in Fourier bins (0 = no jerk search).
+         */
+        FourierDomainSearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                            const PeriodicitySearchOptions &options, float zMax, float wMax);
+
+        /**
+         * @brief Transforms every DM trial in place of its time series, then correlates every spectrum with every
+         * template.
+         */
+        void finish() override;
+
+        std::size_t getNTemplates() const {
+            return templateBank->getNTemplates();
+        }
+
+        /**
+         * @brief The time series, which finish() turns into spectra in their place, and the template bank.
+         */
+        std::size_t getFixedBytes() const override {
+            return PeriodicitySearch::getFixedBytes() + templateBank->getBytes();
+        }
+
+        static constexpr float Z_STEP = 2.0f;
+        static constexpr float W_STEP = 20.0f;
+    };
+
+};
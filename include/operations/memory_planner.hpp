@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include "operations/dedispersion_backend.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief How a dedispersion run is buffered.
+     */
+    struct MemoryPlan
+    {
+        std::size_t gulpNSamples;     /**< Samples dedispersed at a time, all of them if not gulping. */
+        bool gulping;                 /**< Whether the samples are dedispersed in more than one gulp. */
+        unsigned int readAhead;       /**< Gulps read ahead in the background (0 = read on demand). */
+        std::size_t maxBufferedGulps; /**< Dedispersed gulps that may wait for the writers and consumers. */
+        std::size_t bytes;            /**< Estimated peak memory use. */
+    };
+
+    /**
+     * @brief Sizes the gulps and buffers of a dedispersion run to fit a RAM budget.
+     *
+     * The memory of a run is linear in the gulp size G: the input buffers (one, or the readAhead buffers of the
+     * prefetcher) of G unpacked input samples, the gulp stitched behind the carried-over tail of G + maxDelaySamples
+     * input samples, the working memory of the backend for those G + maxDelaySamples samples, e.g. the FDMT's delay
+     * rows, and maxBufferedGulps + 1 gulps of G dedispersed samples per DM, besides the fixed memory of the backend
+     * and of the consumers, e.g. the time series and templates of a periodicity search. The
+     * whole selection is dedispersed in one go if that fits. Otherwise the buffering the user asked for is given up
+     * one step at a time, dedispersed gulps first, until gulps of PREFERRED_GULP_DELAYS max delays fit, so that little
+     * of every gulp is spent on its overlap; if none do, the gulp is as large as the least buffering allows, down to
+     * MIN_GULP_DELAYS max delays. HEADROOM of the budget is left for what the estimate does not cover.
+     */
+    class MemoryPlanner
+    {
+        std::size_t bytesPerInputSample;
+        std::size_t nDMs;
+        std::size_t maxDelaySamples;
+        std::size_t nSamples;
+        std::size_t fixedBytes = 0;
+        std::size_t backendBytesPerSample = 0;
+
+        /**
+         * @brief The largest gulp that fits in budget bytes with this buffering, 0 if none does.
+         */
+        std::size_t getMaxGulp(std::size_t budget, unsigned int readAhead, std::size_t maxBufferedGulps) const;
+
+    public:
+        static const std::size_t MIN_GULP_DELAYS = 2;
+        static const std::size_t PREFERRED_GULP_DELAYS = 8;
+        static constexpr double HEADROOM = 0.1;
+
+        /**
+         * @brief Constructs a MemoryPlanner object.
+         *
+         * @param nChans The number of channels.
+         * @param nBits The number of bits per input sample; sub-byte samples are unpacked to bytes.
+         * @param nDMs The number of DM trials.
+         * @param maxDelaySamples The largest dispersion delay in samples, as given by the Dedisperser.
+         * @param nSamples The number of input samples to dedisperse.
+         */
+        MemoryPlanner(unsigned int nChans, unsigned int nBits, std::size_t nDMs, std::size_t maxDelaySamples, std::size_t nSamples);
+
+        /**
+         * @brief Adds memory that is held whatever the gulp size.
+         */
+        void addFixedBytes(std::size_t bytes) {
+            fixedBytes += bytes;
+        }
+
+        /**
+         * @brief Adds the working memory of the dedispersion backend, as reported by Dedisperser::getBackendMemory().
+         */
+        void addBackendMemory(const BackendMemory &memory) {
+            backendBytesPerSample += memory.bytesPerSample;
+            fixedBytes += memory.fixedBytes;
+        }
+
+        /**
+         * @brief The estimated peak memory use of gulps of gulpNSamples samples with this buffering.
+         */
+        std::size_t getBytes(std::size_t gulpNSamples, unsigned int readAhead, std::size_t maxBufferedGulps) const;
+
+        /**
+         * @brief Chooses the gulp size and buffering within ramLimitBytes, with at most readAhead read-ahead gulps
+         * and maxBufferedGulps buffered dedispersed gulps. Throws InvalidInputs if even the smallest gulp does not fit.
+         */
+        MemoryPlan plan(std::size_t ramLimitBytes, unsigned int readAhead, std::size_t maxBufferedGulps) const;
+
+        /**
+         * @brief Like plan(), but for gulps of gulpNSamples samples chosen by the user: only the buffering is reduced.
+         */
+        MemoryPlan plan(std::size_t ramLimitBytes, std::size_t gulpNSamples, unsigned int readAhead, std::size_t maxBufferedGulps) const;
+    };
+
+};
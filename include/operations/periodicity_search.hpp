@@ -0,0 +1,193 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "data/dedispersed_consumer.hpp"
+#include "operations/fft.hpp"
+#include "operations/spectrum_cleaner.hpp"
+#include "operations/barycentre.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace OPS {
+
+    struct PeriodicitySearchOptions
+    {
+        unsigned int nHarmonics = 16;       /**< Largest number of harmonics summed: 1, 2, 4, 8, 16 or 32. */
+        float sigmaThreshold = 6.0f;        /**< Gaussian-equivalent significance a candidate must reach. */
+        double minFrequency = 1.0;          /**< Lowest fundamental frequency searched, in Hz. */
+        double maxFrequency = 0.0;          /**< Highest frequency any harmonic may have, in Hz (0 = Nyquist). */
+        std::size_t maxCandidatesPerSeries = 100;
+        unsigned int nThreads = 0;          /**< Threads the DM trials are spread over (0 = all cores). */
+    };
+
+    struct PeriodicityCandidate
+    {
+        float dm;
+        float acceleration;      /**< Line-of-sight acceleration in m/s^2, positive away from the observer. */
+        float jerk;              /**< Line-of-sight jerk in m/s^3, searched by the Fourier-domain search only. */
+        double frequency;        /**< Fundamental frequency in Hz. */
+        unsigned int nHarmonics; /**< Number of harmonics summed. */
+        float power;             /**< Summed normalised power. */
+        float sigma;             /**< Gaussian-equivalent significance of power for a single trial. */
+    };
+
+    /**
+     * @brief FFT periodicity search of the dedispersed time series, run on the output of the Dedisperser.
+     *
+     * As a DedispersedConsumer it collects every DM trial in memory while the dedispersion runs, and searches all of
+     * them in finish(), spread over a thread pool. Each time series is truncated to a length RealFFT supports, its
+     * mean removed and Fourier transformed with a plan shared by all trials. The power spectrum is interbinned, i.e.
+     * the half-integer bins are estimated as pi^2 / 16 * |X[k] - X[k + 1]|^2, which recovers most of the power of
+     * signals between two bins, and normalised by its median so that noise powers have unit mean. Harmonics are then
+     * summed incoherently in stages of 1, 2, 4, ... nHarmonics, and at every stage the local maxima whose summed power
+     * exceeds the power the threshold significance needs for that many harmonics become candidates.
+     */
+    class PeriodicitySearch : public IO::DedispersedConsumer
+    {
+    protected:
+        PeriodicitySearchOptions options;
+        double tsamp;
+        std::vector<float> dmList;
+        std::size_t totalNSamples;
+        std::vector<std::vector<float>> series; /**< The time series of every DM trial, filled by consume(). */
+
+        std::shared_ptr<FFTPlanCache> planCache;
+        std::unique_ptr<UTILS::ThreadPool> threadPool;
+        std::vector<float> powerThresholds; /**< Summed power needed by every harmonic stage. */
+        std::shared_ptr<const SpectrumCleaner> spectrumCleaner; /**< Applied to every spectrum before its powers are formed, if set. */
+        std::shared_ptr<const Barycentre> barycentre; /**< Applied to every time series as it is collected, if set. */
+
+        std::vector<PeriodicityCandidate> candidates;
+        std::mutex candidatesMutex;
+
+        /**
+         * @brief Fills powers with the 2 * (nBins - 1) + 1 interbinned powers of nBins Fourier bins.
+         */
+        static void formPowerSpectrum(const FFT_COMPLEX_TYPE *bins, std::size_t nBins, std::vector<float> &powers);
+
+        /**
+         * @brief Divides the powers by their median over half-bins [firstHalfBin, lastHalfBin], times ln 2.
+         */
+        static void normalisePowers(std::vector<float> &powers, std::size_t firstHalfBin, std::size_t lastHalfBin);
+
+        /**
+         * @brief Normalises the interbinned powers in place, sums their harmonics and adds the candidates to found.
+         *
+         * @param observationLength The length of the transformed time series in seconds.
+         */
+        void searchPowers(std::vector<float> &powers, double observationLength, float dm, float acceleration,
+                          std::vector<PeriodicityCandidate> &found);
+
+        /**
+         * @brief Finds the half-bins [firstHalfBin, lastHalfBin] of a spectrum of nHalfBins interbinned powers that lie
+         * within the searched frequencies. Returns false if there are too few.
+         */
+        bool getSearchRange(std::size_t nHalfBins, double observationLength, std::size_t &firstHalfBin, std::size_t &lastHalfBin) const;
+
+        /**
+         * @brief Adds the strongest of the candidates of one trial to found, at most one per Fourier bin and at most
+         * maxCandidatesPerSeries in all. Sorts trialCandidates.
+         */
+        void keepStrongest(std::vector<PeriodicityCandidate> &trialCandidates, double observationLength,
+                           std::vector<PeriodicityCandidate> &found) const;
+
+        void sortCandidates();
+
+        /**
+         * @brief Removes the mean of samples, whose length RealFFT must support, and searches its spectrum.
+         */
+        void searchSamples(std::vector<float> &samples, float dm, float acceleration, std::vector<PeriodicityCandidate> &found);
+
+        /**
+         * @brief The number of trials, e.g. accelerations, every DM is searched with.
+         */
+        virtual std::size_t getNTrials() const {
+            return 1;
+        }
+
+        /**
+         * @brief Searches trial number trial of one time series and adds its candidates to found. The plain search has
+         * a single trial, the series as it is. Called from several threads at once.
+         */
+        virtual void searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t trial,
+                                 std::vector<PeriodicityCandidate> &found);
+
+    public:
+        static const unsigned int MAX_HARMONICS = 32;
+
+        /**
+         * @brief Constructs a PeriodicitySearch object.
+         *
+         * @param dmList The DMs of the trials, as given to the Dedisperser.
+         * @param totalNSamples The number of samples each dedispersed time series will have.
+         * @param tsamp The sampling time in seconds.
+         */
+        PeriodicitySearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                          const PeriodicitySearchOptions &options);
+
+        /**
+         * @brief Whitens and zaps every spectrum in place before it is searched. Pass nullptr to search it as it is.
+         */
+        void setSpectrumCleaner(std::shared_ptr<const SpectrumCleaner> spectrumCleaner) {
+            this->spectrumCleaner = spectrumCleaner;
+        }
+
+        /**
+         * @brief Barycentres every time series as it is collected, with one table of added and dropped samples made
+         * for totalNSamples samples. Must be set before the first block is consumed.
+         */
+        void setBarycentre(std::shared_ptr<const Barycentre> barycentre) {
+            this->barycentre = barycentre;
+            this->totalNSamples = barycentre->getNOutputSamples();
+        }
+
+        void consume(const IO::DedispersedBlock &block) override;
+
+        /**
+         * @brief The memory the search holds whatever the gulp size, for the MemoryPlanner: the time series it
+         * collects of every DM, besides what a derived search keeps for all of them.
+         */
+        virtual std::size_t getFixedBytes() const {
+            return dmList.size() * totalNSamples * sizeof(float);
+        }
+
+        /**
+         * @brief Searches every collected DM with every trial, spreading the DM and trial pairs over the thread pool,
+         * and releases each time series once all its trials are done.
+         */
+        void finish() override;
+
+        /**
+         * @brief Searches every trial of nSamples samples of one time series and adds the candidates to found.
+         * Safe to call from several threads at once.
+         */
+        void searchSeries(const float *timeSeries, std::size_t nSamples, float dm, std::vector<PeriodicityCandidate> &found);
+
+        /**
+         * @brief All candidates found by finish(), strongest first.
+         */
+        const std::vector<PeriodicityCandidate> &getCandidates() const {
+            return candidates;
+        }
+
+        /**
+         * @brief The length in seconds of the transformed time series, whose inverse is the Fourier bin width.
+         */
+        double getObservationLength() const {
+            return RealFFT::goodLength(totalNSamples) * tsamp;
+        }
+
+        /**
+         * @brief Writes the candidates as a text table, one per line.
+         */
+        void writeCandidates(const std::string &fileName) const;
+
+        /**
+         * @brief The Gaussian-equivalent significance of a sum of nHarmonics normalised powers, whose noise
+         * distribution is a gamma distribution of shape nHarmonics.
+         */
+        static float powerToSigma(double power, unsigned int nHarmonics);
+    };
+
+};
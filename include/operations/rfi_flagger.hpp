@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "data/constants.hpp"
+#include "operations/bandpass.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Flags channels hit by RFI in each gulp, giving a killmask that follows intermittent interference.
+     *
+     * Two tests are run on the per-channel statistics of the gulp:
+     *  - spectral kurtosis, SK = (M + 1) / (M - 1) * (M * S2 / S1^2 - 1) over the M samples of the channel, which only
+     *    needs the mean and RMS. Gaussian noise gives the same SK in every channel of a band, while impulsive or
+     *    narrow-band RFI pushes it up or down;
+     *  - the bandpass itself, i.e. the channel mean, against which persistent narrow-band RFI stands out.
+     * Each quantity is compared with its running median over the neighbouring channels, and a channel is flagged when
+     * the difference exceeds threshold times the robust sigma (1.4826 * MAD) of those differences across the band.
+     * Channels without any variation are flagged as dead.
+     */
+    class RFIFlagger
+    {
+        unsigned int nChans;
+        float threshold;
+        std::size_t window;
+        ChannelStatistics statistics;
+        BandpassStatistics gulpStatistics;
+
+        std::vector<DEDISP_BOOL> mask;
+        std::size_t nGulps;
+        std::size_t nChannelsFlagged; /**< Summed over all gulps. */
+
+        void flagOutliers(const std::vector<float> &values, const std::vector<bool> &usable);
+
+    public:
+        static const std::size_t DEFAULT_WINDOW = 33;
+
+        /**
+         * @brief Constructs an RFIFlagger object.
+         *
+         * @param nChans The number of channels.
+         * @param threshold The number of robust sigmas beyond which a channel is flagged.
+         * @param nThreads The number of threads used for statistics the flagger computes itself (0 = all cores).
+         * @param window The number of channels the running medians span.
+         */
+        RFIFlagger(unsigned int nChans, float threshold, unsigned int nThreads, std::size_t window = DEFAULT_WINDOW);
+
+        /**
+         * @brief Flags the channels of a gulp from its statistics, which must be of the data as recorded.
+         *
+         * @return The mask, 1 for good channels and 0 for flagged ones, as expected by Dedisperser::setKillMask.
+         */
+        const std::vector<DEDISP_BOOL> &flag(const BandpassStatistics &stats);
+
+        /**
+         * @brief Flags the channels of nSamples time-major samples of inNBits (8, 16 or 32) bits.
+         */
+        const std::vector<DEDISP_BOOL> &flag(std::size_t nSamples, const uint8_t *data, unsigned int inNBits);
+
+        /**
+         * @brief The fraction of channels flagged in the last gulp.
+         */
+        float getFlaggedFraction() const;
+
+        /**
+         * @brief The fraction of channels flagged over all gulps so far.
+         */
+        float getTotalFlaggedFraction() const;
+
+        std::size_t getNGulps() const {
+            return nGulps;
+        }
+    };
+
+};
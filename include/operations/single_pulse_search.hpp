@@ -0,0 +1,109 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <mutex>
+#include "data/dedispersed_consumer.hpp"
+
+namespace OPS {
+
+    struct SinglePulseSearchOptions
+    {
+        unsigned int maxWidth = 64;  /**< Widest boxcar in samples, a power of two; widths 1, 2, 4, ... maxWidth are tried. */
+        float sigmaThreshold = 6.0f; /**< Signal-to-noise ratio an event must reach. */
+    };
+
+    struct SinglePulseEvent
+    {
+        float dm;
+        std::size_t sample; /**< First sample of the boxcar in the dedispersed time series. */
+        unsigned int width; /**< Boxcar width in samples. */
+        float snr;          /**< Signal-to-noise ratio of the boxcar. */
+    };
+
+    /**
+     * @brief Boxcar search of every dedispersed gulp for single pulses, while the dedispersion runs.
+     *
+     * As a DedispersedConsumer it runs on the writer threads, so the DM blocks of a gulp are searched in parallel and
+     * alongside the dedispersion of the next gulp. Each gulp of a DM is normalised by its median and the median
+     * absolute deviation, and every boxcar width is then a difference of prefix sums, rescaled by the robust
+     * statistics of its own output so that red noise does not inflate the wider boxcars. Every sample keeps its best
+     * width, and each run of samples above the threshold gives one event at its peak. The last maxWidth - 1 samples
+     * of every DM are kept for the next gulp and normalised with it, so that pulses across gulp boundaries are found
+     * and scored on one scale, and a run still open at the end of a gulp is reported in the gulp where it ends.
+     */
+    class SinglePulseSearch : public IO::DedispersedConsumer
+    {
+        /**
+         * @brief What one DM carries over from one gulp to the next.
+         */
+        struct DMState
+        {
+            std::vector<float> tail;    /**< The last samples as dedispersed, up to maxWidth - 1 of them. */
+            bool runOpen = false;       /**< Whether the last sample was above the threshold. */
+            SinglePulseEvent runPeak{}; /**< The peak so far of the open run. */
+        };
+
+        SinglePulseSearchOptions options;
+        double tsamp;
+        std::vector<float> dmList;
+        std::vector<unsigned int> widths;
+        std::vector<DMState> states; /**< Only touched by the block that holds the DM. */
+
+        std::vector<SinglePulseEvent> events;
+        std::mutex eventsMutex;
+
+        /**
+         * @brief Scratch space of one consume() call, reused for all its DMs.
+         */
+        struct Workspace
+        {
+            std::vector<float> normalised;
+            std::vector<double> prefixSums;
+            std::vector<float> boxcar;
+            std::vector<float> bestSNR;
+            std::vector<unsigned int> bestWidth;
+            std::vector<float> statistics;
+        };
+
+        /**
+         * @brief Searches nSamples new samples of DM iDM, starting at sample startSample, and adds the events to found.
+         */
+        void searchSeries(std::size_t iDM, const float *samples, std::size_t nSamples, std::size_t startSample,
+                          Workspace &workspace, std::vector<SinglePulseEvent> &found);
+
+        /**
+         * @brief The median and the standard deviation estimated from the median absolute deviation of up to
+         * STATISTICS_SAMPLES evenly spaced values. Returns false if the deviation is zero.
+         */
+        static bool robustStatistics(const float *values, std::size_t nValues, std::vector<float> &scratch,
+                                     float &median, float &sigma);
+
+    public:
+        static const std::size_t STATISTICS_SAMPLES = 8192;
+
+        /**
+         * @brief Constructs a SinglePulseSearch object.
+         *
+         * @param dmList The DMs of the trials, as given to the Dedisperser.
+         * @param tsamp The sampling time in seconds.
+         */
+        SinglePulseSearch(const std::vector<float> &dmList, double tsamp, const SinglePulseSearchOptions &options);
+
+        void consume(const IO::DedispersedBlock &block) override;
+
+        /**
+         * @brief Adds the runs still open at the end of the data, and sorts the events by time, then DM.
+         */
+        void finish() override;
+
+        const std::vector<SinglePulseEvent> &getEvents() const {
+            return events;
+        }
+
+        /**
+         * @brief Writes the events as a text table, one per line.
+         */
+        void writeEvents(const std::string &fileName) const;
+    };
+
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <utility>
+#include "operations/fft.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief A periodic interference signal, zapped at its frequency and its harmonics.
+     */
+    struct Birdie
+    {
+        double frequency;          /**< Fundamental frequency in Hz. */
+        double width;              /**< Full width zapped around every harmonic, in Hz. */
+        unsigned int nHarmonics;   /**< Harmonics zapped, the fundamental being the first. */
+    };
+
+    /**
+     * @brief Cleans the spectrum of a time series in place, before its powers are searched.
+     *
+     * Red noise is removed by whitening: the spectrum is cut into blocks that start MIN_BLOCK_BINS wide and grow by
+     * BLOCK_GROWTH of their start frequency up to MAX_BLOCK_BINS, so that they are log-spaced where the red noise
+     * changes fast and uniform above. The median power of every block / ln 2 estimates the local mean noise power,
+     * which is interpolated linearly between block centres and divided out of every bin. Birdies are then zapped: all
+     * their harmonics are merged into one sorted list of frequency intervals when the cleaner is made, so zapping a
+     * spectrum walks that list once, from the first interval that reaches the spectrum, and zeroes the bins it covers.
+     * Only a list of block medians is allocated per spectrum, never a copy of it.
+     */
+    class SpectrumCleaner
+    {
+        bool whiten;
+        std::vector<std::pair<double, double>> zapIntervals; /**< Merged [low, high] frequencies in Hz, in order. */
+
+        void whitenSpectrum(FFT_COMPLEX_TYPE *bins, std::size_t nBins) const;
+        void zapBirdies(FFT_COMPLEX_TYPE *bins, std::size_t nBins, double observationLength) const;
+
+    public:
+        static const std::size_t MIN_BLOCK_BINS = 6;
+        static const std::size_t MAX_BLOCK_BINS = 200;
+        static constexpr double BLOCK_GROWTH = 0.1;
+
+        /**
+         * @brief Constructs a SpectrumCleaner object.
+         *
+         * @param whiten Whether red noise is removed.
+         * @param birdies The signals to zap.
+         */
+        SpectrumCleaner(bool whiten, const std::vector<Birdie> &birdies);
+
+        /**
+         * @brief Whitens and zaps nBins bins of the real FFT of a time series of observationLength seconds, in place.
+         * Safe to call from several threads at once.
+         */
+        void clean(FFT_COMPLEX_TYPE *bins, std::size_t nBins, double observationLength) const;
+
+        std::size_t getNZapIntervals() const {
+            return zapIntervals.size();
+        }
+
+        /**
+         * @brief Reads birdies from a text file with the frequency in Hz, the width in Hz and optionally the number of
+         * harmonics (default 1) on every line. Lines starting with # are skipped.
+         */
+        static std::vector<Birdie> readBirdies(const std::string &fileName);
+    };
+
+};
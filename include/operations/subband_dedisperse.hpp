@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "operations/cpu_dedisperse.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Two-stage (piecewise-linear) subband dedispersion on the CPU.
+     *
+     * The band is split into nSubbands groups of adjacent channels, and the DM trials are grouped around a coarser set of
+     * nominal DMs. Stage one dedisperses the channels of every subband to the top of that subband at each nominal DM.
+     * Stage two then forms every fine DM trial by shifting and adding the nSubbands subband series of its nominal DM.
+     * Nominal DMs are spaced so that using the nominal instead of the exact DM inside a subband smears any trial by at
+     * most subbandSmearing samples. The cost drops from nDMs * nChans to nNominalDMs * nChans + nDMs * nSubbands per sample.
+     */
+    class SubbandDedisperser : public CPUDedisperser
+    {
+        unsigned int nSubbands;
+        float maxSmearingSamples;
+
+        std::vector<unsigned int> subbandStart; /**< First channel of each subband, with nChans appended at the end. */
+        std::vector<float> nominalDMs;
+        std::vector<std::vector<std::size_t>> dmGroups; /**< Indices into dmList of the trials formed from each nominal DM. */
+        std::vector<float> smearingSamples; /**< Extra smearing, in samples, of each trial in dmList. */
+        std::vector<float> subbandData; /**< nSubbands series of nSamplesIn samples for the current nominal DM. */
+
+        void generateSubbands();
+        void generateNominalDMs();
+
+        template <typename DTYPE>
+        void executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData);
+
+    public:
+        SubbandDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads, unsigned int nSubbands, float maxSmearingSamples);
+
+        std::string getName() {
+            return "subband";
+        }
+
+        void setDMList(const std::vector<float> &dmList);
+        void execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData);
+
+        /**
+         * @brief The memory of the brute-force backend, and the nSubbands series of the current nominal DM.
+         */
+        BackendMemory getWorkingMemory(unsigned int inNBits);
+
+        unsigned int getNSubbands() {
+            return nSubbands;
+        }
+
+        const std::vector<float> &getNominalDMs() {
+            return nominalDMs;
+        }
+
+        const std::vector<float> &getSmearingSamples() {
+            return smearingSamples;
+        }
+
+        void printSmearingReport();
+    };
+
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "data/constants.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace OPS {
+
+    /**
+     * @brief Removes broadband RFI from time-major filterbank gulps before dedispersion.
+     *
+     * A first pass, parallel over time, sums every sample over the unmasked channels into the zero-DM time series and
+     * every channel over time. Time samples whose zero-DM value lies more than clipSigma robust sigmas above its median
+     * are then replaced by the mean of each channel, and from all other samples the deviation of the zero-DM series from
+     * its median is subtracted (Eatough et al. 2009), which leaves the level of every channel unchanged. Both inner
+     * loops run over a row of channels and are vectorised by the compiler. Integer data are rounded and clamped to
+     * their range.
+     */
+    class ZeroDMFilter
+    {
+        unsigned int nChans;
+        bool subtractZeroDM;
+        float clipSigma;
+        std::unique_ptr<UTILS::ThreadPool> threadPool;
+
+        std::vector<float> zeroDM;
+        std::vector<float> weights;
+        std::vector<float> channelMeans;
+        std::vector<uint8_t> clipped;
+
+        std::size_t nSamplesSeen;
+        std::size_t nSamplesClipped;
+
+        template <typename DTYPE>
+        void applyOfType(std::size_t nSamples, DTYPE *data, float maxValue);
+
+    public:
+        static const std::size_t SAMPLES_PER_CHUNK = 1024;
+
+        /**
+         * @brief Constructs a ZeroDMFilter object.
+         *
+         * @param nChans The number of channels.
+         * @param subtractZeroDM Whether to subtract the zero-DM time series.
+         * @param clipSigma The number of robust sigmas above which time samples are clipped (0 = no clipping).
+         * @param nThreads The number of threads (0 = all cores).
+         */
+        ZeroDMFilter(unsigned int nChans, bool subtractZeroDM, float clipSigma, unsigned int nThreads);
+
+        /**
+         * @brief Filters nSamples time samples of inNBits (8, 16 or 32) bits per channel in place.
+         *
+         * @param mask 1 for the channels that make up the zero-DM time series, 0 for the masked ones.
+         */
+        void apply(std::size_t nSamples, uint8_t *data, unsigned int inNBits, const std::vector<DEDISP_BOOL> &mask);
+
+        std::size_t getNSamplesClipped() const {
+            return nSamplesClipped;
+        }
+
+        std::size_t getNSamplesSeen() const {
+            return nSamplesSeen;
+        }
+    };
+
+};
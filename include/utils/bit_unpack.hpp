@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "utils/thread_pool.hpp"
+
+namespace UTILS {
+
+    /**
+     * @brief Unpacks 1, 2 or 4 bit samples to one byte per sample.
+     *
+     * Samples are stored least significant bits first, as written by sigproc, so byte b of a 2 bit file holds samples
+     * (b & 3), (b >> 2) & 3, (b >> 4) & 3 and (b >> 6) & 3 in that order. The widest of AVX-512, AVX2 and SSE2 supported
+     * by the CPU is picked at runtime, with a lookup table for the remainder and for other architectures.
+     *
+     * @param packed The packed input.
+     * @param nBytes The number of packed bytes.
+     * @param nBits The number of bits per sample: 1, 2 or 4.
+     * @param unpacked The output, nBytes * 8 / nBits bytes long.
+     * @param threadPool If given, large inputs are split across its threads.
+     */
+    void unpackBits(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked, ThreadPool *threadPool = nullptr);
+
+    /**
+     * @brief Name of the instruction set unpackBits() uses on this CPU, e.g. "avx2".
+     */
+    std::string unpackBitsISA();
+
+};
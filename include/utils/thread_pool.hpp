@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace UTILS {
+
+    /**
+     * @brief Fixed-size pool of worker threads.
+     *
+     * Jobs are queued with submit() and picked up by the first idle worker. parallelFor() splits an index range
+     * into contiguous chunks, runs them on the pool and blocks until every chunk is done.
+     */
+    class ThreadPool
+    {
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> jobs;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        bool stopping;
+
+        void workerLoop();
+
+    public:
+        /**
+         * @brief Constructs a ThreadPool object.
+         *
+         * @param nThreads The number of worker threads. 0 uses all hardware threads.
+         */
+        explicit ThreadPool(unsigned int nThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        unsigned int getNThreads() const {
+            return workers.size();
+        }
+
+        /**
+         * @brief Queues a job on the pool.
+         *
+         * @param job The callable to run.
+         * @return A future that becomes ready when the job has finished, and rethrows any exception it raised.
+         */
+        template <typename F>
+        std::future<void> submit(F &&job) {
+            auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(job));
+            std::future<void> result = task->get_future();
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                jobs.emplace([task]() { (*task)(); });
+            }
+            queueCondition.notify_one();
+            return result;
+        }
+
+        /**
+         * @brief Runs fn(chunkStart, chunkEnd) over [begin, end) split into chunks, and waits for all of them.
+         *
+         * @param begin The first index.
+         * @param end One past the last index.
+         * @param fn The callable to run for each chunk.
+         * @param minChunk The smallest chunk worth handing to a thread.
+         */
+        void parallelFor(std::size_t begin, std::size_t end, const std::function<void(std::size_t, std::size_t)> &fn, std::size_t minChunk = 1);
+    };
+
+    unsigned int resolveNThreads(unsigned int nThreads);
+
+};
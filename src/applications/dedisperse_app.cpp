@@ -2,17 +2,28 @@
 #include "data/search_mode_file.hpp"
 #include "utils/gen_utils.hpp"
 #include "operations/dedisperse.hpp"
+#include "operations/periodicity_search.hpp"
+#include "operations/acceleration_search.hpp"
+#include "operations/fourier_domain_search.hpp"
+#include "operations/barycentre.hpp"
+#include "operations/memory_planner.hpp"
+#include "operations/single_pulse_search.hpp"
+#include "operations/candidate_sifter.hpp"
+#include "data/candidate_table.hpp"
 #include "data/sigproc_filterbank.hpp"
 #include "data/presto_timeseries.hpp"
 #include "utils/app_utils.hpp"
 #include "exceptions.hpp"
 #include "data/multi_timeseries.hpp"
+#include "data/gulp_prefetcher.hpp"
 #include "applications/common_arguments.hpp"
 #include "tclap/CmdLine.h"
 #include <vector>
 #include <cassert>
 #include <memory>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 
 TCLAP::CmdLine APP::ArgsBase::cmd("dedisperse", ' ', "0.1");
 
@@ -27,27 +38,51 @@ int main(int argc, char ** argv){
      
 
     std::shared_ptr<IO::SearchModeFile> searchModeFile = IO::SearchModeFile::createInstance(args.inputFile, READ, args.inputFormat);
+    if (args.useMmap) searchModeFile->enableMemoryMap();
+    searchModeFile->setNReadThreads(args.numThreads);
 
 
 
     std::shared_ptr<std::vector<float>> fullDmList = std::make_shared<std::vector<float>>();
      if(!args.dmFile.empty() && fileExists(args.dmFile)) OPS::Dedisperser::populateDMList(fullDmList, args.dmFile);
      else OPS::Dedisperser::populateDMList(fullDmList, args.dmStart, args.dmEnd, args.dmPulseWidth, args.dmTol, 
-                            searchModeFile->getValueForKey<float>(TSAMP),searchModeFile->getValueForKey<float>(FCH1),
-                            searchModeFile->getValueForKey<float>(FOFF), searchModeFile->getValueForKey<int>(NCHANS));
+                            searchModeFile->getHeaderFields().tsamp, searchModeFile->getHeaderFields().fch1,
+                            searchModeFile->getHeaderFields().foff, searchModeFile->getHeaderFields().nChans);
 
 
     std::unique_ptr<OPS::Dedisperser> dedisperser; 
 
-    dedisperser = std::make_unique<OPS::Dedisperser>(searchModeFile, args.numGpus, fullDmList, true, args.dedispGulp);
+    OPS::DedispersionOptions dedispOptions;
+    dedispOptions.backendName = args.backend.empty() ? OPS::DedispersionBackend::defaultBackendName() : args.backend;
+    dedispOptions.nWorkers = caseInsensitiveCompare(dedispOptions.backendName, "gpu") ? args.numGpus : args.numThreads;
+    dedispOptions.nSubbands = args.numSubbands;
+    dedispOptions.subbandSmearing = args.subbandSmearing;
+    dedisperser = std::make_unique<OPS::Dedisperser>(searchModeFile, dedispOptions, fullDmList, true, args.dedispGulp);
     std::string dataFilePrefix = args.inputFile.substr(0, args.inputFile.find_last_of("."));
     if(args.outputPrefix.empty()) args.outputPrefix = dataFilePrefix;
 
 
-    dedisperser->setOutputOptions(args.outputDir, args.outputPrefix, args.outputSuffix, args.outputFormat, searchModeFile);
+    int nChans = searchModeFile->getNChans();
 
+    if (args.normalise) {
+        /* Next to the output rather than the input, which may be on read-only storage. */
+        std::string inputName = dataFilePrefix.substr(dataFilePrefix.find_last_of('/') + 1);
+        std::string bandpassFile = args.bandpassFile.empty() ? args.outputDir + "/" + inputName + ".bandpass" : args.bandpassFile;
+        unsigned int inNBits = std::max(searchModeFile->getNBits(), static_cast<unsigned int>(BITS_PER_BYTE));
+        dedisperser->setNormaliser(std::make_shared<OPS::BandpassNormaliser>(nChans, inNBits, bandpassFile, args.numThreads));
+    }
 
-    int nChans = searchModeFile->getNChans();
+    std::shared_ptr<OPS::RFIFlagger> rfiFlagger;
+    if (args.rfiFlag) {
+        rfiFlagger = std::make_shared<OPS::RFIFlagger>(nChans, args.rfiThreshold, args.numThreads);
+        dedisperser->setRFIFlagger(rfiFlagger);
+    }
+
+    std::shared_ptr<OPS::ZeroDMFilter> zeroDMFilter;
+    if (args.zeroDM || args.clipSigma > 0) {
+        zeroDMFilter = std::make_shared<OPS::ZeroDMFilter>(nChans, args.zeroDM, args.clipSigma, args.numThreads);
+        dedisperser->setZeroDMFilter(zeroDMFilter);
+    }
 
 
     std::shared_ptr<std::vector<DEDISP_BOOL>> killmask = !args.killFile.empty() ? 
@@ -77,19 +112,125 @@ int main(int argc, char ** argv){
 
     assert(startByte + nBytesToRead <= searchModeFile->getTotalDataSize());
 
+    std::size_t nSamplesToRead = searchModeFile->bytesToSamples(nBytesToRead);
+    std::size_t maxDelaySamples = dedisperser->getMaxDelaySamples();
+    if (nSamplesToRead <= maxDelaySamples) {
+        throw InvalidInputs("The selection of " + std::to_string(nSamplesToRead) + " samples is not longer than the maximum delay of " +
+                            std::to_string(maxDelaySamples) + " samples");
+    }
+
+    dedisperser->setNSamplesToProcess(nSamplesToRead);
+    dedisperser->setOutputNBits(args.outNBits);
+    dedisperser->setOutputOptions(args.outputDir, args.outputPrefix, args.outputSuffix, args.outputFormat, searchModeFile);
+    dedisperser->setNWriterThreads(args.numWriters);
+
+    /* The search collects the time series as they are dedispersed and runs when the dedisperser finishes. */
+    std::shared_ptr<OPS::PeriodicitySearch> periodicitySearch;
+    if (args.fftSearch) {
+        OPS::PeriodicitySearchOptions searchOptions;
+        searchOptions.nHarmonics = args.fftNumHarmonics;
+        searchOptions.sigmaThreshold = args.fftSigma;
+        searchOptions.minFrequency = args.fftMinFreq;
+        searchOptions.maxFrequency = args.fftMaxFreq;
+        searchOptions.nThreads = args.numThreads;
+        std::size_t nSamplesOut = nSamplesToRead - maxDelaySamples;
+        double tsamp = searchModeFile->getHeaderFields().tsamp;
+        if (args.accelMax > 0) {
+            std::shared_ptr<OPS::AccelerationSearch> accelerationSearch =
+                std::make_shared<OPS::AccelerationSearch>(*fullDmList, nSamplesOut, tsamp, searchOptions, args.accelMax);
+            std::cout << "Acceleration search: " << accelerationSearch->getAccelerations().size() << " trials up to "
+                      << args.accelMax << " m/s^2 per DM" << std::endl;
+            periodicitySearch = accelerationSearch;
+        }
+        else if (args.zMax > 0 || args.wMax > 0) {
+            std::shared_ptr<OPS::FourierDomainSearch> fourierDomainSearch =
+                std::make_shared<OPS::FourierDomainSearch>(*fullDmList, nSamplesOut, tsamp, searchOptions, args.zMax, args.wMax);
+            std::cout << "Fourier-domain search: " << fourierDomainSearch->getNTemplates() << " templates up to z = "
+                      << args.zMax << ", w = " << args.wMax << " bins" << std::endl;
+            periodicitySearch = fourierDomainSearch;
+        }
+        else {
+            periodicitySearch = std::make_shared<OPS::PeriodicitySearch>(*fullDmList, nSamplesOut, tsamp, searchOptions);
+        }
+        if (args.whiten || !args.birdiesFile.empty()) {
+            std::vector<OPS::Birdie> birdies;
+            if (!args.birdiesFile.empty()) birdies = OPS::SpectrumCleaner::readBirdies(args.birdiesFile);
+            std::shared_ptr<OPS::SpectrumCleaner> spectrumCleaner = std::make_shared<OPS::SpectrumCleaner>(args.whiten, birdies);
+            std::cout << "Spectrum cleaning: " << (args.whiten ? "whitening, " : "") << birdies.size() << " birdies in "
+                      << spectrumCleaner->getNZapIntervals() << " zapped intervals" << std::endl;
+            periodicitySearch->setSpectrumCleaner(spectrumCleaner);
+        }
+        if (args.barycentre) {
+            const IO::HeaderFields &fields = searchModeFile->getHeaderFields();
+            if (fields.barycentric == 1) {
+                std::cout << "Barycentring: the data are already barycentric" << std::endl;
+            }
+            else {
+                if (!searchModeFile->getHeaderParam(SRC_RAJ)->inheader || !searchModeFile->getHeaderParam(SRC_DEJ)->inheader ||
+                    !searchModeFile->getHeaderParam(TSTART)->inheader) {
+                    throw InvalidInputs("Barycentring needs src_raj, src_dej and tstart in the header");
+                }
+                /* One table of added and dropped samples, shared by every DM trial. */
+                std::shared_ptr<OPS::Barycentre> barycentre = std::make_shared<OPS::Barycentre>(
+                    OPS::Barycentre::readEphemeris(args.ephemerisFile), fields.srcRaj, fields.srcDej,
+                    fields.tstart + searchModeFile->bytesToSamples(startByte) * tsamp / 86400.0, tsamp, nSamplesOut);
+                std::cout << "Barycentring: " << barycentre->getNAdded() << " samples added and " << barycentre->getNDropped()
+                          << " dropped per time series" << std::endl;
+                periodicitySearch->setBarycentre(barycentre);
+            }
+        }
+        dedisperser->addConsumer(periodicitySearch);
+    }
+
+    /* The single pulse search runs on every gulp as it is flushed, spread over the writer threads by DM. */
+    std::shared_ptr<OPS::SinglePulseSearch> singlePulseSearch;
+    if (args.spSearch) {
+        OPS::SinglePulseSearchOptions spOptions;
+        spOptions.maxWidth = args.spMaxWidth;
+        spOptions.sigmaThreshold = args.spSigma;
+        singlePulseSearch = std::make_shared<OPS::SinglePulseSearch>(*fullDmList, searchModeFile->getHeaderFields().tsamp, spOptions);
+        dedisperser->addConsumer(singlePulseSearch);
+    }
 
-    if (!args.killFile.empty()) dedisperser->setKillMask(args.killFile);
-    std::size_t gulpSize = args.gulping? args.dedispGulp: nBytesToRead;
 
+    if (!args.killFile.empty()) dedisperser->setKillMask(args.killFile);
 
+    /* Size the gulps and buffers to the RAM limit, counting the backend's working memory and what the periodicity search keeps. */
+    OPS::MemoryPlanner memoryPlanner(nChans, searchModeFile->getNBits(), fullDmList->size(), maxDelaySamples, nSamplesToRead);
+    memoryPlanner.addBackendMemory(dedisperser->getBackendMemory());
+    if (periodicitySearch) memoryPlanner.addFixedBytes(periodicitySearch->getFixedBytes());
+    std::size_t ramLimitBytes = static_cast<std::size_t>(args.ramLimitGB) * 1000000000UL;
+    OPS::MemoryPlan memoryPlan = args.gulping ? memoryPlanner.plan(ramLimitBytes, args.dedispGulp, args.readAhead, args.maxBufferedGulps)
+                                              : memoryPlanner.plan(ramLimitBytes, args.readAhead, args.maxBufferedGulps);
+    std::size_t gulpNSamples = memoryPlan.gulpNSamples;
 
-    if (gulpSize < 2 * dedisperser->getMaxDelaySamples()){
+    if (memoryPlan.gulping && gulpNSamples < 2 * maxDelaySamples){
         throw InvalidInputs("Gulp size is smaller than 2 *  maximum delay");
     }
+    dedisperser->setGulpNSamples(gulpNSamples);
+    dedisperser->setMaxBufferedGulps(memoryPlan.maxBufferedGulps);
+    if (memoryPlan.gulping) {
+        std::cout << "Memory plan: gulps of " << gulpNSamples << " samples, " << memoryPlan.readAhead << " read ahead, "
+                  << memoryPlan.maxBufferedGulps << " dedispersed gulps buffered";
+    }
+    else {
+        std::cout << "Memory plan: all " << gulpNSamples << " samples in one gulp";
+    }
+    std::ostringstream planGB;
+    planGB << std::fixed << std::setprecision(2) << memoryPlan.bytes / 1e9;
+    std::cout << ", about " << planGB.str() << " GB of the " << args.ramLimitGB << " GB limit" << std::endl;
 
-    std::size_t nSamplesToRead = searchModeFile->bytesToSamples(nBytesToRead);
+    /* Gulps are contiguous and never overlap on disk: the dedisperser carries the max-delay tail between them. */
+    std::size_t gulpSize = searchModeFile->samplesToBytes(gulpNSamples);
     std::size_t bytesRead = 0;
 
+    /* Read the following gulps in the background while the current one is dedispersed. A mapped file is read ahead
+       by the kernel instead. */
+    if (memoryPlan.gulping && memoryPlan.readAhead > 0 && !args.useMmap) {
+        dedisperser->setPrefetcher(std::make_shared<IO::GulpPrefetcher>(args.inputFile, args.inputFormat, startByte, nBytesToRead,
+                                                                        gulpSize, memoryPlan.readAhead, args.numThreads));
+    }
+
     while (bytesRead < nBytesToRead){
 
 
@@ -99,26 +240,71 @@ int main(int argc, char ** argv){
         dedisperser->dedisperse(startByte + bytesRead, bytesToRead);
         bytesRead += bytesToRead;     
 
-        searchModeFile->clearBuffer();
-
         
 
     }
 
-    
-    
+    dedisperser->finish();
+
+    if (rfiFlagger) {
+        std::ostringstream percentage;
+        percentage << std::fixed << std::setprecision(1) << 100.0f * rfiFlagger->getTotalFlaggedFraction();
+        std::cout << "RFI: flagged " << percentage.str() << "% of the channels over " << rfiFlagger->getNGulps() << " gulps" << std::endl;
+    }
+    if (args.outNBits < 32 && !caseInsensitiveCompare(args.outputFormat, "none")) {
+        std::size_t nClipped = dedisperser->getNOutputSamplesClipped();
+        std::cout << "Quantisation: " << nClipped << " of " << fullDmList->size() * (nSamplesToRead - maxDelaySamples)
+                  << " output samples clipped to the " << args.outNBits << " bit levels fitted to the first gulp"
+                  << std::endl;
+    }
+    if (zeroDMFilter && args.clipSigma > 0) {
+        std::cout << "Clipped " << zeroDMFilter->getNSamplesClipped() << " of " << zeroDMFilter->getNSamplesSeen()
+                  << " time samples" << std::endl;
+    }
+    if (periodicitySearch) {
+        std::string candidatesFile = args.outputDir + "/" + args.outputPrefix + ".fftcands";
+        periodicitySearch->writeCandidates(candidatesFile);
+        std::cout << "Periodicity search: " << periodicitySearch->getCandidates().size() << " candidates above "
+                  << args.fftSigma << " sigma written to " << candidatesFile << std::endl;
+    }
+    if (singlePulseSearch) {
+        std::string eventsFile = args.outputDir + "/" + args.outputPrefix + ".singlepulse";
+        singlePulseSearch->writeEvents(eventsFile);
+        std::cout << "Single pulse search: " << singlePulseSearch->getEvents().size() << " events above "
+                  << args.spSigma << " sigma written to " << eventsFile << std::endl;
+    }
 
+    if (args.sift && (periodicitySearch || singlePulseSearch)) {
+        OPS::SiftingOptions siftingOptions;
+        siftingOptions.dmLink = args.siftDmLink;
+        siftingOptions.sampleLink = args.siftTimeLink;
+        siftingOptions.frequencyLink = args.siftFreqLink;
+        OPS::CandidateSifter sifter(*fullDmList, siftingOptions);
+        double tsamp = searchModeFile->getHeaderFields().tsamp;
+        double observationLength = (nSamplesToRead - maxDelaySamples) * tsamp;
+
+        if (periodicitySearch) {
+            std::vector<IO::PeriodicityRecord> sifted = sifter.sift(periodicitySearch->getCandidates(), periodicitySearch->getObservationLength());
+            std::string tableFile = args.outputDir + "/" + args.outputPrefix + ".fftcands.bin";
+            IO::CandidateTable::write(tableFile, sifted, tsamp, periodicitySearch->getObservationLength());
+            std::cout << "Sifting: " << periodicitySearch->getCandidates().size() << " periodicity candidates in "
+                      << sifted.size() << " clusters written to " << tableFile << std::endl;
+        }
+        if (singlePulseSearch) {
+            std::vector<IO::SinglePulseRecord> sifted = sifter.sift(singlePulseSearch->getEvents());
+            std::string tableFile = args.outputDir + "/" + args.outputPrefix + ".singlepulse.bin";
+            IO::CandidateTable::write(tableFile, sifted, tsamp, observationLength);
+            std::cout << "Sifting: " << singlePulseSearch->getEvents().size() << " single pulses in "
+                      << sifted.size() << " clusters written to " << tableFile << std::endl;
+        }
+    }
 
+    
+    
 
 
-    // std::size_t nSamplesToRead = searchModeFile->bytesToSamples(nBytesToRead);
 
-    // std::size_t sizeOfDedispOutput = nSamplesToRead * fullDmList.size() * sizeof(DEDISP_OUTPUT_TYPE);
-    // std::size_t ramLimit = args.ramLimitGB * 1e9;
 
-    // if (ramLimit < sizeOfDedispOutput){
-    //     throw std::runtime_error("RAM limit is smaller than the size of the dedispersed data");
-    // }
     
 
 
@@ -0,0 +1,112 @@
+#include "applications/fold_app.hpp"
+#include "data/search_mode_file.hpp"
+#include "data/gulp_prefetcher.hpp"
+#include "operations/folder.hpp"
+#include "exceptions.hpp"
+#include "tclap/CmdLine.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+TCLAP::CmdLine APP::ArgsBase::cmd("fold", ' ', "0.1");
+
+
+int main(int argc, char ** argv){
+
+    FoldCommandArgs args;
+    APP::ArgsBase::parseAll(argc, argv);
+
+    std::shared_ptr<IO::SearchModeFile> searchModeFile = IO::SearchModeFile::createInstance(args.inputFile, READ, args.inputFormat);
+    if (args.useMmap) searchModeFile->enableMemoryMap();
+    searchModeFile->setNReadThreads(args.numThreads);
+
+    std::vector<OPS::FoldCandidate> candidates = OPS::Folder::readCandidates(args.candidatesFile);
+    if (candidates.empty()) throw InvalidInputs("No candidates to fold in " + args.candidatesFile);
+
+    std::size_t nBytesToRead = 0;
+    std::size_t startByte = 0;
+
+    if(args.selectionUnits == BYTES) {
+        nBytesToRead = args.nBytes;
+        startByte = args.startByte;
+
+    } else if(args.selectionUnits == SECONDS) {
+        nBytesToRead = searchModeFile->timeToBytes(args.nSecs);
+        startByte = searchModeFile->timeToBytes(args.startSec);
+
+    } else if(args.selectionUnits == SAMPLES) {
+        nBytesToRead = searchModeFile->samplesToBytes(args.nSamps);
+        startByte = searchModeFile->samplesToBytes(args.startSample);
+
+    } else if(args.selectionUnits == NULL_STR) {
+        nBytesToRead = searchModeFile->getTotalDataSize();
+        startByte = 0;
+    }
+
+    if (startByte + nBytesToRead > searchModeFile->getTotalDataSize()) {
+        throw InvalidInputs("The selected range runs past the end of the file");
+    }
+
+    /* sub-byte data are unpacked to one byte per sample on read */
+    unsigned int inNBits = std::max(searchModeFile->getNBits(), static_cast<unsigned int>(BITS_PER_BYTE));
+    std::size_t nSamplesToFold = searchModeFile->bytesToSamples(nBytesToRead);
+
+    OPS::FoldingOptions foldingOptions;
+    foldingOptions.nBins = args.numBins;
+    foldingOptions.nSubints = args.numSubints;
+    foldingOptions.nSubbands = args.numSubbands;
+    foldingOptions.nThreads = args.numThreads;
+    const IO::HeaderFields &fields = searchModeFile->getHeaderFields();
+    OPS::Folder folder(candidates, foldingOptions, searchModeFile->getNChans(), fields.fch1, fields.foff, nSamplesToFold, fields.tsamp);
+    std::cout << "Folding " << candidates.size() << " candidates over " << nSamplesToFold << " samples" << std::endl;
+
+    /* Every gulp is read once and folded into all candidates before the next one is taken. */
+    std::size_t gulpSize = searchModeFile->samplesToBytes(std::min(args.foldGulp, nSamplesToFold));
+    std::shared_ptr<IO::GulpPrefetcher> prefetcher;
+    if (args.readAhead > 0 && !args.useMmap) {
+        prefetcher = std::make_shared<IO::GulpPrefetcher>(args.inputFile, args.inputFormat, startByte, nBytesToRead,
+                                                          gulpSize, args.readAhead, args.numThreads);
+    }
+
+    std::size_t bytesRead = 0;
+    while (bytesRead < nBytesToRead){
+        std::size_t bytesToRead = std::min(nBytesToRead - bytesRead, gulpSize);
+
+        std::shared_ptr<IO::DataBufferBase> gulpBuffer;
+        if (prefetcher) {
+            gulpBuffer = prefetcher->next(startByte + bytesRead, bytesToRead);
+        }
+        else {
+            searchModeFile->readNBytes(startByte + bytesRead, bytesToRead);
+            gulpBuffer = searchModeFile->container;
+        }
+
+        folder.fold(searchModeFile->bytesToSamples(bytesRead), searchModeFile->bytesToSamples(bytesToRead),
+                    static_cast<const uint8_t *>(gulpBuffer->getData()), inNBits);
+        if (prefetcher) prefetcher->release(gulpBuffer);
+        bytesRead += bytesToRead;
+    }
+
+    std::string dataFilePrefix = args.inputFile.substr(0, args.inputFile.find_last_of("."));
+    if(args.outputPrefix.empty()) args.outputPrefix = dataFilePrefix.substr(dataFilePrefix.find_last_of("/") + 1);
+
+    std::string foldFile = args.outputDir + "/" + args.outputPrefix + ".folds";
+    folder.write(foldFile);
+
+    std::string summaryFile = args.outputDir + "/" + args.outputPrefix + ".foldcands";
+    std::ofstream summary(summaryFile);
+    if (!summary.is_open()) throw FileIOError(0, 0, "open " + summaryFile);
+    summary << "# index period(ms) DM acceleration(m/s^2) snr" << std::endl;
+    const std::vector<std::unique_ptr<OPS::CandidateFold>> &folds = folder.getFolds();
+    for (std::size_t i = 0; i < folds.size(); i++) {
+        const OPS::FoldCandidate &candidate = folds[i]->getCandidate();
+        summary << i << " " << std::fixed << std::setprecision(9) << 1000.0 * candidate.period << " " << std::setprecision(3)
+                << candidate.dm << " " << candidate.acceleration << " " << std::setprecision(2) << folds[i]->getProfileSNR() << std::endl;
+    }
+    std::cout << "Folded cubes written to " << foldFile << ", profile significances to " << summaryFile << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "data/candidate_table.hpp"
+#include "utils/gen_utils.hpp"
+#include "exceptions.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+using namespace IO;
+
+const char CandidateTable::MAGIC[8] = {'P', 'S', 'R', 'C', 'A', 'N', 'D', '1'};
+
+namespace {
+
+    typedef std::unique_ptr<FILE, int (*)(FILE *)> FilePtr;
+
+    FilePtr openFile(const std::string &fileName, const char *mode) {
+        FilePtr file(fopen(fileName.c_str(), mode), fclose);
+        if (!file) throw FileIOError(0, 0, "open " + fileName);
+        return file;
+    }
+
+    bool isValidHeader(const CandidateTableHeader &header, uint32_t kind, std::size_t recordBytes) {
+        return std::memcmp(header.magic, CandidateTable::MAGIC, sizeof(CandidateTable::MAGIC)) == 0 && header.kind == kind &&
+               header.recordBytes == recordBytes;
+    }
+
+};
+
+template <typename RECORD>
+void CandidateTable::write(const std::string &fileName, uint32_t kind, const std::vector<RECORD> &records, double tsamp,
+                           double observationLength) {
+    CandidateTableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.kind = kind;
+    header.recordBytes = sizeof(RECORD);
+    header.nRecords = records.size();
+    header.tsamp = tsamp;
+    header.observationLength = observationLength;
+
+    FilePtr file = openFile(fileName, "wb");
+    writeToFileAndVerify<CandidateTableHeader>(file.get(), 1, &header);
+    writeToFileAndVerify<const RECORD>(file.get(), records.size(), records.data());
+    if (fflush(file.get()) != 0) throw FileIOError(0, 0, "flush " + fileName);
+}
+
+template <typename RECORD>
+CandidateTableHeader CandidateTable::read(const std::string &fileName, uint32_t kind, std::vector<RECORD> &records) {
+    FilePtr file = openFile(fileName, "rb");
+    CandidateTableHeader header;
+    readFromFileAndVerify<CandidateTableHeader>(file.get(), 1, &header);
+    if (!isValidHeader(header, kind, sizeof(RECORD))) throw FileFormatNotRecognised(fileName);
+    records.resize(header.nRecords);
+    readFromFileAndVerify<RECORD>(file.get(), records.size(), records.data());
+    return header;
+}
+
+template <typename RECORD>
+CandidateTableHeader CandidateTable::parse(const std::string &data, const std::string &name, uint32_t kind, std::vector<RECORD> &records) {
+    CandidateTableHeader header;
+    if (data.size() < sizeof(header)) throw FileIOError(sizeof(header), data.size(), "read");
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!isValidHeader(header, kind, sizeof(RECORD))) throw FileFormatNotRecognised(name);
+
+    std::size_t recordsBytes = data.size() - sizeof(header);
+    if (recordsBytes / sizeof(RECORD) < header.nRecords) throw FileIOError(header.nRecords * sizeof(RECORD), recordsBytes, "read");
+    records.resize(header.nRecords);
+    std::memcpy(records.data(), data.data() + sizeof(header), records.size() * sizeof(RECORD));
+    return header;
+}
+
+void CandidateTable::write(const std::string &fileName, const std::vector<SinglePulseRecord> &records, double tsamp,
+                           double observationLength) {
+    write<SinglePulseRecord>(fileName, SINGLE_PULSE, records, tsamp, observationLength);
+}
+
+void CandidateTable::write(const std::string &fileName, const std::vector<PeriodicityRecord> &records, double tsamp,
+                           double observationLength) {
+    write<PeriodicityRecord>(fileName, PERIODICITY, records, tsamp, observationLength);
+}
+
+CandidateTableHeader CandidateTable::read(const std::string &fileName, std::vector<SinglePulseRecord> &records) {
+    return read<SinglePulseRecord>(fileName, SINGLE_PULSE, records);
+}
+
+CandidateTableHeader CandidateTable::read(const std::string &fileName, std::vector<PeriodicityRecord> &records) {
+    return read<PeriodicityRecord>(fileName, PERIODICITY, records);
+}
+
+CandidateTableHeader CandidateTable::parse(const std::string &data, const std::string &name, std::vector<PeriodicityRecord> &records) {
+    return parse<PeriodicityRecord>(data, name, PERIODICITY, records);
+}
@@ -0,0 +1,327 @@
+#include "data/dm_time_cube.hpp"
+#include "utils/gen_utils.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+using namespace IO;
+
+const char DMTimeCube::MAGIC[8] = {'D', 'M', 'C', 'U', 'B', 'E', '0', '1'};
+
+DMTimeCube::DMTimeCube(std::string fileName, std::string mode) : SearchModeFile(fileName, mode) {
+    this->headerFileName = fileName;
+    this->headerFileOpenMode = mode;
+    this->blockNSamples = DEFAULT_BLOCK_NSAMPLES;
+    this->totalNSamples = 0;
+    this->outputNBits = sizeof(DEDISP_OUTPUT_TYPE) * BITS_PER_BYTE;
+    this->blockFill = 0;
+    this->nSamplesAppended = 0;
+    this->nSamplesClipped = 0;
+    this->finalised = false;
+
+    if (mode == READ) {
+        readHeader();
+        this->nBytesOnDisk = this->dataBytes;
+        this->nBytesOnRam = this->dataBytes;
+    }
+}
+
+DMTimeCube::~DMTimeCube() {
+    if (dataFileOpenMode == WRITE && dataFileOpen && !finalised) {
+        try {
+            finalise();
+        }
+        catch (const std::exception &e) {
+            std::cerr << "Could not finalise " << dataFileName << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+bool DMTimeCube::isHeaderSeparate() {
+    return false;
+}
+
+void DMTimeCube::readHeader() {
+    openDataFile();
+    rewind(dataFile);
+
+    DMTimeCubeHeader header;
+    readFromFileAndVerify<DMTimeCubeHeader>(dataFile, 1, &header);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw FileFormatNotRecognised(dataFileName);
+    }
+
+    dmList.resize(header.nDMs);
+    readFromFileAndVerify<float>(dataFile, header.nDMs, dmList.data());
+
+    this->outputNBits = header.nBits;
+    if (outputNBits != 8 && outputNBits != 16 && outputNBits != 32) throw FileFormatNotRecognised(dataFileName);
+    if (outputNBits < 32) {
+        std::vector<float> offsets(header.nDMs), scales(header.nDMs);
+        readFromFileAndVerify<float>(dataFile, header.nDMs, offsets.data());
+        readFromFileAndVerify<float>(dataFile, header.nDMs, scales.data());
+        quantParams.resize(header.nDMs);
+        for (std::size_t iDM = 0; iDM < header.nDMs; iDM++) {
+            quantParams[iDM].offset = offsets[iDM];
+            quantParams[iDM].scale = scales[iDM];
+        }
+    }
+
+    this->headerBytes = header.headerBytes;
+    this->totalNSamples = header.nSamples;
+    this->blockNSamples = header.blockNSamples;
+
+    struct stat fileStat;
+    if (fstat(fileno(dataFile), &fileStat) < 0) throw FileIOError(headerBytes, 0, "stat");
+    this->dataBytes = fileStat.st_size - headerBytes;
+
+    this->nChans = header.nDMs;
+    this->nBits = header.nBits;
+    this->nSamps = header.nSamples;
+    this->tsamp = header.tsamp;
+    this->fch1 = header.fch1;
+    this->foff = header.foff;
+
+    addToHeader<int>(NCHANS, INT, header.nDMs);
+    addToHeader<int>(NBITS, INT, header.nBits);
+    addToHeader<int>(NIFS, INT, 1);
+    addToHeader<long>(NSAMPLES, LONG, header.nSamples);
+    addFloatToHeader(TSAMP, header.tsamp);
+    addFloatToHeader(TSTART, header.tstart);
+    addFloatToHeader(FCH1, header.fch1);
+    addFloatToHeader(FOFF, header.foff);
+    addFloatToHeader(SRC_RAJ, header.srcRaj);
+    addFloatToHeader(SRC_DEJ, header.srcDej);
+    addToHeader<int>(TELESCOPE_ID, INT, header.telescopeId);
+    addToHeader<int>(MACHINE_ID, INT, header.machineId);
+    addToHeader<int>(BARYCENTRIC, INT, header.barycentric);
+}
+
+void DMTimeCube::writeHeader() {
+    if (dmList.empty()) throw InvalidInputs("Set the DM list before writing a DM-time cube header");
+
+    DMTimeCubeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+
+    std::size_t unpadded = getQuantisationOffset();
+    if (outputNBits < 32) unpadded += 2 * dmList.size() * sizeof(float);
+    header.headerBytes = (unpadded + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    header.nSamples = totalNSamples;
+    header.blockNSamples = blockNSamples;
+    header.nDMs = dmList.size();
+    header.nBits = outputNBits;
+    const HeaderFields &fields = getHeaderFields();
+    header.telescopeId = getValueOrDefaultForKey<int>(TELESCOPE_ID, 0);
+    header.machineId = getValueOrDefaultForKey<int>(MACHINE_ID, 0);
+    header.barycentric = getValueOrDefaultForKey<int>(BARYCENTRIC, 0);
+    header.tsamp = fields.tsamp;
+    header.tstart = fields.tstart;
+    header.fch1 = fields.fch1;
+    header.foff = fields.foff;
+    header.srcRaj = fields.srcRaj;
+    header.srcDej = fields.srcDej;
+    this->headerBytes = header.headerBytes;
+
+    openDataFile();
+    rewind(dataFile);
+    std::vector<uint8_t> headerData(headerBytes, 0);
+    std::memcpy(headerData.data(), &header, sizeof(header));
+    std::memcpy(headerData.data() + sizeof(header), dmList.data(), dmList.size() * sizeof(float));
+    /* The offsets and scales are left as zeros until the first gulp is appended. */
+    writeToFileAndVerify<uint8_t>(dataFile, headerData.size(), headerData.data());
+}
+
+void DMTimeCube::setDMList(const std::vector<float> &dmList) {
+    this->dmList = dmList;
+}
+
+void DMTimeCube::setTotalNSamples(std::size_t totalNSamples) {
+    this->totalNSamples = totalNSamples;
+}
+
+void DMTimeCube::setBlockNSamples(std::size_t blockNSamples) {
+    if (blockNSamples == 0) throw InvalidInputs("DM-time cube blocks must hold at least one sample");
+    this->blockNSamples = blockNSamples;
+}
+
+void DMTimeCube::setOutputNBits(unsigned int nBits) {
+    if (nBits != 8 && nBits != 16 && nBits != 32) throw InvalidInputs("DM-time cubes hold 8, 16 or 32 bit samples");
+    this->outputNBits = nBits;
+}
+
+QuantisationParams DMTimeCube::getQuantisation(std::size_t iDM) {
+    if (outputNBits == 32) return QuantisationParams();
+    if (iDM >= quantParams.size()) throw InvalidInputs("DM out of range or quantisation not fitted yet");
+    return quantParams[iDM];
+}
+
+std::size_t DMTimeCube::getQuantisationOffset() {
+    return sizeof(DMTimeCubeHeader) + dmList.size() * sizeof(float);
+}
+
+std::size_t DMTimeCube::getNBlocks() {
+    return (totalNSamples + blockNSamples - 1) / blockNSamples;
+}
+
+std::size_t DMTimeCube::getBlockLength(std::size_t iBlock) {
+    return std::min(blockNSamples, totalNSamples - iBlock * blockNSamples);
+}
+
+std::size_t DMTimeCube::getBlockOffset(std::size_t iBlock) {
+    return headerBytes + iBlock * blockNSamples * dmList.size() * outputNBits / BITS_PER_BYTE;
+}
+
+void DMTimeCube::fitAndWriteQuantisation(const DEDISP_OUTPUT_TYPE *gulp, std::size_t nSamples) {
+    std::size_t nDMs = dmList.size();
+    quantParams.resize(nDMs);
+    std::vector<float> offsets(nDMs), scales(nDMs);
+    for (std::size_t iDM = 0; iDM < nDMs; iDM++) {
+        quantParams[iDM] = fitQuantisation(gulp + iDM * nSamples, nSamples, outputNBits);
+        offsets[iDM] = quantParams[iDM].offset;
+        scales[iDM] = quantParams[iDM].scale;
+    }
+
+    fseek(dataFile, getQuantisationOffset(), SEEK_SET);
+    writeToFileAndVerify<float>(dataFile, nDMs, offsets.data());
+    writeToFileAndVerify<float>(dataFile, nDMs, scales.data());
+    fseek(dataFile, 0, SEEK_END);
+}
+
+void DMTimeCube::appendSamples(const DEDISP_OUTPUT_TYPE *gulp, std::size_t nSamples) {
+    std::size_t nDMs = dmList.size();
+    if (blockData.size() < nDMs * blockNSamples) blockData.resize(nDMs * blockNSamples);
+    if (outputNBits < 32 && quantParams.empty() && nSamples > 0) fitAndWriteQuantisation(gulp, nSamples);
+
+    std::size_t done = 0;
+    while (done < nSamples) {
+        std::size_t n = std::min(nSamples - done, blockNSamples - blockFill);
+        for (std::size_t iDM = 0; iDM < nDMs; iDM++) {
+            std::memcpy(blockData.data() + iDM * blockNSamples + blockFill, gulp + iDM * nSamples + done, n * sizeof(DEDISP_OUTPUT_TYPE));
+        }
+        blockFill += n;
+        done += n;
+        if (blockFill == blockNSamples) writeBlock(blockNSamples);
+    }
+    nSamplesAppended += nSamples;
+}
+
+/* Blocks are written in order, so the file position is always at the start of the next block. */
+void DMTimeCube::writeBlock(std::size_t nSamplesInBlock) {
+    std::size_t nDMs = dmList.size();
+    if (outputNBits == 32 && nSamplesInBlock == blockNSamples) {
+        writeToFileAndVerify<DEDISP_OUTPUT_TYPE>(dataFile, nDMs * blockNSamples, blockData.data());
+        blockFill = 0;
+        return;
+    }
+
+    /* Quantise or compact every DM into storedBlock, so that the block is still a single write. */
+    std::size_t bytesPerDM = nSamplesInBlock * outputNBits / BITS_PER_BYTE;
+    storedBlock.resize(nDMs * bytesPerDM);
+    for (std::size_t iDM = 0; iDM < nDMs; iDM++) {
+        const DEDISP_OUTPUT_TYPE *in = blockData.data() + iDM * blockNSamples;
+        uint8_t *out = storedBlock.data() + iDM * bytesPerDM;
+        if (outputNBits == 8) nSamplesClipped += quantise<uint8_t>(in, nSamplesInBlock, quantParams[iDM], out);
+        else if (outputNBits == 16) nSamplesClipped += quantise<uint16_t>(in, nSamplesInBlock, quantParams[iDM], reinterpret_cast<uint16_t *>(out));
+        else std::memcpy(out, in, bytesPerDM);
+    }
+    writeToFileAndVerify<uint8_t>(dataFile, storedBlock.size(), storedBlock.data());
+    blockFill = 0;
+}
+
+void DMTimeCube::finalise() {
+    if (finalised) return;
+    if (blockFill > 0) writeBlock(blockFill);
+
+    /* The output may end up shorter than announced, e.g. if the input was cut short. */
+    if (nSamplesAppended != totalNSamples) {
+        totalNSamples = nSamplesAppended;
+        uint64_t nSamples = totalNSamples;
+        fseek(dataFile, offsetof(DMTimeCubeHeader, nSamples), SEEK_SET);
+        writeToFileAndVerify<uint64_t>(dataFile, 1, &nSamples);
+        fseek(dataFile, 0, SEEK_END);
+    }
+    fflush(dataFile);
+    finalised = true;
+}
+
+template <typename STORED_TYPE>
+void DMTimeCube::readRawBytesOfType(std::size_t fileByte, std::size_t nBytes) {
+    this->nBytesOnDisk = nBytes;
+    this->nBytesOnRam = nBytes;
+
+    if (mappedFile) {
+        const uint8_t *mapped = mappedFile->getBytes(fileByte, nBytes);
+        this->container = std::make_shared<DataBufferView<STORED_TYPE>>(fileByte, nBytes, reinterpret_cast<const STORED_TYPE *>(mapped), mappedFile);
+        return;
+    }
+
+    std::shared_ptr<DataBuffer<STORED_TYPE>> reusable = std::dynamic_pointer_cast<DataBuffer<STORED_TYPE>>(this->container);
+    if (reusable) reusable->resize(fileByte, nBytes);
+    else this->container = std::make_shared<DataBuffer<STORED_TYPE>>(fileByte, nBytes);
+
+    openDataFile();
+    goToByte(fileByte);
+    readFromFileAndVerify<STORED_TYPE>(dataFile, nBytes / sizeof(STORED_TYPE), static_cast<STORED_TYPE *>(container->getData()));
+}
+
+void DMTimeCube::readRawBytes(std::size_t fileByte, std::size_t nBytes) {
+    if (outputNBits == 8) readRawBytesOfType<uint8_t>(fileByte, nBytes);
+    else if (outputNBits == 16) readRawBytesOfType<uint16_t>(fileByte, nBytes);
+    else readRawBytesOfType<DEDISP_OUTPUT_TYPE>(fileByte, nBytes);
+}
+
+void DMTimeCube::readNBytes(std::size_t startByte, std::size_t nBytes) {
+    readRawBytes(headerBytes + startByte, nBytes);
+}
+
+void DMTimeCube::readAllData() {
+    readNBytes(0, dataBytes);
+}
+
+void DMTimeCube::readTimeBlock(std::size_t iBlock) {
+    if (iBlock >= getNBlocks()) throw InvalidInputs("Time block out of range");
+    readRawBytes(getBlockOffset(iBlock), getBlockLength(iBlock) * dmList.size() * outputNBits / BITS_PER_BYTE);
+}
+
+void DMTimeCube::readDM(std::size_t iDM, std::size_t startSample, std::size_t nSamples, DEDISP_OUTPUT_TYPE *out) {
+    if (iDM >= dmList.size() || startSample + nSamples > totalNSamples) {
+        throw InvalidInputs("DM or sample range out of the DM-time cube");
+    }
+    if (!mappedFile) openDataFile();
+
+    QuantisationParams params = getQuantisation(iDM);
+    std::size_t bytesPerSample = outputNBits / BITS_PER_BYTE;
+    std::vector<uint8_t> stored;
+    std::size_t done = 0;
+    while (done < nSamples) {
+        std::size_t sample = startSample + done;
+        std::size_t iBlock = sample / blockNSamples;
+        std::size_t blockLength = getBlockLength(iBlock);
+        std::size_t inBlock = sample - iBlock * blockNSamples;
+        std::size_t n = std::min(nSamples - done, blockLength - inBlock);
+        std::size_t fileByte = getBlockOffset(iBlock) + (iDM * blockLength + inBlock) * bytesPerSample;
+
+        if (mappedFile) {
+            dequantiseFromBytes(mappedFile->getBytes(fileByte, n * bytesPerSample), n, outputNBits, params, out + done);
+        }
+        else if (outputNBits == 32) {
+            goToByte(fileByte);
+            readFromFileAndVerify<DEDISP_OUTPUT_TYPE>(dataFile, n, out + done);
+        }
+        else {
+            stored.resize(n * bytesPerSample);
+            goToByte(fileByte);
+            readFromFileAndVerify<uint8_t>(dataFile, stored.size(), stored.data());
+            dequantiseFromBytes(stored.data(), n, outputNBits, params, out + done);
+        }
+        done += n;
+    }
+}
+
+void DMTimeCube::writeNBytes() {
+    throw FunctionalityNotImplemented("Writing raw bytes to a DM-time cube; use appendSamples()");
+}
+
+void DMTimeCube::writeAllData() {}
@@ -0,0 +1,115 @@
+#include "data/gulp_prefetcher.hpp"
+#include "data/constants.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <sstream>
+
+#ifdef USE_CUDA
+#include <cuda_runtime.h>
+#endif
+
+using namespace IO;
+
+GulpPrefetcher::GulpPrefetcher(std::string fileName, std::string fileType, std::size_t startByte, std::size_t nBytes,
+                               std::size_t gulpBytes, unsigned int nBuffers, unsigned int nReadThreads) {
+    if (gulpBytes == 0) throw InvalidInputs("Prefetch gulp size cannot be zero");
+    if (nBuffers == 0) throw InvalidInputs("Prefetching needs at least one buffer");
+
+    for (std::size_t offset = 0; offset < nBytes; offset += gulpBytes) {
+        gulps.push_back({startByte + offset, std::min(gulpBytes, nBytes - offset)});
+    }
+    this->nextGulp = 0;
+    this->stopping = false;
+    this->freeBuffers.assign(nBuffers, nullptr);
+
+    this->reader = SearchModeFile::createInstance(fileName, READ, fileType);
+    this->reader->setNReadThreads(nReadThreads);
+    this->worker = std::thread(&GulpPrefetcher::readLoop, this);
+}
+
+GulpPrefetcher::~GulpPrefetcher() {
+    {
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        stopping = true;
+    }
+    bufferCondition.notify_all();
+    if (worker.joinable()) worker.join();
+
+#ifdef USE_CUDA
+    for (void *region : pinnedRegions) cudaHostUnregister(region);
+#endif
+}
+
+void GulpPrefetcher::readLoop() {
+    try {
+        for (const Gulp &gulp : gulps) {
+            std::shared_ptr<DataBufferBase> buffer;
+            {
+                std::unique_lock<std::mutex> lock(bufferMutex);
+                bufferCondition.wait(lock, [this] { return stopping || !freeBuffers.empty(); });
+                if (stopping) return;
+                buffer = freeBuffers.front();
+                freeBuffers.pop_front();
+            }
+
+            /* A recycled buffer is refilled in place; an empty slot makes the reader allocate one. */
+            reader->container = buffer;
+            reader->readNBytes(gulp.startByte, gulp.nBytes);
+            buffer = reader->container;
+            reader->container = nullptr;
+            pin(buffer);
+
+            {
+                std::unique_lock<std::mutex> lock(bufferMutex);
+                readyBuffers.push_back(buffer);
+            }
+            bufferCondition.notify_all();
+        }
+    }
+    catch (...) {
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex);
+            readError = std::current_exception();
+        }
+        bufferCondition.notify_all();
+    }
+}
+
+void GulpPrefetcher::pin([[maybe_unused]] const std::shared_ptr<DataBufferBase> &buffer) {
+#ifdef USE_CUDA
+    void *region = buffer->getData();
+    if (std::find(pinnedRegions.begin(), pinnedRegions.end(), region) != pinnedRegions.end()) return;
+    if (cudaHostRegister(region, buffer->getNBytes(), cudaHostRegisterDefault) == cudaSuccess) {
+        pinnedRegions.push_back(region);
+    }
+#endif
+}
+
+std::shared_ptr<DataBufferBase> GulpPrefetcher::next(std::size_t startByte, std::size_t nBytes) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (nextGulp == gulps.size()) throw InvalidInputs("No gulps left to prefetch");
+
+    const Gulp &expected = gulps[nextGulp];
+    if (expected.startByte != startByte || expected.nBytes != nBytes) {
+        std::ostringstream msg;
+        msg << "Requested gulp (" << startByte << ", " << nBytes << ") does not match the prefetched gulp ("
+            << expected.startByte << ", " << expected.nBytes << ")";
+        throw InvalidInputs(msg.str());
+    }
+
+    bufferCondition.wait(lock, [this] { return !readyBuffers.empty() || readError; });
+    if (readyBuffers.empty()) std::rethrow_exception(readError);
+
+    std::shared_ptr<DataBufferBase> buffer = readyBuffers.front();
+    readyBuffers.pop_front();
+    nextGulp++;
+    return buffer;
+}
+
+void GulpPrefetcher::release(std::shared_ptr<DataBufferBase> buffer) {
+    {
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        freeBuffers.push_back(buffer);
+    }
+    bufferCondition.notify_all();
+}
@@ -0,0 +1,56 @@
+#include "data/header_fields.hpp"
+#include <cstring>
+
+using namespace IO;
+
+namespace {
+
+    template <typename T>
+    struct Field
+    {
+        const char *key;
+        T HeaderFields::*member;
+    };
+
+    /* The keys are those of data/constants.hpp. */
+    constexpr Field<int> INT_FIELDS[] = {
+        {"nchans", &HeaderFields::nChans},
+        {"nbits", &HeaderFields::nBits},
+        {"nifs", &HeaderFields::nIFs},
+        {"telescope_id", &HeaderFields::telescopeId},
+        {"machine_id", &HeaderFields::machineId},
+        {"barycentric", &HeaderFields::barycentric},
+    };
+
+    constexpr Field<long> LONG_FIELDS[] = {
+        {"nsamples", &HeaderFields::nSamples},
+    };
+
+    constexpr Field<double> DOUBLE_FIELDS[] = {
+        {"tsamp", &HeaderFields::tsamp},
+        {"tstart", &HeaderFields::tstart},
+        {"fch1", &HeaderFields::fch1},
+        {"foff", &HeaderFields::foff},
+        {"bw", &HeaderFields::bandwidth},
+        {"src_raj", &HeaderFields::srcRaj},
+        {"src_dej", &HeaderFields::srcDej},
+        {"refdm", &HeaderFields::refDM},
+    };
+
+    template <typename T, std::size_t N>
+    bool setField(const Field<T> (&fields)[N], HeaderFields &header, const std::string &key, double value) {
+        for (const Field<T> &field : fields) {
+            if (std::strcmp(field.key, key.c_str()) == 0) {
+                header.*field.member = static_cast<T>(value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+};
+
+bool HeaderFields::set(const std::string &key, double value) {
+    return setField(INT_FIELDS, *this, key, value) || setField(LONG_FIELDS, *this, key, value) ||
+           setField(DOUBLE_FIELDS, *this, key, value);
+}
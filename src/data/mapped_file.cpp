@@ -0,0 +1,59 @@
+#include "data/mapped_file.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace IO;
+
+MappedFile::MappedFile(std::string fileName) {
+    this->address = nullptr;
+    this->length = 0;
+
+    this->fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw CustomException("Could not open " + fileName + " for mapping: " + std::strerror(errno));
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0) {
+        close(fd);
+        throw CustomException("Could not stat " + fileName + ": " + std::strerror(errno));
+    }
+    this->length = fileStat.st_size;
+    if (length == 0) return;
+
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        throw CustomException("Could not map " + fileName + ": " + std::strerror(errno));
+    }
+    this->address = static_cast<uint8_t *>(mapped);
+    madvise(address, length, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+    if (address) munmap(address, length);
+    if (fd >= 0) close(fd);
+}
+
+const uint8_t *MappedFile::getBytes(std::size_t startByte, std::size_t nBytes) {
+    if (startByte > length || nBytes > length - startByte) {
+        throw FileIOError(nBytes, startByte > length ? 0 : length - startByte, "read");
+    }
+    /* Prefetch the range after this one, the next gulp of a sequential stream. */
+    adviseWillNeed(startByte + nBytes, nBytes);
+    return address + startByte;
+}
+
+void MappedFile::adviseWillNeed(std::size_t startByte, std::size_t nBytes) {
+    if (startByte >= length || nBytes == 0) return;
+    std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::size_t alignedStart = startByte - startByte % pageSize;
+    std::size_t end = std::min(length, startByte + nBytes);
+    madvise(address + alignedStart, end - alignedStart, MADV_WILLNEED);
+}
@@ -1,4 +1,7 @@
 #include "data/multi_timeseries.hpp"
+#include "exceptions.hpp"
+#include "utils/gen_utils.hpp"
+#include <algorithm>
 
 using namespace IO;
 MultiTimeSeries::MultiTimeSeries(std::shared_ptr<std::vector<float>> dmList, std::size_t gulpNSamples, bool shouldWriteToFile): MultiTimeSeries(dmList, gulpNSamples, gulpNSamples, shouldWriteToFile){}
@@ -11,19 +14,52 @@ this->dmListSize = dmList->size();
 this->gulpNSamples = gulpNSamples;
 this->totalNSamples = totalNSamples;
 this->shouldWriteToFile = shouldWriteToFile;
-this->dedispersedData = std::make_shared<std::vector<DEDISP_OUTPUT_TYPE>>(gulpNSamples * dmListSize);
+this->nSamplesWritten = 0;
+this->nWriterThreads = 1;
+this->maxBufferedGulps = 1;
+this->hasOutputFiles = false;
+this->outputNBits = sizeof(DEDISP_OUTPUT_TYPE) * BITS_PER_BYTE;
 
-if(totalNSamples > gulpNSamples && !shouldWriteToFile) {
+if(!shouldWriteToFile) {
     this->fullDedispersedData = std::make_shared<std::vector<DEDISP_OUTPUT_TYPE>>(totalNSamples * dmListSize);
 }
 
 }
 
+void MultiTimeSeries::setTotalNSamples(std::size_t totalNSamples){
+    this->totalNSamples = totalNSamples;
+    if(!shouldWriteToFile) {
+        this->fullDedispersedData->resize(totalNSamples * dmListSize);
+    }
+}
+
 
 void MultiTimeSeries::initOutputOptions(std::string outDir, std::string outPrefix, std::string outSuffix, std::string outputFormat, std::shared_ptr<IO::SearchModeFile> searchModeFile){
     this->outDir = outDir;
     this->outPrefix = outPrefix;
     this->outSuffix = outSuffix;
+
+    /* Only the registered consumers get the output. */
+    if (caseInsensitiveCompare(outputFormat, "none")) return;
+    this->hasOutputFiles = true;
+
+    if (caseInsensitiveCompare(outputFormat, "dm_cube") || caseInsensitiveCompare(outputFormat, "dmc")){
+        std::stringstream outFileName;
+        if (!outDir.empty()) outFileName << outDir << "/";
+        outFileName << (outPrefix.empty() ? "dedispersed" : outPrefix);
+        if(!outSuffix.empty()) outFileName << "_" << outSuffix;
+        outFileName << "." << SearchModeFile::getExtension(outputFormat);
+
+        this->cubeFile = std::make_shared<DMTimeCube>(outFileName.str(), WRITE);
+        cubeFile->copyHeaderFrom(searchModeFile);
+        cubeFile->setDMList(*this->dmList);
+        cubeFile->setTotalNSamples(this->totalNSamples);
+        cubeFile->setOutputNBits(this->outputNBits);
+        cubeFile->writeHeader();
+        return;
+    }
+
+    bool quantised = outputNBits != sizeof(DEDISP_OUTPUT_TYPE) * BITS_PER_BYTE;
     this->outFiles.reserve(dmListSize);
     for (std::size_t i = 0; i < dmListSize; i++){
         std::stringstream outFileName;
@@ -39,33 +75,203 @@ void MultiTimeSeries::initOutputOptions(std::string outDir, std::string outPrefi
         std::shared_ptr<SearchModeFile> outFile = SearchModeFile::createInstance(outFileName.str(), WRITE, outputFormat);
         outFile->copyHeaderFrom(searchModeFile);
         outFile->updateHeaderValue<float>(REFDM, this->dmList->at(i));
+        outFile->updateHeaderValue<long>(NSAMPLES, static_cast<long>(this->totalNSamples));
         
         outFile->writeHeader();
         outFile->openDataFile();
         outFiles.push_back(outFile);
 
+        if (quantised) {
+            std::shared_ptr<PrestoTimeSeries> prestoFile = std::dynamic_pointer_cast<PrestoTimeSeries>(outFile);
+            if (!prestoFile) throw InvalidInputs("Only the presto and dm_cube output formats can be written with fewer than 32 bits");
+            quantisedFiles.push_back(prestoFile);
+        }
+
        
     }
 }
 
+/**
+ * Gulp buffers are only allocated when a gulp is about to be dedispersed into them, so a buffer is never held for a
+ * gulp that does not come.
+ */
 std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> MultiTimeSeries::getCurrentDedispersedDataPtr() {
+    if (!this->dedispersedData) {
+        if (spareBuffers.empty()) {
+            this->dedispersedData = std::make_shared<std::vector<DEDISP_OUTPUT_TYPE>>(gulpNSamples * dmListSize);
+        }
+        else {
+            this->dedispersedData = spareBuffers.back();
+            spareBuffers.pop_back();
+        }
+    }
     return this->dedispersedData;
 }
 
-void MultiTimeSeries::flush(){
-    if (this->shouldWriteToFile){
-        this->writeToFile();
+void MultiTimeSeries::setGulpNSamples(std::size_t gulpNSamples){
+    if (nSamplesWritten > 0) throw InvalidInputs("The gulp size cannot change once the first gulp is flushed");
+    this->gulpNSamples = gulpNSamples;
+    this->dedispersedData.reset();
+    this->spareBuffers.clear();
+}
+
+/**
+ * @brief Hands over the current gulp, which holds nSamplesOut samples per DM laid out DM after DM.
+ */
+void MultiTimeSeries::flush(std::size_t nSamplesOut){
+    if (!this->shouldWriteToFile){
+        if (nSamplesWritten + nSamplesOut > totalNSamples) {
+            throw InvalidInputs("More dedispersed samples than the expected total");
+        }
+        for (std::size_t i = 0; i < dmListSize; i++){
+            std::copy(dedispersedData->begin() + i * nSamplesOut, dedispersedData->begin() + (i + 1) * nSamplesOut,
+                      fullDedispersedData->begin() + i * totalNSamples + nSamplesWritten);
+        }
     }
-    else {
-        fullDedispersedData->insert(fullDedispersedData->end(), std::make_move_iterator(dedispersedData->begin()), std::make_move_iterator(dedispersedData->end()));   
+    if (hasOutputFiles || !consumers.empty()) dispatchGulp(nSamplesOut);
+    this->nSamplesWritten += nSamplesOut;
+}
+
+void MultiTimeSeries::setNWriterThreads(unsigned int nWriterThreads){
+    waitForWrites();
+    this->nWriterThreads = std::max(1u, nWriterThreads);
+    this->writerPool.reset();
+    this->writeChains.clear();
+    for (ConsumerEntry &entry : consumers) entry.chains.clear();
+}
+
+void MultiTimeSeries::setOutputNBits(unsigned int outputNBits){
+    if (outputNBits != 8 && outputNBits != 16 && outputNBits != 32) {
+        throw InvalidInputs("Dedispersed output can be written with 8, 16 or 32 bits, not " + std::to_string(outputNBits));
     }
-    dedispersedData->clear();
+    this->outputNBits = outputNBits;
 }
 
-void MultiTimeSeries::writeToFile(){
-    for (std::size_t i = 0; i < dmListSize; i++){
-        std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> iDedisp = std::make_shared<std::vector<DEDISP_OUTPUT_TYPE>>(dedispersedData->begin() + i * gulpNSamples, dedispersedData->begin() + (i + 1) * gulpNSamples);
-        outFiles[i]->writeNBytes<DEDISP_OUTPUT_TYPE>(nSamplesWritten,  iDedisp);
+std::size_t MultiTimeSeries::getNSamplesClipped(){
+    return nSamplesClipped + (cubeFile ? cubeFile->getNSamplesClipped() : 0);
+}
+
+void MultiTimeSeries::addConsumer(std::shared_ptr<DedispersedConsumer> consumer, std::size_t dmsPerBlock){
+    if (nSamplesWritten > 0) throw InvalidInputs("Consumers must be added before the first gulp is flushed");
+    consumers.push_back(ConsumerEntry{consumer, dmsPerBlock, {}});
+}
+
+void MultiTimeSeries::setMaxBufferedGulps(std::size_t maxBufferedGulps){
+    this->maxBufferedGulps = std::max<std::size_t>(1, maxBufferedGulps);
+}
+
+void MultiTimeSeries::waitForOldestGulp(){
+    GulpInFlight gulp = std::move(gulpsInFlight.front());
+    gulpsInFlight.pop_front();
+    for (std::shared_future<void> &task : gulp.tasks) task.wait();
+    spareBuffers.push_back(gulp.data);
+    for (std::shared_future<void> &task : gulp.tasks) task.get();
+}
+
+void MultiTimeSeries::waitForWrites(){
+    /* Wait for everything before rethrowing, so that no task is left running on a buffer. */
+    for (GulpInFlight &gulp : gulpsInFlight){
+        for (std::shared_future<void> &task : gulp.tasks) task.wait();
+    }
+    while (!gulpsInFlight.empty()) waitForOldestGulp();
+}
+
+void MultiTimeSeries::finish(){
+    waitForWrites();
+    if (cubeFile) cubeFile->finalise();
+    for (ConsumerEntry &entry : consumers) entry.consumer->finish();
+}
+
+MultiTimeSeries::~MultiTimeSeries(){
+    for (GulpInFlight &gulp : gulpsInFlight){
+        for (std::shared_future<void> &task : gulp.tasks) task.wait();
+    }
+}
+
+/**
+ * Queues job after the previous job of the same chain, i.e. the same sink and DM block of the previous gulp. The pool
+ * runs jobs in the order they were queued, so that job has already started when this one does and waiting for it
+ * cannot deadlock.
+ */
+void MultiTimeSeries::submitInOrder(std::shared_future<void> &chain, GulpInFlight &gulp, std::function<void()> job){
+    std::shared_future<void> previous = chain;
+    chain = writerPool->submit([previous, job]() {
+        if (previous.valid()) previous.wait();
+        job();
+    }).share();
+    gulp.tasks.push_back(chain);
+}
+
+/**
+ * Every DM slice is written and consumed straight from the gulp buffer. The buffer then goes to the writer threads and
+ * a spare one takes the next gulp, so the writes overlap with the dedispersion of the following gulps; only once
+ * maxBufferedGulps gulps are outstanding does a flush wait for the oldest of them.
+ */
+void MultiTimeSeries::dispatchGulp(std::size_t nSamplesOut){
+    while (gulpsInFlight.size() >= maxBufferedGulps) waitForOldestGulp();
+    if (!writerPool) writerPool = std::make_unique<UTILS::ThreadPool>(nWriterThreads);
+
+    std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> gulpData = dedispersedData;
+    gulpsInFlight.push_back(GulpInFlight{gulpData, {}});
+    GulpInFlight &gulp = gulpsInFlight.back();
+    std::size_t startSample = nSamplesWritten;
+
+    if (cubeFile){
+        writeChains.resize(1);
+        submitInOrder(writeChains[0], gulp, [this, gulpData, nSamplesOut]() {
+            cubeFile->appendSamples(gulpData->data(), nSamplesOut);
+        });
+    }
+    else if (hasOutputFiles){
+        /* Quantised DMs are scaled by the first gulp; each thread fits and records the DMs it owns. */
+        bool fitQuantisation = !quantisedFiles.empty() && quantParams.empty();
+        if (fitQuantisation) quantParams.resize(dmListSize);
+
+        std::size_t dmsPerThread = (dmListSize + nWriterThreads - 1) / nWriterThreads;
+        writeChains.resize((dmListSize + dmsPerThread - 1) / dmsPerThread);
+        for (std::size_t dmStart = 0; dmStart < dmListSize; dmStart += dmsPerThread){
+            std::size_t dmEnd = std::min(dmListSize, dmStart + dmsPerThread);
+            submitInOrder(writeChains[dmStart / dmsPerThread], gulp, [this, gulpData, nSamplesOut, dmStart, dmEnd, fitQuantisation]() {
+                if (quantisedFiles.empty()) {
+                    for (std::size_t i = dmStart; i < dmEnd; i++){
+                        outFiles[i]->writeRawBytes(gulpData->data() + i * nSamplesOut, nSamplesOut * sizeof(DEDISP_OUTPUT_TYPE));
+                    }
+                    return;
+                }
+
+                std::vector<uint8_t> quantised;
+                std::size_t nClipped = 0;
+                for (std::size_t i = dmStart; i < dmEnd; i++){
+                    const DEDISP_OUTPUT_TYPE *slice = gulpData->data() + i * nSamplesOut;
+                    if (fitQuantisation) {
+                        quantParams[i] = IO::fitQuantisation(slice, nSamplesOut, outputNBits);
+                        quantisedFiles[i]->setQuantisation(outputNBits, quantParams[i]);
+                    }
+                    nClipped += quantiseToBytes(slice, nSamplesOut, outputNBits, quantParams[i], quantised);
+                    outFiles[i]->writeRawBytes(quantised.data(), quantised.size());
+                }
+                nSamplesClipped += nClipped;
+            });
+        }
+    }
+
+    for (ConsumerEntry &entry : consumers){
+        std::size_t dmsPerBlock = entry.dmsPerBlock > 0 ? entry.dmsPerBlock : (dmListSize + nWriterThreads - 1) / nWriterThreads;
+        entry.chains.resize((dmListSize + dmsPerBlock - 1) / dmsPerBlock);
+        std::shared_ptr<DedispersedConsumer> consumer = entry.consumer;
+        for (std::size_t dmStart = 0; dmStart < dmListSize; dmStart += dmsPerBlock){
+            DedispersedBlock block;
+            block.data = gulpData->data() + dmStart * nSamplesOut;
+            block.dms = dmList->data() + dmStart;
+            block.dmStart = dmStart;
+            block.nDMs = std::min(dmListSize, dmStart + dmsPerBlock) - dmStart;
+            block.startSample = startSample;
+            block.nSamples = nSamplesOut;
+            submitInOrder(entry.chains[dmStart / dmsPerBlock], gulp, [consumer, gulpData, block]() {
+                consumer->consume(block);
+            });
+        }
     }
-    this->nSamplesWritten += this->gulpNSamples;
-}
\ No newline at end of file
+
+    dedispersedData.reset();
+}
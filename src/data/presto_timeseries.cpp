@@ -9,10 +9,30 @@
 #include "data/search_mode_file.hpp"
 #include "utils/sigproc_utils.hpp"
 #include <memory>
+#include <cstdio>
 #include <pwd.h>
+#include <vector>
 
 using namespace IO;
 
+namespace {
+
+    /* Looked up once with the reentrant getpwuid_r, as the writer threads rewrite their headers concurrently. */
+    const std::string &getLoginName() {
+        static const std::string login = [] {
+            struct passwd entry;
+            struct passwd *result = nullptr;
+            std::vector<char> buffer(16384);
+            if (getpwuid_r(getuid(), &entry, buffer.data(), buffer.size(), &result) == 0 && result != nullptr) {
+                return std::string(result->pw_name);
+            }
+            return std::string("unknown");
+        }();
+        return login;
+    }
+
+};
+
 PrestoTimeSeries::PrestoTimeSeries(std::string fileName, std::string mode) : SearchModeFile(fileName, mode){
     this->headerFileName = replaceExtension(fileName, "inf");
 
@@ -31,11 +51,12 @@ PrestoTimeSeries::PrestoTimeSeries(std::string fileName, std::string mode) : Sea
 void PrestoTimeSeries::copyHeaderFrom(std::shared_ptr<SearchModeFile> other){
     SearchModeFile::copyHeaderFrom(other);
     this->updateHeaderValue<int>(NCHANS, 1);
-    this->tsamp = other->getValueForKey<float>(TSAMP);
-    this->fch1 = other->getValueForKey<float>(FCH1);
-    this->foff = other->getValueForKey<float>(FOFF);
-    this->nBits = other->getValueForKey<int>(NBITS);
-    this->nSamps = other->getValueForKey<long>(NSAMPLES);
+    const HeaderFields &fields = other->getHeaderFields();
+    this->tsamp = fields.tsamp;
+    this->fch1 = fields.fch1;
+    this->foff = fields.foff;
+    this->nBits = fields.nBits;
+    this->nSamps = fields.nSamples;
     
     this->nChans = 1;
 
@@ -48,11 +69,32 @@ bool PrestoTimeSeries::isHeaderSeparate(){
 }
 
 void PrestoTimeSeries::readNBytes(std::size_t startByte, std::size_t nBytes) {
+    std::size_t nSamples = nBytes * BITS_PER_BYTE / storedNBits;
     this->nBytesOnDisk = nBytes;
-    this->nBytesOnRam = nBytes;
-    this->container = std::make_unique<DataBuffer<PRESTO_DAT_TYPE>>(startByte, nBytesOnRam); 
-    std::shared_ptr<std::vector<PRESTO_DAT_TYPE>> busser = this->container->getBuffer<PRESTO_DAT_TYPE>();
-    readFromFileAndVerify<PRESTO_DAT_TYPE>(this->dataFile, nBytesOnDisk, busser->data());
+    this->nBytesOnRam = nSamples * sizeof(PRESTO_DAT_TYPE);
+
+    std::shared_ptr<DataBuffer<PRESTO_DAT_TYPE>> reusable = std::dynamic_pointer_cast<DataBuffer<PRESTO_DAT_TYPE>>(this->container);
+    if (reusable) reusable->resize(startByte, nBytesOnRam);
+    else this->container = std::make_shared<DataBuffer<PRESTO_DAT_TYPE>>(startByte, nBytesOnRam);
+    PRESTO_DAT_TYPE *samples = static_cast<PRESTO_DAT_TYPE *>(this->container->getData());
+
+    openDataFile();
+    goToByte(startByte);
+    if (storedNBits == sizeof(PRESTO_DAT_TYPE) * BITS_PER_BYTE) {
+        readFromFileAndVerify<PRESTO_DAT_TYPE>(this->dataFile, nSamples, samples);
+        return;
+    }
+    storedData.resize(nBytes);
+    readFromFileAndVerify<uint8_t>(this->dataFile, nBytes, storedData.data());
+    dequantiseFromBytes(storedData.data(), nSamples, storedNBits, quantisation, samples);
+}
+
+void PrestoTimeSeries::setQuantisation(unsigned int nBits, const QuantisationParams &params){
+    if (nBits != 8 && nBits != 16 && nBits != 32) throw InvalidInputs("PRESTO time series hold 8, 16 or 32 bit samples");
+    this->storedNBits = nBits;
+    this->quantisation = params;
+    this->nBits = nBits;
+    if (this->dataFileOpenMode == WRITE) writeHeader();
 }
 
 void PrestoTimeSeries::writeNBytes() {
@@ -74,11 +116,16 @@ void PrestoTimeSeries::writeAllData(){}
 void PrestoTimeSeries::writeHeader(){
 
     std::string ra,dec;
-    std::string login = getpwuid(getuid())->pw_name;
-    sigproc_to_hhmmss(this->getValueForKey<float>(SRC_RAJ), ra);
-    sigproc_to_ddmmss(this->getValueForKey<float>(SRC_DEJ), dec);
+    const std::string &login = getLoginName();
+    const HeaderFields &fields = getHeaderFields();
+    sigproc_to_hhmmss(fields.srcRaj, ra);
+    sigproc_to_ddmmss(fields.srcDej, dec);
+
+    /* Called again by setQuantisation() once the first gulp is known, so start the file afresh. */
+    bool rewriting = this->headerFileOpen;
+    closeHeaderFile();
     openHeaderFile();
-    prettyPrintHeader();
+    if (!rewriting) prettyPrintHeader();
     std::stringstream ss;
     ss << " Data file name without suffix          =  " << this->dataFileName << "\n";
     ss << " Telescope used                         =  " << this->getValueForKey<int>(TELESCOPE_ID) << "\n";
@@ -87,22 +134,27 @@ void PrestoTimeSeries::writeHeader(){
     ss << " J2000 Right Ascension (hh:mm:ss.ssss)  =  " << ra << "\n";
     ss << " J2000 Declination     (dd:mm:ss.ssss)  =  " << dec << "\n";
     ss << " Data observed by                       =  COMPACT\n";
-    ss << " Epoch of observation (MJD)             =  " << std::fixed << std::setprecision(15) << this->getValueForKey<float>(TSTART) << "\n";
+    ss << " Epoch of observation (MJD)             =  " << std::fixed << std::setprecision(15) << fields.tstart << "\n";
     ss << " Barycentered?           (1=yes, 0=no)  =  " << this->getValueOrDefaultForKey<int>(BARYCENTRIC,0) << "\n";
     ss << " Number of bins in the time series      =  " << this->getValueForKey<long>(NSAMPLES) << "\n";
-    ss << " Width of each time series bin (sec)    =  " << std::fixed << std::setprecision(15) << this->getValueForKey<float>(TSAMP) << "\n";
+    ss << " Width of each time series bin (sec)    =  " << std::fixed << std::setprecision(15) << fields.tsamp << "\n";
     ss << " Any breaks in the data? (1 yes, 0 no)  =  0\n";
     ss << " Orbit removed?          (1=yes, 0=no)  =  " << 0 << "\n";
     ss << " Type of observation (EM band)          =  Radio\n";
-    ss << " Dispersion measure (cm-3 pc)           =  " << this->getValueForKey<float>(REFDM) << "\n";
-    ss << " Central freq of low channel (Mhz)      =  " << this->getValueForKey<float>(FCH1) << "\n";
-    ss << " Total bandwidth (Mhz)                  =  " << std::fixed << std::setprecision(6) << this->getValueForKey<float>(BW) << "\n";        
+    ss << " Dispersion measure (cm-3 pc)           =  " << fields.refDM << "\n";
+    ss << " Central freq of low channel (Mhz)      =  " << fields.fch1 << "\n";
+    ss << " Total bandwidth (Mhz)                  =  " << std::fixed << std::setprecision(6) << fields.bandwidth << "\n";        
     ss << " Number of channels                     =  " << this->nChans << "\n";
-    ss << " Channel bandwidth (Mhz)                =  " << this->getValueForKey<float>(FOFF) << "\n";
+    ss << " Channel bandwidth (Mhz)                =  " << fields.foff << "\n";
     ss << " Data analyzed by                       =  " << login << "\n";
     ss << " Any additional notes:\n";
     ss    << "    File written by COMPACT's pulsar search package\n";
+    if (storedNBits != sizeof(PRESTO_DAT_TYPE) * BITS_PER_BYTE) {
+        ss << "    Quantised to " << storedNBits << " bits: value = offset + scale * sample, offset = "
+           << std::scientific << std::setprecision(9) << quantisation.offset << ", scale = " << quantisation.scale << "\n";
+    }
     writeToFileAndVerify<const char>(this->headerFile, ss.str().size(), ss.str().c_str());
+    fflush(this->headerFile);
 
 
 }
@@ -110,84 +162,89 @@ void PrestoTimeSeries::writeHeader(){
 
 
 /**
- * Copied from presto:ioinf.c and modified to C++ style
-*/
-
-void PrestoTimeSeries::readInfLineValStr(std::ifstream& infofile, std::string& valstr, const std::string& errdesc) {
-    std::string line;
-    std::getline(infofile, line);
-    if (!line.empty() && line[0] != '\n') {
-        std::string::size_type ii;
-        // Check to see if this is a "standard" .inf line
-        // which has an '=' in character 40
-        if (line.length() >= 40 && line[40] == '=') {
-            ii = 41;
-        } else {
-            // Else, look for the first '=' back from the end of the line
-            ii = line.rfind('=');
-            if (ii == std::string::npos) {
-                throw std::runtime_error("Error:  no '=' to separate key/val while looking for '" + errdesc + "' in readinf()\n");
-            }
-            ii++;
-        }
-        std::string sptr = removeWhiteSpace(line.substr(ii));
-        if (!sptr.empty()) {
-            if ((errdesc == "data->name" && sptr.length() > 199) ||
-                (errdesc == "data->telescope" && sptr.length() > 39) ||
-                (errdesc == "data->band" && sptr.length() > 39) ||
-                (errdesc != "data->name" && sptr.length() > 99)) {
-                throw std::runtime_error("Error:  value string is too long (" + std::to_string(sptr.length()) + " char) while looking for '" + errdesc + "' in readinf()\n");
-            }
-            valstr = sptr;
-        } else {
-            valstr = "Unknown";
-        }
-        return;
-    } else {
-        if (infofile.eof()) {
-            throw std::runtime_error("Error:  end-of-file while looking for '" + errdesc + "' in readinf()\n");
-        } else {
-            throw std::runtime_error("Error:  found blank line while looking for '" + errdesc + "' in readinf()\n");
-        }
-    }
-    
+ * Splits a .inf line into its description and value, as presto:ioinf.c does: standard lines have the '=' in character
+ * 40, others are split at the last '='. Returns false for lines without one, e.g. the notes.
+ */
+bool PrestoTimeSeries::splitInfLine(const std::string& line, std::string& description, std::string& valstr) {
+    std::string::size_type ii;
+    if (line.length() > 40 && line[40] == '=') ii = 40;
+    else ii = line.rfind('=');
+    if (ii == std::string::npos) return false;
+
+    description = removeWhiteSpace(line.substr(0, ii));
+    valstr = removeWhiteSpace(line.substr(ii + 1));
+    return true;
 }
 
 /**
- * The only way to read the inf file (since it is written in a very human friendly format) is to read it line by line in the order that it was saved.
- * The order below cannot be changed. 
-*/
-
+ * The lines are matched by their description rather than their position, so .inf files written by PRESTO itself,
+ * which have more lines, can be read as well. Values that do not parse are left out of the header.
+ */
 void PrestoTimeSeries::readHeader(){
 
-    std::vector<std::string> keys = {TELESCOPE_ID, MACHINE_ID, SOURCE_NAME, SRC_RAJ, SRC_DEJ, TSTART, BARYCENTRIC, NSAMPLES, TSAMP, REFDM, NCHANS, FOFF};
     std::ifstream infofile(this->headerFileName);
-    if (infofile.is_open()) {
-        std::string valstr;
-        for (auto key : keys) {
-            readInfLineValStr(infofile, valstr, key);
-            HeaderParamBase *header_param = getHeaderParam(key);
-            std::string dtype = header_param->dtype;
-            header_param->inheader = true;
-            if (dtype == std::string(INT)){
-                static_cast<HeaderParam<int> *>(header_param)->value = std::stoi(valstr);
+    if (!infofile.is_open()) {
+        throw std::runtime_error("Error:  Unable to open file '" + this->headerFileName + "' in readinf()\n");
+    }
+
+    auto startsWith = [](const std::string& str, const std::string& prefix) {
+        return str.compare(0, prefix.size(), prefix) == 0;
+    };
+
+    std::string line, description, valstr;
+    while (std::getline(infofile, line)) {
+        std::string::size_type notes = line.find("Quantised to ");
+        if (notes != std::string::npos) {
+            unsigned int nBits;
+            float offset, scale;
+            if (std::sscanf(line.c_str() + notes, "Quantised to %u bits: value = offset + scale * sample, offset = %g, scale = %g", &nBits, &offset, &scale) == 3) {
+                this->storedNBits = nBits;
+                this->quantisation.offset = offset;
+                this->quantisation.scale = scale;
             }
-            else if (dtype == std::string(DOUBLE)){
-                static_cast<HeaderParam<double> *>(header_param)->value = std::stod(valstr);
+            continue;
+        }
+        if (!splitInfLine(line, description, valstr)) continue;
+
+        try {
+            if (startsWith(description, "Telescope used")) addToHeader<int>(TELESCOPE_ID, INT, std::stoi(valstr));
+            else if (startsWith(description, "Instrument used")) addToHeader<int>(MACHINE_ID, INT, std::stoi(valstr));
+            else if (startsWith(description, "J2000 Right Ascension")) {
+                double raj;
+                hhmmss_to_sigproc(valstr, raj);
+                addFloatToHeader(SRC_RAJ, raj);
             }
-            else if (dtype == std::string(STRING)){
-
-                static_cast<HeaderParam<const char *> *>(header_param)->value = valstr.c_str();
+            else if (startsWith(description, "J2000 Declination")) {
+                double dej;
+                ddmmss_to_sigproc(valstr, dej);
+                addFloatToHeader(SRC_DEJ, dej);
             }
-            
+            else if (startsWith(description, "Epoch of observation")) addFloatToHeader(TSTART, std::stod(valstr));
+            else if (startsWith(description, "Barycentered?")) addToHeader<int>(BARYCENTRIC, INT, std::stoi(valstr));
+            else if (startsWith(description, "Number of bins in the time series")) addToHeader<long>(NSAMPLES, LONG, std::stol(valstr));
+            else if (startsWith(description, "Width of each time series bin")) addFloatToHeader(TSAMP, std::stod(valstr));
+            else if (startsWith(description, "Dispersion measure")) addFloatToHeader(REFDM, std::stod(valstr));
+            else if (startsWith(description, "Central freq of low channel")) addFloatToHeader(FCH1, std::stod(valstr));
+            else if (startsWith(description, "Total bandwidth")) addFloatToHeader(BW, std::stod(valstr));
+            else if (startsWith(description, "Channel bandwidth")) addFloatToHeader(FOFF, std::stod(valstr));
+        }
+        catch (const std::logic_error &) {
+            // "Unknown" or a name where a number was expected
         }
-        infofile.close();
-    } else {
-        throw std::runtime_error("Error:  Unable to open file '" + this->headerFileName + "' in readinf()\n");
     }
+    infofile.close();
 
+    if (!isParamInHeader(NSAMPLES) || !isParamInHeader(TSAMP)) {
+        throw FileFormatNotRecognised(this->headerFileName);
+    }
 
+    addToHeader<int>(NCHANS, INT, 1);
+    addToHeader<int>(NIFS, INT, 1);
+    addToHeader<int>(NBITS, INT, static_cast<int>(storedNBits));
+    this->nChans = 1;
+    this->nBits = storedNBits;
+    this->nSamps = headerFields.nSamples;
+    this->tsamp = headerFields.tsamp;
+    this->fch1 = headerFields.fch1;
+    this->foff = headerFields.foff;
 }
-
-
-
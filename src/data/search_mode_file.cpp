@@ -3,6 +3,7 @@
 #include "data/constants.hpp"
 #include "data/sigproc_filterbank.hpp"
 #include "data/presto_timeseries.hpp"
+#include "data/dm_time_cube.hpp"
 #include "utils/gen_utils.hpp"
 #include "utils/sigproc_utils.hpp"
 #include "exceptions.hpp"
@@ -52,6 +53,10 @@ std::shared_ptr<SearchModeFile> SearchModeFile::createInstance(std::string fileN
                      caseInsensitiveCompare(fileType, "sigproc_timeseries")){
                     return std::make_shared<SigprocTimeSeries>(fileName, mode);
         }
+            else if (caseInsensitiveCompare(fileType, "dm_cube") || 
+                     caseInsensitiveCompare(fileType, "dmc")){
+                    return std::make_shared<DMTimeCube>(fileName, mode);
+            }
             else{
                 throw FileFormatNotRecognised(fileType);
             }
@@ -67,6 +72,9 @@ std::string SearchModeFile::guessFileType(std::string fileName){
             else if (caseInsensitiveCompare(extension, "dat")){
                 fileType = "presto_timeseries";
             }
+            else if (caseInsensitiveCompare(extension, "dmc")){
+                fileType = "dm_cube";
+            }
             else{
                 throw FileFormatNotRecognised(extension);
             }
@@ -80,6 +88,9 @@ std::string SearchModeFile::getExtension(std::string format){
     else if (caseInsensitiveCompare(format, "presto_timeseries") || caseInsensitiveCompare(format, "presto")|| caseInsensitiveCompare(format, "dat")){
         return "dat";
     }
+    else if (caseInsensitiveCompare(format, "dm_cube") || caseInsensitiveCompare(format, "dmc")){
+        return "dmc";
+    }
     else{
         throw FileFormatNotRecognised(format);
     }
@@ -100,16 +111,17 @@ std::string SearchModeFile::getExtension(std::string format){
  */
 HeaderParamBase* SearchModeFile::getHeaderParam(const std::string key) {
 
-    std::map<std::string, HeaderParamBase *>::iterator it = headerParams.find(key);
+    auto it = headerParams.find(key);
     if (it != headerParams.end()) return it->second;
     else throw HeaderParamNotFound(key);
 }
 
 void SearchModeFile::removeHeaderParam(const std::string key) {
    
-    std::map<std::string, HeaderParamBase *>::iterator it = headerParams.find(key);
-    if (it != headerParams.end()) headerParams.erase(it);
-    else throw HeaderParamNotFound(key);
+    auto it = headerParams.find(key);
+    if (it == headerParams.end()) throw HeaderParamNotFound(key);
+    it->second->~HeaderParamBase();
+    headerParams.erase(it);
     
 }
 
@@ -118,7 +130,7 @@ void SearchModeFile::removeHeaderParam(const std::string key) {
 void SearchModeFile::prettyPrintHeader() {
     int max_key_length = 3, max_value_length = 5;
     //iterate through the header params and find the max key and value length
-    for (std::map<std::string, HeaderParamBase *>::iterator it = headerParams.begin(); it != headerParams.end(); ++it)
+    for (auto it = headerParams.begin(); it != headerParams.end(); ++it)
     {
         HeaderParamBase *base = it->second;
         max_key_length = std::max(max_key_length, base->getKeyLength());
@@ -131,7 +143,7 @@ void SearchModeFile::prettyPrintHeader() {
               << "\n";
     std::cout << std::string(max_value_length + max_key_length, '-') << "\n";
 
-    for (std::map<std::string, HeaderParamBase *>::iterator it = headerParams.begin(); it != headerParams.end(); ++it)
+    for (auto it = headerParams.begin(); it != headerParams.end(); ++it)
     {
         HeaderParamBase *header_param = it->second;
         if (header_param != nullptr)
@@ -142,7 +154,7 @@ void SearchModeFile::prettyPrintHeader() {
 }
 
 void SearchModeFile::printHeader() {
-    for (std::map<std::string, HeaderParamBase *>::iterator it = headerParams.begin(); it != headerParams.end(); ++it)
+    for (auto it = headerParams.begin(); it != headerParams.end(); ++it)
     {
         HeaderParamBase *base = it->second;
         if (!base->inheader)
@@ -189,26 +201,24 @@ void SearchModeFile::printHeader() {
 
 void SearchModeFile::copyHeaderFrom(std::shared_ptr<SearchModeFile> other){
     for (const auto& pair : other->headerParams) {
-        headerParams[pair.first] = pair.second->clone();
+        HeaderParamBase *&param = headerParams[pair.first];
+        if (param != nullptr) param->~HeaderParamBase();
+        param = pair.second->clone(&headerArena);
     }
+    headerFields = other->headerFields;
 }
 
+/* Counted in bits so that 1, 2 and 4 bit data do not round the bytes per sample down to zero. */
 std::size_t SearchModeFile::samplesToBytes(std::size_t nsamples) {
-    int nChans = getValueForKey<int>(NCHANS);
-    int nBits = getValueForKey<int>(NBITS);
-    int nbytes = nBits / 8;
-    return nsamples * nChans * nbytes;
+    return nsamples * headerFields.nChans * headerFields.nBits / BITS_PER_BYTE;
 }
 
 std::size_t SearchModeFile::bytesToSamples(std::size_t nBytes) {
-    int nChans = getValueForKey<int>(NCHANS);
-    int nBits = getValueForKey<int>(NBITS);
-    int numBytesPerSample = nBits / 8;
-    return nBytes / nChans / numBytesPerSample;
+    return nBytes * BITS_PER_BYTE / (static_cast<std::size_t>(headerFields.nChans) * headerFields.nBits);
 }
 
 std::size_t SearchModeFile::timeToBytes(std::size_t nsecs) {
-    std::size_t samples = nsecs / getValueForKey<float>(TSAMP);
+    std::size_t samples = nsecs / headerFields.tsamp;
     return samplesToBytes(samples);
 }
 
@@ -319,6 +329,22 @@ void IO::SearchModeFile::closeDataFile()
     this->dataFileOpen = false;
 }
 
+/**
+ * @brief Appends nBytes from data to the open data file as they are, without copying them into the container first.
+ */
+void IO::SearchModeFile::writeRawBytes(const void *data, std::size_t nBytes)
+{
+    writeToFileAndVerify<const uint8_t>(this->dataFile, nBytes, static_cast<const uint8_t *>(data));
+}
+
+void IO::SearchModeFile::enableMemoryMap()
+{
+    if (this->dataFileOpenMode != READ) {
+        throw InvalidInputs("Memory mapping is only supported when reading " + this->dataFileName);
+    }
+    if (!this->mappedFile) this->mappedFile = std::make_shared<MappedFile>(this->dataFileName);
+}
+
 void IO::SearchModeFile::clearBuffer()
 {
     this->container->clearBuffer();
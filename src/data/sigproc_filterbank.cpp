@@ -2,6 +2,7 @@
 #include "utils/sigproc_utils.hpp"
 #include "data/search_mode_file.hpp"
 #include "data/constants.hpp"
+#include "data/header_keys.hpp"
 #include "utils/gen_utils.hpp"
 #include "exceptions.hpp"
 #include <string>
@@ -40,57 +41,29 @@ IO::SigprocFilterbank::SigprocFilterbank(std::string fileName, std::string mode)
 }
 
 /**
- * @brief Reads the header keys of a Sigproc file.
+ * @brief Creates an empty parameter for every key of SIGPROC_HEADER_KEYS.
  *
- * This function is responsible for reading the header keys of a Sigproc file.
- *
- * @return int Returns 0 if the header keys are successfully read, otherwise returns an error code.
+ * The parameters and map nodes come from the file's header arena, so this reads nothing from disk and allocates once.
  */
 void IO::SigprocFilterbank::readHeaderKeys()
 {
-    std::ifstream headerKeysFile(HEADER_KEYS_FILE);
-    std::string line;
-
-    while (std::getline(headerKeysFile, line))
+    for (const HeaderKey &headerKey : SIGPROC_HEADER_KEYS)
     {
-        std::istringstream lineStream(line);
-        std::string key;
-        std::string dtype;
-        if (!(lineStream >> key >> dtype))
-        {
-            fprintf(stderr, "Error parsing header_keys file at this line: %s \n", line.c_str());
-            break;
-        }
-        if (!dtype.compare(std::string(INT)))
-        {
-            headerParams.insert(std::make_pair(key, new HeaderParam<int>(key, dtype)));
-        }
-        else if (!dtype.compare(std::string(FLOAT)))
-        {
-             headerParams.insert(std::make_pair(key, new HeaderParam<float>(key, dtype)));
-        }
-        else if (!dtype.compare(std::string(DOUBLE)))
-        {
-             headerParams.insert(std::make_pair(key, new HeaderParam<double>(key, dtype)));
-        }
-        else if (!dtype.compare(std::string(STRING)))
-        {
-            headerParams.insert(std::make_pair(key, new HeaderParam<char *>(key, dtype)));
-        }
-        else if (!dtype.compare(std::string(NULL_STR)))
-        {
-            headerParams.insert(std::make_pair(key, new HeaderParam<char *>(key, dtype)));
-        }
+        std::string key(headerKey.key);
+        std::string dtype(headerKey.dtype);
+        HeaderParamBase *param;
+        if (dtype == INT) param = makeHeaderParam<int>(&headerArena, key, dtype);
+        else if (dtype == LONG) param = makeHeaderParam<long>(&headerArena, key, dtype);
+        else if (dtype == FLOAT) param = makeHeaderParam<float>(&headerArena, key, dtype);
+        else if (dtype == DOUBLE) param = makeHeaderParam<double>(&headerArena, key, dtype);
+        else param = makeHeaderParam<char *>(&headerArena, key, dtype);
+        headerParams.emplace(key, param);
     }
-
-
-
 }
 
 
 
 
-
 bool IO::SigprocFilterbank::isHeaderSeparate()
 {
     return false;
@@ -143,24 +116,22 @@ void IO::SigprocFilterbank::readHeader()
                         break;
                     }
                     dataBytes = headerFileStat.st_size - headerBytes;
-                    int nChans = getValueForKey<int>(NCHANS);
-                    int nBits = getValueForKey<int>(NBITS);
-                    int nifs = getValueForKey<int>(NIFS);
-                    float tsamp = getValueForKey<float>(TSAMP);
-                    int nbytes = nBits / 8;
-                    long nsamples = dataBytes / (nChans * nbytes * nifs);
-                    double tobs = nsamples * tsamp;
+                    int nChans = headerFields.nChans;
+                    int nBits = headerFields.nBits;
+                    int nifs = headerFields.nIFs;
+                    long nsamples = dataBytes * BITS_PER_BYTE / (static_cast<std::size_t>(nChans) * nBits * nifs);
+                    double tobs = nsamples * headerFields.tsamp;
                     addToHeader<long>(NSAMPLES, LONG, nsamples);
                     addToHeader<double>(TOBS, DOUBLE, tobs);
-                    addToHeader<float>(BW, FLOAT, getValueForKey<int>(NCHANS) * getValueForKey<float>(FOFF));
+                    addFloatToHeader(BW, nChans * headerFields.foff);
 
 
                     this->nChans = nChans;
                     this->nBits = nBits;
                     this->nSamps = nsamples;
-                    this->tsamp = tsamp;
-                    this->fch1 = getValueForKey<float>(FCH1);
-                    this->foff = getValueForKey<float>(FOFF);
+                    this->tsamp = headerFields.tsamp;
+                    this->fch1 = headerFields.fch1;
+                    this->foff = headerFields.foff;
                     break;
                 }
 
@@ -172,18 +143,29 @@ void IO::SigprocFilterbank::readHeader()
                     header_param->inheader = true;
                     if (dtype == INT)
                     {
-                        static_cast<HeaderParam<int> *>(header_param)->value = readInt();
-
+                        int value = readInt();
+                        static_cast<HeaderParam<int> *>(header_param)->value = value;
+                        headerFields.set(header_key, value);
+                    }
+                    else if (dtype == LONG)
+                    {
+                        /* sigproc writes nsamples as an int */
+                        long value = readInt();
+                        static_cast<HeaderParam<long> *>(header_param)->value = value;
+                        headerFields.set(header_key, value);
                     }
                     else if (dtype == DOUBLE)
                     {
-                        static_cast<HeaderParam<double> *>(header_param)->value = readDouble();
-
+                        double value = readDouble();
+                        static_cast<HeaderParam<double> *>(header_param)->value = value;
+                        headerFields.set(header_key, value);
                     }
                     else if (dtype == FLOAT)
                     {
-                        static_cast<HeaderParam<float> *>(header_param)->value = readDouble();
-
+                        /* the typed field keeps the full precision of the value on disk, e.g. of tstart */
+                        double value = readDouble();
+                        static_cast<HeaderParam<float> *>(header_param)->value = value;
+                        headerFields.set(header_key, value);
                     }
                     else if (dtype == STRING || dtype == NULL_STR)
                     {
@@ -201,7 +183,7 @@ void IO::SigprocFilterbank::readHeader()
                     }
                     else 
                     {
-                        throw InvalidInputs("Invalid dtype in header_keys.info file.");
+                        throw InvalidInputs("Invalid dtype for header key " + header_key);
                     }
                 }
             }
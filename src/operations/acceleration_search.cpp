@@ -0,0 +1,65 @@
+#include "operations/acceleration_search.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace OPS;
+
+namespace {
+
+    const double SPEED_OF_LIGHT = 299792458.0; // m/s
+
+};
+
+AccelerationSearch::AccelerationSearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                                       const PeriodicitySearchOptions &options, float maxAcceleration)
+    : PeriodicitySearch(dmList, totalNSamples, tsamp, options) {
+    if (maxAcceleration < 0) throw InvalidInputs("The maximum acceleration cannot be negative");
+
+    double observationLength = RealFFT::goodLength(totalNSamples) * tsamp;
+    if (observationLength <= 0) throw InvalidInputs("The time series are too short for an acceleration search");
+    double step = 8.0 * SPEED_OF_LIGHT * tsamp / (observationLength * observationLength);
+    long nSteps = static_cast<long>(maxAcceleration / step);
+
+    /* Zero first, then outwards, so that the unaccelerated trial of every DM is searched before the others. */
+    accelerations.push_back(0.0f);
+    for (long i = 1; i <= nSteps; i++) {
+        accelerations.push_back(static_cast<float>(i * step));
+        accelerations.push_back(static_cast<float>(-i * step));
+    }
+}
+
+/**
+ * Within a block of samples starting at b, the input index is j(b + u) = j(b) + j'(b) u + k u^2. Only j(b) needs
+ * double precision; the offsets from it stay small enough for floats, which keeps the inner loop a float
+ * multiply-add, a conversion and a gather that the compiler vectorises.
+ */
+void AccelerationSearch::resample(const float *in, std::size_t nSamples, double tsamp, float acceleration, float *out) {
+    const double k = acceleration * tsamp / (2.0 * SPEED_OF_LIGHT);
+    const double n = static_cast<double>(nSamples);
+    const std::ptrdiff_t last = static_cast<std::ptrdiff_t>(nSamples) - 1;
+
+    for (std::size_t blockStart = 0; blockStart < nSamples; blockStart += RESAMPLE_BLOCK) {
+        std::size_t blockLength = std::min(RESAMPLE_BLOCK, nSamples - blockStart);
+        double b = static_cast<double>(blockStart);
+        double start = b + k * b * (b - n);
+        std::ptrdiff_t startIndex = static_cast<std::ptrdiff_t>(std::floor(start + 0.5));
+        const float offset = static_cast<float>(start - startIndex) + 0.5f;
+        const float slope = static_cast<float>(1.0 + k * (2.0 * b - n));
+        const float curvature = static_cast<float>(k);
+
+        float *__restrict__ dst = out + blockStart;
+        for (std::size_t u = 0; u < blockLength; u++) {
+            float position = static_cast<float>(u);
+            std::ptrdiff_t index = startIndex + static_cast<int>(offset + position * slope + curvature * position * position);
+            dst[u] = in[std::min(std::max<std::ptrdiff_t>(index, 0), last)];
+        }
+    }
+}
+
+void AccelerationSearch::searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t trial,
+                                     std::vector<PeriodicityCandidate> &found) {
+    std::vector<float> samples(RealFFT::goodLength(nSamples));
+    resample(timeSeries, samples.size(), tsamp, accelerations[trial], samples.data());
+    searchSamples(samples, dm, accelerations[trial], found);
+}
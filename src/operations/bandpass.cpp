@@ -0,0 +1,307 @@
+#include "operations/bandpass.hpp"
+#include "data/constants.hpp"
+#include "utils/gen_utils.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+using namespace OPS;
+
+const char BandpassNormaliser::MAGIC[8] = {'B', 'A', 'N', 'D', 'P', 'A', 'S', '1'};
+
+namespace {
+
+    const std::size_t CHANNELS_PER_CHUNK = 64;
+    const std::size_t SAMPLES_PER_CHUNK = 1024;
+    const unsigned int N_LEVELS = 256;
+
+    /**
+     * Mean, RMS, median and MAD of one channel from its histogram, treating each level v as spread evenly over
+     * [v - 0.5, v + 0.5) so that the median and MAD are not stuck to whole levels.
+     */
+    void statisticsFromHistogram(const uint32_t *histogram, std::size_t nSamples, float &mean, float &rms, float &median, float &mad) {
+        double cumulative[N_LEVELS + 1];
+        double sum = 0.0, sumSq = 0.0;
+        cumulative[0] = 0.0;
+        for (unsigned int v = 0; v < N_LEVELS; v++) {
+            cumulative[v + 1] = cumulative[v] + histogram[v];
+            sum += static_cast<double>(v) * histogram[v];
+            sumSq += static_cast<double>(v) * v * histogram[v];
+        }
+        double n = static_cast<double>(nSamples);
+        mean = static_cast<float>(sum / n);
+        rms = static_cast<float>(std::sqrt(std::max(0.0, sumSq / n - (sum / n) * (sum / n))));
+
+        auto cdf = [&](double x) {
+            if (x < -0.5) return 0.0;
+            if (x >= N_LEVELS - 0.5) return n;
+            unsigned int v = static_cast<unsigned int>(x + 0.5);
+            return cumulative[v] + histogram[v] * (x - (v - 0.5));
+        };
+
+        double half = 0.5 * n;
+        unsigned int level = 0;
+        while (level < N_LEVELS - 1 && cumulative[level + 1] <= half) level++;
+        double med = level - 0.5 + (histogram[level] > 0 ? (half - cumulative[level]) / histogram[level] : 0.5);
+
+        double low = 0.0, high = N_LEVELS;
+        for (int i = 0; i < 40; i++) {
+            double d = 0.5 * (low + high);
+            if (cdf(med + d) - cdf(med - d) < half) low = d;
+            else high = d;
+        }
+        median = static_cast<float>(med);
+        mad = static_cast<float>(0.5 * (low + high));
+    }
+
+    float medianOf(std::vector<float> &values) {
+        std::size_t middle = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + middle, values.end());
+        return values[middle];
+    }
+
+};
+
+void BandpassStatistics::resize(unsigned int nChans) {
+    mean.resize(nChans);
+    rms.resize(nChans);
+    median.resize(nChans);
+    mad.resize(nChans);
+}
+
+float BandpassStatistics::getSigma(unsigned int chan) const {
+    return mad[chan] > 0.0f ? 1.4826f * mad[chan] : rms[chan];
+}
+
+ChannelStatistics::ChannelStatistics(unsigned int nChans, unsigned int nThreads) : nChans(nChans) {
+    this->threadPool = std::make_unique<UTILS::ThreadPool>(nThreads);
+}
+
+void ChannelStatistics::compute(std::size_t nSamples, const uint8_t *data, unsigned int inNBits, BandpassStatistics &stats) {
+    if (nSamples == 0) throw InvalidInputs("Cannot compute channel statistics of an empty gulp");
+    stats.resize(nChans);
+    stats.nSamples = nSamples;
+
+    switch (inNBits)
+    {
+    case 8:
+        computeFromHistograms(nSamples, data, stats);
+        break;
+    case 16:
+        computeFromSums<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(data), stats);
+        break;
+    case 32:
+        computeFromSums<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(data), stats);
+        break;
+    default:
+        throw InvalidInputs("Channel statistics support 8, 16 and 32 bit data only");
+    }
+}
+
+void ChannelStatistics::computeFromHistograms(std::size_t nSamples, const uint8_t *data, BandpassStatistics &stats) {
+    const std::size_t nChans = this->nChans;
+    threadPool->parallelFor(0, nChans, [&](std::size_t chanStart, std::size_t chanEnd) {
+        std::size_t width = chanEnd - chanStart;
+        std::vector<uint32_t> histograms(width * N_LEVELS, 0);
+        uint32_t *__restrict__ histogram = histograms.data();
+
+        for (std::size_t t = 0; t < nSamples; t++) {
+            const uint8_t *row = data + t * nChans + chanStart;
+            for (std::size_t c = 0; c < width; c++) {
+                histogram[c * N_LEVELS + row[c]]++;
+            }
+        }
+        for (std::size_t c = 0; c < width; c++) {
+            std::size_t chan = chanStart + c;
+            statisticsFromHistogram(histogram + c * N_LEVELS, nSamples, stats.mean[chan], stats.rms[chan], stats.median[chan], stats.mad[chan]);
+        }
+    }, CHANNELS_PER_CHUNK);
+}
+
+template <typename DTYPE>
+void ChannelStatistics::computeFromSums(std::size_t nSamples, const DTYPE *data, BandpassStatistics &stats) {
+    const std::size_t nChans = this->nChans;
+    std::size_t nRobust = std::min(nSamples, MAX_ROBUST_SAMPLES);
+    std::size_t robustStride = nSamples / nRobust;
+
+    threadPool->parallelFor(0, nChans, [&](std::size_t chanStart, std::size_t chanEnd) {
+        std::size_t width = chanEnd - chanStart;
+        std::vector<double> sums(width, 0.0), sumsSq(width, 0.0);
+        double *__restrict__ sum = sums.data();
+        double *__restrict__ sumSq = sumsSq.data();
+
+        for (std::size_t t = 0; t < nSamples; t++) {
+            const DTYPE *__restrict__ row = data + t * nChans + chanStart;
+            for (std::size_t c = 0; c < width; c++) {
+                double value = static_cast<double>(row[c]);
+                sum[c] += value;
+                sumSq[c] += value * value;
+            }
+        }
+
+        /* Gather the rows for the robust statistics a row at a time, so they are read in order. */
+        std::vector<float> robust(width * nRobust);
+        for (std::size_t i = 0; i < nRobust; i++) {
+            const DTYPE *row = data + i * robustStride * nChans + chanStart;
+            for (std::size_t c = 0; c < width; c++) robust[c * nRobust + i] = static_cast<float>(row[c]);
+        }
+
+        std::vector<float> values(nRobust);
+        for (std::size_t c = 0; c < width; c++) {
+            std::size_t chan = chanStart + c;
+            double mean = sum[c] / nSamples;
+            stats.mean[chan] = static_cast<float>(mean);
+            stats.rms[chan] = static_cast<float>(std::sqrt(std::max(0.0, sumSq[c] / nSamples - mean * mean)));
+
+            values.assign(robust.begin() + c * nRobust, robust.begin() + (c + 1) * nRobust);
+            float median = medianOf(values);
+            for (float &value : values) value = std::fabs(value - median);
+            stats.median[chan] = median;
+            stats.mad[chan] = medianOf(values);
+        }
+    }, CHANNELS_PER_CHUNK);
+}
+
+BandpassNormaliser::BandpassNormaliser(unsigned int nChans, unsigned int nBits, std::string bandpassFileName, unsigned int nThreads)
+    : nChans(nChans), nBits(nBits), statistics(nChans, nThreads), bandpassFileName(bandpassFileName), bandpassFile(nullptr) {
+    if (nBits != 8 && nBits != 16 && nBits != 32) throw InvalidInputs("Bandpass normalisation supports 8, 16 and 32 bit data only");
+    gains.resize(nChans);
+    offsets.resize(nChans);
+    if (!bandpassFileName.empty() && fileExists(bandpassFileName)) readBandpassFile();
+}
+
+BandpassNormaliser::~BandpassNormaliser() {
+    if (bandpassFile) fclose(bandpassFile);
+}
+
+/**
+ * A bandpass file of a different shape holds no usable gulps, so it is overwritten with the new statistics.
+ */
+void BandpassNormaliser::readBandpassFile() {
+    FILE *file = fopen(bandpassFileName.c_str(), READ);
+    if (!file) throw FileIOError(0, 0, "open " + bandpassFileName);
+
+    BandpassFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.nChans != nChans || header.nBits != nBits) {
+        fclose(file);
+        return;
+    }
+
+    uint64_t range[2];
+    while (fread(range, sizeof(range), 1, file) == 1) {
+        BandpassStatistics stats;
+        stats.resize(nChans);
+        stats.startSample = range[0];
+        stats.nSamples = range[1];
+        bool complete = true;
+        for (std::vector<float> *values : {&stats.mean, &stats.rms, &stats.median, &stats.mad}) {
+            complete = complete && fread(values->data(), sizeof(float), nChans, file) == nChans;
+        }
+        if (!complete) break;
+        storedStatistics[stats.startSample] = stats;
+    }
+    fclose(file);
+}
+
+void BandpassNormaliser::appendToBandpassFile(const BandpassStatistics &stats) {
+    if (!bandpassFile) {
+        if (fileOpen(&bandpassFile, bandpassFileName, WRITE) != EXIT_SUCCESS) {
+            throw FileIOError(0, 0, "open " + bandpassFileName);
+        }
+        BandpassFileHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.nChans = nChans;
+        header.nBits = nBits;
+        writeToFileAndVerify<BandpassFileHeader>(bandpassFile, 1, &header);
+    }
+    uint64_t range[2] = {stats.startSample, stats.nSamples};
+    writeToFileAndVerify<uint64_t>(bandpassFile, 2, range);
+    for (const std::vector<float> *values : {&stats.mean, &stats.rms, &stats.median, &stats.mad}) {
+        writeToFileAndVerify<const float>(bandpassFile, nChans, values->data());
+    }
+    fflush(bandpassFile);
+}
+
+void BandpassNormaliser::normalise(std::size_t startSample, std::size_t nSamples, const uint8_t *in, uint8_t *out) {
+    std::map<std::size_t, BandpassStatistics>::iterator stored = storedStatistics.find(startSample);
+    bool reused = stored != storedStatistics.end() && stored->second.nSamples == nSamples;
+    if (reused) {
+        current = stored->second;
+    }
+    else {
+        statistics.compute(nSamples, in, nBits, current);
+        current.startSample = startSample;
+    }
+
+    /* Once a gulp is missing, the file is rewritten with every gulp of this run, starting with those reused so far. */
+    if (!bandpassFileName.empty()) {
+        if (bandpassFile) {
+            appendToBandpassFile(current);
+        }
+        else if (!reused) {
+            for (std::size_t reusedStart : reusedStarts) appendToBandpassFile(storedStatistics[reusedStart]);
+            reusedStarts.clear();
+            appendToBandpassFile(current);
+        }
+        else {
+            reusedStarts.push_back(startSample);
+        }
+    }
+
+    float targetMean, targetSigma, maxValue;
+    if (nBits == 8) {
+        targetMean = 64.0f, targetSigma = 16.0f, maxValue = 255.0f;
+    }
+    else if (nBits == 16) {
+        targetMean = 16384.0f, targetSigma = 1024.0f, maxValue = 65535.0f;
+    }
+    else {
+        targetMean = 0.0f, targetSigma = 1.0f, maxValue = 0.0f;
+    }
+    for (unsigned int c = 0; c < nChans; c++) {
+        float sigma = current.getSigma(c);
+        gains[c] = sigma > 0.0f ? targetSigma / sigma : 0.0f;
+        offsets[c] = targetMean - current.median[c] * gains[c];
+    }
+
+    switch (nBits)
+    {
+    case 8:
+        normaliseOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(nSamples, in, out, maxValue);
+        break;
+    case 16:
+        normaliseOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(in),
+                                                        reinterpret_cast<SIGPROC_FILTERBANK_16_BIT_TYPE *>(out), maxValue);
+        break;
+    default:
+        normaliseOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(in),
+                                                        reinterpret_cast<SIGPROC_FILTERBANK_32_BIT_TYPE *>(out), maxValue);
+        break;
+    }
+}
+
+template <typename DTYPE>
+void BandpassNormaliser::normaliseOfType(std::size_t nSamples, const DTYPE *in, DTYPE *out, float maxValue) {
+    const std::size_t nChans = this->nChans;
+    const float *__restrict__ gain = gains.data();
+    const float *__restrict__ offset = offsets.data();
+
+    statistics.getThreadPool()->parallelFor(0, nSamples, [&](std::size_t sampleStart, std::size_t sampleEnd) {
+        for (std::size_t t = sampleStart; t < sampleEnd; t++) {
+            const DTYPE *__restrict__ row = in + t * nChans;
+            DTYPE *__restrict__ normalised = out + t * nChans;
+            for (std::size_t c = 0; c < nChans; c++) {
+                float value = static_cast<float>(row[c]) * gain[c] + offset[c];
+                if constexpr (std::is_floating_point<DTYPE>::value) {
+                    normalised[c] = value;
+                }
+                else {
+                    normalised[c] = static_cast<DTYPE>(std::min(std::max(value, 0.0f), maxValue) + 0.5f);
+                }
+            }
+        }
+    }, SAMPLES_PER_CHUNK);
+}
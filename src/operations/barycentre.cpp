@@ -0,0 +1,123 @@
+#include "operations/barycentre.hpp"
+#include "utils/sigproc_utils.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+using namespace OPS;
+
+namespace {
+
+    const double SECONDS_PER_DAY = 86400.0;
+
+    /* radians of a sigproc hhmmss.s (scale 15) or ddmmss.s (scale 1) angle */
+    double sigprocToRadians(double sigproc, double scale) {
+        int sign, first, second;
+        double third;
+        parse_angle_sigproc(sigproc, sign, first, second, third);
+        return sign * scale * (first + second / 60.0 + third / 3600.0) * M_PI / 180.0;
+    }
+
+};
+
+Barycentre::Barycentre(const std::vector<EphemerisPoint> &ephemeris, double raj, double decj, double tstart, double tsamp,
+                       std::size_t totalNSamples)
+    : totalNSamples(totalNSamples) {
+    if (tsamp <= 0) throw InvalidInputs("The sampling time must be positive");
+    if (totalNSamples == 0) throw InvalidInputs("There are no samples to barycentre");
+    if (ephemeris.size() < 4) throw InvalidInputs("The ephemeris needs at least 4 points");
+    for (std::size_t p = 1; p < ephemeris.size(); p++) {
+        if (ephemeris[p].mjd <= ephemeris[p - 1].mjd) throw InvalidInputs("The ephemeris epochs must increase");
+    }
+    double tend = tstart + totalNSamples * tsamp / SECONDS_PER_DAY;
+    if (tstart < ephemeris.front().mjd || tend > ephemeris.back().mjd) {
+        throw InvalidInputs("The ephemeris does not cover the observation");
+    }
+
+    double ra = sigprocToRadians(raj, 15.0), dec = sigprocToRadians(decj, 1.0);
+    const double direction[3] = {std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra), std::sin(dec)};
+    auto delay = [&](double sample) {
+        double position[3];
+        interpolate(ephemeris, tstart + sample * tsamp / SECONDS_PER_DAY, position);
+        return position[0] * direction[0] + position[1] * direction[1] + position[2] * direction[2];
+    };
+
+    /* The drift in samples at grid points every step samples, the last one just past the end of the series. */
+    double step = std::max(1.0, std::round(GRID_SECONDS / tsamp));
+    double referenceDelay = delay(0.0);
+    double previousSample = 0.0, previousDrift = 0.0;
+    while (previousSample < totalNSamples) {
+        double sample = std::min(previousSample + step, static_cast<double>(totalNSamples));
+        double drift = (delay(sample) - referenceDelay) / tsamp;
+
+        /* the half-integer levels m + 0.5 in (previousDrift, drift] when rising, [drift, previousDrift) when falling */
+        bool rising = drift > previousDrift;
+        double first = rising ? std::floor(previousDrift - 0.5) + 1.0 : std::ceil(drift - 0.5);
+        double last = rising ? std::floor(drift - 0.5) : std::ceil(previousDrift - 0.5) - 1.0;
+        for (double m = first; m <= last; m++) {
+            double level = rising ? m + 0.5 : last + first - m + 0.5;
+            double crossing = previousSample + (level - previousDrift) / (drift - previousDrift) * (sample - previousSample);
+            std::size_t at = static_cast<std::size_t>(std::ceil(crossing));
+            if (at == 0 || at >= totalNSamples) continue;
+            events.push_back(Event{at, rising});
+            if (rising) nAdded++;
+            else nDropped++;
+        }
+        previousSample = sample;
+        previousDrift = drift;
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) { return a.sample < b.sample; });
+}
+
+void Barycentre::interpolate(const std::vector<EphemerisPoint> &ephemeris, double mjd, double position[3]) {
+    std::size_t after = std::upper_bound(ephemeris.begin(), ephemeris.end(), mjd,
+                                         [](double t, const EphemerisPoint &point) { return t < point.mjd; }) - ephemeris.begin();
+    std::size_t first = std::min(after < 2 ? 0 : after - 2, ephemeris.size() - 4);
+
+    position[0] = position[1] = position[2] = 0.0;
+    for (std::size_t j = first; j < first + 4; j++) {
+        double weight = 1.0;
+        for (std::size_t k = first; k < first + 4; k++) {
+            if (k != j) weight *= (mjd - ephemeris[k].mjd) / (ephemeris[j].mjd - ephemeris[k].mjd);
+        }
+        for (int axis = 0; axis < 3; axis++) position[axis] += weight * ephemeris[j].position[axis];
+    }
+}
+
+void Barycentre::append(const float *in, std::size_t startSample, std::size_t nSamples, std::vector<float> &out) const {
+    std::size_t endSample = startSample + nSamples;
+    auto event = std::lower_bound(events.begin(), events.end(), startSample,
+                                  [](const Event &e, std::size_t sample) { return e.sample < sample; });
+    std::size_t from = startSample;
+    for (; event != events.end() && event->sample < endSample; ++event) {
+        out.insert(out.end(), in + (from - startSample), in + (event->sample - startSample));
+        if (event->add) {
+            out.push_back(in[event->sample - startSample]);
+            from = event->sample;
+        }
+        else {
+            from = event->sample + 1;
+        }
+    }
+    out.insert(out.end(), in + (from - startSample), in + nSamples);
+}
+
+std::vector<EphemerisPoint> Barycentre::readEphemeris(const std::string &fileName) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) throw FileIOError(0, 0, "open " + fileName);
+
+    std::vector<EphemerisPoint> ephemeris;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream columns(line);
+        EphemerisPoint point;
+        if (!(columns >> point.mjd >> point.position[0] >> point.position[1] >> point.position[2])) {
+            throw FileFormatNotRecognised(fileName);
+        }
+        ephemeris.push_back(point);
+    }
+    return ephemeris;
+}
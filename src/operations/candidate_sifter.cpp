@@ -0,0 +1,226 @@
+#include "operations/candidate_sifter.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cmath>
+
+using namespace OPS;
+
+namespace {
+
+    typedef std::pair<long, long> Cell;
+
+    struct CellHash
+    {
+        std::size_t operator()(const Cell &cell) const {
+            return std::hash<long>()(cell.first) * 1000003u ^ std::hash<long>()(cell.second);
+        }
+    };
+
+    class DisjointSets
+    {
+        std::vector<std::size_t> parent;
+
+    public:
+        explicit DisjointSets(std::size_t n) : parent(n) {
+            std::iota(parent.begin(), parent.end(), 0);
+        }
+
+        std::size_t find(std::size_t i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        }
+
+        void unite(std::size_t a, std::size_t b) {
+            a = find(a);
+            b = find(b);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+    };
+
+};
+
+CandidateSifter::CandidateSifter(const std::vector<float> &dmList, const SiftingOptions &options)
+    : options(options), dmList(dmList) {
+    if (dmList.empty()) throw InvalidInputs("The DM list is empty");
+    if (!std::is_sorted(dmList.begin(), dmList.end())) throw InvalidInputs("The DM list must be in increasing order");
+    if (options.dmLink <= 0 || options.sampleLink <= 0 || options.frequencyLink <= 0) {
+        throw InvalidInputs("The link lengths must be positive");
+    }
+    if (options.maxHarmonicRatio == 0) throw InvalidInputs("The largest harmonic ratio must be at least 1");
+}
+
+double CandidateSifter::dmTrial(float dm) const {
+    std::size_t upper = std::lower_bound(dmList.begin(), dmList.end(), dm) - dmList.begin();
+    if (upper == 0) return 0.0;
+    if (upper == dmList.size()) return static_cast<double>(dmList.size() - 1);
+    double low = dmList[upper - 1], high = dmList[upper];
+    return upper - 1 + (high > low ? (dm - low) / (high - low) : 0.0);
+}
+
+/**
+ * Points in one cell are always friends, so each cell is united at once, and a pair of neighbouring cells needs
+ * comparing only until one link is found, and not at all if they already are in the same cluster.
+ */
+std::vector<std::size_t> CandidateSifter::friendsOfFriends(const std::vector<double> &x, const std::vector<double> &y,
+                                                           double linkX, double linkY) {
+    if (x.size() != y.size()) throw InvalidInputs("x and y must have the same number of points");
+    if (linkX <= 0 || linkY <= 0) throw InvalidInputs("The link lengths must be positive");
+
+    std::size_t nPoints = x.size();
+    std::unordered_map<Cell, std::vector<std::size_t>, CellHash> cells;
+    for (std::size_t i = 0; i < nPoints; i++) {
+        Cell cell(static_cast<long>(std::floor(x[i] / linkX)), static_cast<long>(std::floor(y[i] / linkY)));
+        cells[cell].push_back(i);
+    }
+
+    DisjointSets sets(nPoints);
+    for (const auto &cell : cells) {
+        for (std::size_t member : cell.second) sets.unite(cell.second.front(), member);
+    }
+
+    /* Half of the eight neighbours, so that every pair of cells is compared once. */
+    static const long NEIGHBOURS[4][2] = {{1, -1}, {1, 0}, {1, 1}, {0, 1}};
+    for (const auto &cell : cells) {
+        for (const long *offset : NEIGHBOURS) {
+            auto neighbour = cells.find(Cell(cell.first.first + offset[0], cell.first.second + offset[1]));
+            if (neighbour == cells.end()) continue;
+            if (sets.find(cell.second.front()) == sets.find(neighbour->second.front())) continue;
+
+            bool linked = false;
+            for (std::size_t a : cell.second) {
+                for (std::size_t b : neighbour->second) {
+                    if (std::fabs(x[a] - x[b]) <= linkX && std::fabs(y[a] - y[b]) <= linkY) {
+                        sets.unite(a, b);
+                        linked = true;
+                        break;
+                    }
+                }
+                if (linked) break;
+            }
+        }
+    }
+
+    /* Every root is the lowest index of its cluster, so numbering the roots in order numbers the clusters. */
+    std::vector<std::size_t> clusters(nPoints);
+    std::vector<std::size_t> rootCluster(nPoints, nPoints);
+    std::size_t nClusters = 0;
+    for (std::size_t i = 0; i < nPoints; i++) {
+        std::size_t root = sets.find(i);
+        if (rootCluster[root] == nPoints) rootCluster[root] = nClusters++;
+        clusters[i] = rootCluster[root];
+    }
+    return clusters;
+}
+
+std::vector<IO::SinglePulseRecord> CandidateSifter::sift(const std::vector<SinglePulseEvent> &events) const {
+    std::vector<double> trials(events.size()), centres(events.size());
+    for (std::size_t i = 0; i < events.size(); i++) {
+        trials[i] = dmTrial(events[i].dm);
+        centres[i] = events[i].sample + 0.5 * events[i].width;
+    }
+    std::vector<std::size_t> clusters = friendsOfFriends(trials, centres, options.dmLink, options.sampleLink);
+
+    std::size_t nClusters = clusters.empty() ? 0 : *std::max_element(clusters.begin(), clusters.end()) + 1;
+    std::vector<IO::SinglePulseRecord> records(nClusters, IO::SinglePulseRecord{0.0f, 0.0f, 0, 0, 0, 0.0f, 0.0f});
+    for (std::size_t i = 0; i < events.size(); i++) {
+        const SinglePulseEvent &event = events[i];
+        IO::SinglePulseRecord &record = records[clusters[i]];
+        if (record.nMembers == 0) {
+            record.dmMin = record.dmMax = event.dm;
+        }
+        if (record.nMembers == 0 || event.snr > record.snr) {
+            record.dm = event.dm;
+            record.snr = event.snr;
+            record.sample = event.sample;
+            record.width = event.width;
+        }
+        record.nMembers++;
+        record.dmMin = std::min(record.dmMin, event.dm);
+        record.dmMax = std::max(record.dmMax, event.dm);
+    }
+
+    std::stable_sort(records.begin(), records.end(), [](const IO::SinglePulseRecord &a, const IO::SinglePulseRecord &b) {
+        return a.snr > b.snr;
+    });
+    return records;
+}
+
+/**
+ * Harmonics are found by hashing as well: every kept cluster puts its frequency times p / q, for all p / q in lowest
+ * terms, into buckets of frequencyLink bins, and a weaker cluster is merged if a bucket next to its own frequency
+ * holds one within frequencyLink.
+ */
+std::vector<IO::PeriodicityRecord> CandidateSifter::sift(const std::vector<PeriodicityCandidate> &candidates,
+                                                         double observationLength) const {
+    if (observationLength <= 0) throw InvalidInputs("The observation length must be positive");
+
+    std::vector<double> trials(candidates.size()), bins(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        trials[i] = dmTrial(candidates[i].dm);
+        bins[i] = candidates[i].frequency * observationLength;
+    }
+    std::vector<std::size_t> clusters = friendsOfFriends(trials, bins, options.dmLink, options.frequencyLink);
+
+    std::size_t nClusters = clusters.empty() ? 0 : *std::max_element(clusters.begin(), clusters.end()) + 1;
+    std::vector<IO::PeriodicityRecord> records(nClusters, IO::PeriodicityRecord{0.0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0, 0, 0});
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        const PeriodicityCandidate &candidate = candidates[i];
+        IO::PeriodicityRecord &record = records[clusters[i]];
+        if (record.nMembers == 0 || candidate.sigma > record.sigma) {
+            record.frequency = candidate.frequency;
+            record.dm = candidate.dm;
+            record.acceleration = candidate.acceleration;
+            record.jerk = candidate.jerk;
+            record.power = candidate.power;
+            record.sigma = candidate.sigma;
+            record.nHarmonics = candidate.nHarmonics;
+        }
+        record.nMembers++;
+    }
+    std::stable_sort(records.begin(), records.end(), [](const IO::PeriodicityRecord &a, const IO::PeriodicityRecord &b) {
+        return a.sigma > b.sigma;
+    });
+
+    std::vector<double> ratios;
+    for (unsigned int p = 1; p <= options.maxHarmonicRatio; p++) {
+        for (unsigned int q = 1; q <= options.maxHarmonicRatio; q++) {
+            if (std::gcd(p, q) == 1) ratios.push_back(static_cast<double>(p) / q);
+        }
+    }
+
+    const double link = options.frequencyLink;
+    std::unordered_map<long, std::vector<std::pair<double, std::size_t>>> harmonics;
+    std::vector<IO::PeriodicityRecord> kept;
+    for (const IO::PeriodicityRecord &record : records) {
+        double bin = record.frequency * observationLength;
+        long bucket = static_cast<long>(std::floor(bin / link));
+
+        std::size_t related = kept.size();
+        for (long b = bucket - 1; b <= bucket + 1 && related == kept.size(); b++) {
+            auto entries = harmonics.find(b);
+            if (entries == harmonics.end()) continue;
+            for (const std::pair<double, std::size_t> &entry : entries->second) {
+                if (std::fabs(entry.first - bin) <= link) {
+                    related = entry.second;
+                    break;
+                }
+            }
+        }
+        if (related < kept.size()) {
+            kept[related].nRelated++;
+            continue;
+        }
+
+        for (double ratio : ratios) {
+            double harmonicBin = bin * ratio;
+            harmonics[static_cast<long>(std::floor(harmonicBin / link))].emplace_back(harmonicBin, kept.size());
+        }
+        kept.push_back(record);
+    }
+    return kept;
+}
@@ -0,0 +1,118 @@
+#include "operations/cpu_dedisperse.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace OPS;
+
+CPUDedisperser::CPUDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads) : DedispersionBackend(searchModeFile) {
+    this->threadPool = std::make_unique<UTILS::ThreadPool>(nThreads);
+}
+
+void CPUDedisperser::execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData) {
+    if (nSamplesIn <= maxDelaySamples) {
+        throw InvalidInputs("Number of input samples must exceed the maximum delay");
+    }
+    switch (inNBits)
+    {
+    case 8:
+        executeOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_8_BIT_TYPE *>(inData), outData);
+        break;
+    case 16:
+        executeOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(inData), outData);
+        break;
+    case 32:
+        executeOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(inData), outData);
+        break;
+    default:
+        throw InvalidInputs("CPU dedispersion supports 8, 16 and 32 bit input only");
+    }
+}
+
+BackendMemory CPUDedisperser::getWorkingMemory(unsigned int inNBits) {
+    return BackendMemory{static_cast<std::size_t>(nChans) * inNBits / BITS_PER_BYTE,
+                         threadPool->getNThreads() * SAMPLES_PER_BLOCK * sizeof(float)};
+}
+
+template <typename DTYPE>
+void CPUDedisperser::executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData) {
+    DTYPE *transposed = transposeGulp<DTYPE>(nSamplesIn, inData);
+    dedisperseTransposed<DTYPE>(nSamplesIn, transposed, outData);
+}
+
+template <typename DTYPE>
+DTYPE *CPUDedisperser::transposeGulp(std::size_t nSamplesIn, const DTYPE *inData) {
+    std::size_t nElements = nSamplesIn * nChans;
+    if (transposedData.size() < nElements * sizeof(DTYPE)) transposedData.resize(nElements * sizeof(DTYPE));
+
+    DTYPE *transposed = reinterpret_cast<DTYPE *>(transposedData.data());
+    transpose<DTYPE>(nSamplesIn, inData, transposed);
+    return transposed;
+}
+
+/**
+ * Blocked [sample][chan] -> [chan][sample] transpose, parallel over channel blocks.
+ */
+template <typename DTYPE>
+void CPUDedisperser::transpose(std::size_t nSamplesIn, const DTYPE *inData, DTYPE *outData) {
+    const std::size_t tile = 64;
+    const std::size_t nChans = this->nChans;
+    std::size_t nChanTiles = (nChans + tile - 1) / tile;
+
+    threadPool->parallelFor(0, nChanTiles, [&](std::size_t tileStart, std::size_t tileEnd) {
+        for (std::size_t chanTile = tileStart; chanTile < tileEnd; chanTile++) {
+            std::size_t c0 = chanTile * tile;
+            std::size_t c1 = std::min(nChans, c0 + tile);
+            for (std::size_t t0 = 0; t0 < nSamplesIn; t0 += tile) {
+                std::size_t t1 = std::min(nSamplesIn, t0 + tile);
+                for (std::size_t c = c0; c < c1; c++) {
+                    DTYPE *__restrict__ dst = outData + c * nSamplesIn;
+                    for (std::size_t t = t0; t < t1; t++) {
+                        dst[t] = inData[t * nChans + c];
+                    }
+                }
+            }
+        }
+    });
+}
+
+template <typename DTYPE>
+void CPUDedisperser::dedisperseTransposed(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData) {
+    std::size_t nSamplesOut = nSamplesIn - maxDelaySamples;
+    std::size_t nDMs = dmList.size();
+
+    std::vector<unsigned int> activeChans;
+    for (unsigned int c = 0; c < nChans; c++) {
+        if (killmask[c]) activeChans.push_back(c);
+    }
+
+    threadPool->parallelFor(0, nDMs, [&](std::size_t dmStart, std::size_t dmEnd) {
+        std::vector<float> accumulator(SAMPLES_PER_BLOCK);
+        std::vector<std::size_t> delays(activeChans.size());
+
+        for (std::size_t iDM = dmStart; iDM < dmEnd; iDM++) {
+            for (std::size_t i = 0; i < activeChans.size(); i++) {
+                delays[i] = getDelaySamples(dmList[iDM], activeChans[i]);
+            }
+            DEDISP_OUTPUT_TYPE *dmOut = outData + iDM * nSamplesOut;
+
+            for (std::size_t t0 = 0; t0 < nSamplesOut; t0 += SAMPLES_PER_BLOCK) {
+                std::size_t blockLength = std::min(SAMPLES_PER_BLOCK, nSamplesOut - t0);
+                float *__restrict__ acc = accumulator.data();
+                std::fill(acc, acc + blockLength, 0.0f);
+
+                for (std::size_t i = 0; i < activeChans.size(); i++) {
+                    const DTYPE *__restrict__ src = inData + activeChans[i] * nSamplesIn + t0 + delays[i];
+                    for (std::size_t t = 0; t < blockLength; t++) {
+                        acc[t] += static_cast<float>(src[t]);
+                    }
+                }
+                std::copy(acc, acc + blockLength, dmOut + t0);
+            }
+        }
+    });
+}
+
+template SIGPROC_FILTERBANK_8_BIT_TYPE *CPUDedisperser::transposeGulp<SIGPROC_FILTERBANK_8_BIT_TYPE>(std::size_t, const SIGPROC_FILTERBANK_8_BIT_TYPE *);
+template SIGPROC_FILTERBANK_16_BIT_TYPE *CPUDedisperser::transposeGulp<SIGPROC_FILTERBANK_16_BIT_TYPE>(std::size_t, const SIGPROC_FILTERBANK_16_BIT_TYPE *);
+template SIGPROC_FILTERBANK_32_BIT_TYPE *CPUDedisperser::transposeGulp<SIGPROC_FILTERBANK_32_BIT_TYPE>(std::size_t, const SIGPROC_FILTERBANK_32_BIT_TYPE *);
@@ -0,0 +1,33 @@
+#ifdef USE_CUDA
+#include "operations/dedisp_gpu_backend.hpp"
+#include "exceptions.hpp"
+
+using namespace OPS;
+
+DedispGPUBackend::DedispGPUBackend(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int numGpus) : DedispersionBackend(searchModeFile) {
+    /* dedisp plans run on the current device only: there is no splitting of the DMs over devices yet. */
+    if (numGpus > 1) {
+        throw InvalidInputs("The gpu backend dedisperses on a single GPU, but " + std::to_string(numGpus) + " were requested");
+    }
+    dedisp_error error = dedisp_create_plan(&this->plan, nChans, tsamp, fch1, foff);
+    ErrorChecker::check_dedisp_error(error, "create_plan");
+}
+
+void DedispGPUBackend::setDMList(const std::vector<float> &dmList) {
+    DedispersionBackend::setDMList(dmList);
+    dedisp_error error = dedisp_set_dm_list(this->plan, this->dmList.data(), this->dmList.size());
+    ErrorChecker::check_dedisp_error(error, "set_dm_list");
+    this->maxDelaySamples = dedisp_get_max_delay(plan);
+}
+
+void DedispGPUBackend::setKillMask(const std::vector<DEDISP_BOOL> &killmask) {
+    DedispersionBackend::setKillMask(killmask);
+    dedisp_error error = dedisp_set_killmask(plan, this->killmask.data());
+    ErrorChecker::check_dedisp_error(error, "set_killmask");
+}
+
+void DedispGPUBackend::execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData) {
+    dedisp_error error = dedisp_execute(plan, nSamplesIn, inData, inNBits, reinterpret_cast<uint8_t *>(outData), 32, (unsigned)0);
+    ErrorChecker::check_dedisp_error(error, "execute");
+}
+#endif
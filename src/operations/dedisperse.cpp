@@ -4,7 +4,11 @@
 #include "utils/app_utils.hpp"
 #include <vector>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 using namespace OPS;
 
@@ -40,21 +44,31 @@ void Dedisperser::populateDMList(std::shared_ptr<std::vector<float>> dmList, con
 
 
 
-Dedisperser::Dedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int numGpus, std::shared_ptr<std::vector<float>> dmList, bool writeToFile, std::size_t gulpNSamples){
+Dedisperser::Dedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, const DedispersionOptions &options, std::shared_ptr<std::vector<float>> dmList, bool writeToFile, std::size_t gulpNSamples){
 
     this->searchModeFile = searchModeFile;
-    this->numGpus = numGpus;
     this->writeToFile = writeToFile;
+    setGulpSize(gulpNSamples);
 
+    this->backend = DedispersionBackend::createInstance(options, searchModeFile);
+    this->setDMList(dmList);
+
+    std::size_t nSamples = static_cast<std::size_t>(searchModeFile->getHeaderFields().nSamples);
+    std::size_t totalNSamplesOut = nSamples > maxDelaySamples ? nSamples - maxDelaySamples : 0;
+    this->multiTimeSeries = std::make_unique<IO::MultiTimeSeries>(this->dmList, this->gulpNSamples, totalNSamplesOut, writeToFile);
+    this->killmask = std::make_shared<std::vector<DEDISP_BOOL>>(searchModeFile->getNChans(),1);
+}
+
+void Dedisperser::setGulpSize(std::size_t gulpNSamples){
     if(gulpNSamples == 0) {
         gulping = false;
-        this->gulpNSamples = searchModeFile->getValueForKey<std::size_t>(NSAMPLES);
+        this->gulpNSamples = static_cast<std::size_t>(searchModeFile->getHeaderFields().nSamples);
     }
-    else if (gulpNSamples < searchModeFile->getValueForKey<std::size_t>(NSAMPLES)) {
+    else if (gulpNSamples < static_cast<std::size_t>(searchModeFile->getHeaderFields().nSamples)) {
         gulping= true; 
         this->gulpNSamples = gulpNSamples;  
     }
-    else if (gulpNSamples == searchModeFile->getValueForKey<std::size_t>(NSAMPLES)) {
+    else if (gulpNSamples == static_cast<std::size_t>(searchModeFile->getHeaderFields().nSamples)) {
         gulping = false;
         this->gulpNSamples = gulpNSamples;
     }
@@ -62,17 +76,23 @@ Dedisperser::Dedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, uns
     else {
         throw InvalidInputs("NSAMPLES to gulp cannot be greater than NSAMPLES");
     }
+}
 
-    dedisp_error error = dedisp_create_plan(&this->plan,
-                    searchModeFile->getValueForKey<int>(NCHANS),
-                    searchModeFile->getValueForKey<float>(TSAMP),
-                    searchModeFile->getValueForKey<float>(FCH1),
-                    searchModeFile->getValueForKey<float>(FOFF));
-    ErrorChecker::check_dedisp_error(error,"create_plan_multi");
-    this->setDMList(dmList);
-    this->maxDelaySamples = dedisp_get_max_delay(plan);
-    this->multiTimeSeries = std::make_unique<IO::MultiTimeSeries>(dmList, this->gulpNSamples, searchModeFile->getValueForKey<std::size_t>(NSAMPLES), writeToFile);
-    this->killmask = std::make_shared<std::vector<DEDISP_BOOL>>(searchModeFile->getNChans(),1);
+void Dedisperser::setGulpNSamples(std::size_t gulpNSamples){
+    setGulpSize(gulpNSamples);
+    this->multiTimeSeries->setGulpNSamples(this->gulpNSamples);
+}
+
+/**
+ * @brief Sets how many input samples will be streamed through dedisperse(), so the output headers carry the right length.
+ */
+void Dedisperser::setNSamplesToProcess(std::size_t nSamples){
+    this->multiTimeSeries->setTotalNSamples(nSamples > maxDelaySamples ? nSamples - maxDelaySamples : 0);
+}
+
+void Dedisperser::resetOverlap(){
+    this->nOverlapSamples = 0;
+    this->streamEndByte = 0;
 }
 
 void Dedisperser::setOutputOptions(std::string outputDir, std::string outputPrefix, std::string outputSuffix, std::string outputFormat, std::shared_ptr<IO::SearchModeFile> searchModeFile){
@@ -90,29 +110,178 @@ void Dedisperser::setDMList(std::shared_ptr<std::vector<float>> dmList)
     else {
         this->dmList = std::make_shared<std::vector<float>>(dmList->size());
     }
-    std::copy(dmList->begin(), dmList->end(), this->dmList->begin());
+    this->dmList->assign(dmList->begin(), dmList->end());
 
-    dedisp_error error = dedisp_set_dm_list(this->plan, this->dmList->data(), this->dmList->size());
-    this->maxDelaySamples = dedisp_get_max_delay(plan);
-    ErrorChecker::check_dedisp_error(error, "set_dm_list");
+    backend->setDMList(*this->dmList);
+    this->maxDelaySamples = backend->getMaxDelaySamples();
+    this->nOverlapSamples = 0;
+    this->streamEndByte = 0;
+}
+
+BackendMemory Dedisperser::getBackendMemory()
+{
+    /* sub-byte data are unpacked to one byte per sample on read */
+    return backend->getWorkingMemory(std::max(searchModeFile->getHeaderFields().nBits, BITS_PER_BYTE));
 }
 
 void Dedisperser::setKillMask(std::shared_ptr<std::vector<int>> killmask_in)
 {
     killmask->swap(*killmask_in);
-    dedisp_error error = dedisp_set_killmask(plan, &killmask->at(0));
-    ErrorChecker::check_dedisp_error(error, "set_killmask");
+    backend->setKillMask(*killmask);
+    gulpKillmask.clear();
 }
 
 void Dedisperser::setKillMask(std::string fileName)
 {
     std::shared_ptr<std::vector<int>> newKillMask = generateListFromAsciiMaskFile<int>(fileName, searchModeFile->getNChans());
     killmask->swap(*newKillMask);
-    dedisp_error error = dedisp_set_killmask(plan, &killmask->at(0));
-    ErrorChecker::check_dedisp_error(error, "set_killmask");
+    backend->setKillMask(*killmask);
+    gulpKillmask.clear();
 }
 
+void Dedisperser::setRFIFlagger(std::shared_ptr<RFIFlagger> rfiFlagger){
+    this->rfiFlagger = rfiFlagger;
+    if (!rfiFlagger) {
+        gulpKillmask.clear();
+        backend->setKillMask(*killmask);
+    }
+}
+
+void Dedisperser::setNormaliser(std::shared_ptr<BandpassNormaliser> normaliser){
+    this->normaliser = normaliser;
+}
+
+void Dedisperser::setZeroDMFilter(std::shared_ptr<ZeroDMFilter> zeroDMFilter){
+    this->zeroDMFilter = zeroDMFilter;
+}
+
+void Dedisperser::setPrefetcher(std::shared_ptr<IO::GulpPrefetcher> prefetcher){
+    this->prefetcher = prefetcher;
+}
 
+void Dedisperser::setOutputNBits(unsigned int outputNBits){
+    this->multiTimeSeries->setOutputNBits(outputNBits);
+}
 
+std::size_t Dedisperser::getNOutputSamplesClipped(){
+    return this->multiTimeSeries->getNSamplesClipped();
+}
 
+void Dedisperser::setNWriterThreads(unsigned int nWriterThreads){
+    this->multiTimeSeries->setNWriterThreads(nWriterThreads);
+}
 
+void Dedisperser::addConsumer(std::shared_ptr<IO::DedispersedConsumer> consumer, std::size_t dmsPerBlock){
+    this->multiTimeSeries->addConsumer(consumer, dmsPerBlock);
+}
+
+void Dedisperser::setMaxBufferedGulps(std::size_t maxBufferedGulps){
+    this->multiTimeSeries->setMaxBufferedGulps(maxBufferedGulps);
+}
+
+void Dedisperser::finish(){
+    this->multiTimeSeries->finish();
+}
+
+std::size_t Dedisperser::dedisperse(std::size_t startByte, std::size_t nBytesToRead){
+
+    /* A mapped file already holds the previous gulp's tail right before startByte, so nothing needs stitching. */
+    bool preprocessing = normaliser || zeroDMFilter;
+    bool inPlace = !preprocessing && !prefetcher && searchModeFile->isMemoryMapped() && searchModeFile->getNBits() >= BITS_PER_BYTE;
+    if (inPlace && nOverlapSamples > 0 && startByte != streamEndByte) {
+        throw InvalidInputs("Gulps of a memory-mapped file must be contiguous; call resetOverlap() before seeking");
+    }
+    std::size_t carriedBytes = inPlace ? searchModeFile->samplesToBytes(nOverlapSamples) : 0;
+
+    std::shared_ptr<IO::DataBufferBase> gulpBuffer;
+    if (prefetcher) {
+        gulpBuffer = prefetcher->next(startByte, nBytesToRead);
+    }
+    else {
+        searchModeFile->readNBytes(startByte - carriedBytes, nBytesToRead + carriedBytes);
+        gulpBuffer = searchModeFile->container;
+    }
+    streamEndByte = startByte + nBytesToRead;
+
+    std::size_t nSamplesNew = searchModeFile->bytesToSamples(nBytesToRead);
+
+    /* sub-byte data are unpacked to one byte per sample on read */
+    unsigned int inNBits = std::max(searchModeFile->getHeaderFields().nBits, BITS_PER_BYTE);
+    if (inNBits != 8 && inNBits != 16 && inNBits != 32) {
+        throw InvalidInputs("Unsupported NBITS for dedispersion");
+    }
+    const uint8_t* newData = static_cast<const uint8_t*>(gulpBuffer->getData());
+
+    std::size_t bytesPerSample = searchModeFile->getNChans() * inNBits / BITS_PER_BYTE;
+    std::size_t nSamplesIn = nOverlapSamples + nSamplesNew;
+    const uint8_t* inData = newData;
+
+    /* Preprocessed samples are written straight behind the carried-over tail, which was processed with its own gulp. */
+    uint8_t* writable = nullptr;
+    if (preprocessing) {
+        if (overlapBuffer.size() < nSamplesIn * bytesPerSample) overlapBuffer.resize(nSamplesIn * bytesPerSample);
+        writable = overlapBuffer.data() + nOverlapSamples * bytesPerSample;
+        if (normaliser) {
+            normaliser->normalise(searchModeFile->bytesToSamples(startByte), nSamplesNew, newData, writable);
+        }
+        else {
+            std::memcpy(writable, newData, nSamplesNew * bytesPerSample);
+        }
+        inData = overlapBuffer.data();
+    }
+    /* Only the tail of the previous gulp needs to be stitched in front; the first gulp is used in place. */
+    else if (nOverlapSamples > 0 && !inPlace) {
+        if (overlapBuffer.size() < nSamplesIn * bytesPerSample) overlapBuffer.resize(nSamplesIn * bytesPerSample);
+        std::memcpy(overlapBuffer.data() + nOverlapSamples * bytesPerSample, newData, nSamplesNew * bytesPerSample);
+        inData = overlapBuffer.data();
+    }
+
+    /* The flags of the new samples also cover the carried-over tail, which was dedispersed for the previous gulp. */
+    if (rfiFlagger) {
+        const std::vector<DEDISP_BOOL> &flags = normaliser ? rfiFlagger->flag(normaliser->getStatistics())
+                                                           : rfiFlagger->flag(nSamplesNew, newData, inNBits);
+        std::vector<DEDISP_BOOL> combined(killmask->size());
+        for (std::size_t c = 0; c < combined.size(); c++) combined[c] = (*killmask)[c] && flags[c];
+        if (combined != gulpKillmask) {
+            gulpKillmask.swap(combined);
+            backend->setKillMask(gulpKillmask);
+        }
+        std::size_t firstSample = searchModeFile->bytesToSamples(startByte);
+        /* formatted apart, so that std::cout keeps its own precision */
+        std::ostringstream percentage;
+        percentage << std::fixed << std::setprecision(1) << 100.0f * rfiFlagger->getFlaggedFraction();
+        std::cout << "RFI: flagged " << std::count(flags.begin(), flags.end(), 0) << " of " << flags.size() << " channels ("
+                  << percentage.str() << "%) in samples " << firstSample << "-" << firstSample + nSamplesNew << std::endl;
+    }
+
+    if (zeroDMFilter) {
+        zeroDMFilter->apply(nSamplesNew, writable, inNBits, rfiFlagger ? gulpKillmask : *killmask);
+    }
+
+    if (nSamplesIn <= maxDelaySamples) {
+        if (nOverlapSamples == 0 && !inPlace && !preprocessing) {
+            overlapBuffer.assign(newData, newData + nSamplesIn * bytesPerSample);
+        }
+        nOverlapSamples = nSamplesIn;
+        if (prefetcher) prefetcher->release(gulpBuffer);
+        return 0;
+    }
+
+    std::size_t nSamplesOut = nSamplesIn - maxDelaySamples;
+    std::shared_ptr<std::vector<DEDISP_OUTPUT_TYPE>> dedispersedData = multiTimeSeries->getCurrentDedispersedDataPtr();
+    backend->execute(nSamplesIn, inData, inNBits, dedispersedData->data());
+    multiTimeSeries->flush(nSamplesOut);
+
+    /* Keep the last maxDelaySamples input samples: they are the start of the next gulp's first output sample. */
+    if (!inPlace) {
+        std::size_t tailBytes = maxDelaySamples * bytesPerSample;
+        if (overlapBuffer.size() < tailBytes) overlapBuffer.resize(tailBytes);
+        std::memmove(overlapBuffer.data(), inData + nSamplesOut * bytesPerSample, tailBytes);
+    }
+    nOverlapSamples = maxDelaySamples;
+
+    /* The tail now lives in overlapBuffer, so the gulp buffer can take the next read. */
+    if (prefetcher) prefetcher->release(gulpBuffer);
+
+    return nSamplesOut;
+}
@@ -0,0 +1,85 @@
+#include "operations/dedispersion_backend.hpp"
+#include "operations/cpu_dedisperse.hpp"
+#include "operations/subband_dedisperse.hpp"
+#include "operations/fdmt.hpp"
+#include "operations/dedisp_gpu_backend.hpp"
+#include "utils/gen_utils.hpp"
+#include "exceptions.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace OPS;
+
+std::unique_ptr<DedispersionBackend> DedispersionBackend::createInstance(const DedispersionOptions &options, std::shared_ptr<IO::SearchModeFile> searchModeFile) {
+
+    std::string backendName = options.backendName;
+    unsigned int nWorkers = options.nWorkers;
+    if (backendName.empty()) {
+        backendName = defaultBackendName();
+    }
+
+    if (caseInsensitiveCompare(backendName, "cpu")) {
+        return std::make_unique<CPUDedisperser>(searchModeFile, nWorkers);
+    }
+    else if (caseInsensitiveCompare(backendName, "subband")) {
+        return std::make_unique<SubbandDedisperser>(searchModeFile, nWorkers, options.nSubbands, options.subbandSmearing);
+    }
+    else if (caseInsensitiveCompare(backendName, "fdmt")) {
+        return std::make_unique<FDMTDedisperser>(searchModeFile, nWorkers);
+    }
+    else if (caseInsensitiveCompare(backendName, "gpu")) {
+#ifdef USE_CUDA
+        return std::make_unique<DedispGPUBackend>(searchModeFile, nWorkers);
+#else
+        throw FunctionalityNotImplemented("GPU dedispersion in a build without CUDA. Rebuild with USE_CUDA=1 or use --backend cpu");
+#endif
+    }
+    else {
+        throw InvalidInputs("Unknown dedispersion backend: " + backendName);
+    }
+}
+
+std::string DedispersionBackend::defaultBackendName() {
+#ifdef USE_CUDA
+    return "gpu";
+#else
+    return "cpu";
+#endif
+}
+
+DedispersionBackend::DedispersionBackend(std::shared_ptr<IO::SearchModeFile> searchModeFile) {
+    this->nChans = searchModeFile->getNChans();
+    this->tsamp = searchModeFile->getTsamp();
+    this->fch1 = searchModeFile->getFch1();
+    this->foff = searchModeFile->getFoff();
+    this->maxDelaySamples = 0;
+    this->killmask.assign(nChans, 1);
+    generateDelayTable();
+}
+
+/* Same convention as dedisp's generate_delay_table: delays are measured from the highest frequency in the band. */
+void DedispersionBackend::generateDelayTable() {
+    delayTable.resize(nChans);
+    double fTop = std::max(fch1, fch1 + (nChans - 1) * foff);
+    for (unsigned int c = 0; c < nChans; c++) {
+        double f = fch1 + c * foff;
+        delayTable[c] = DISPERSION_CONSTANT / tsamp * (1.0 / (f * f) - 1.0 / (fTop * fTop));
+    }
+}
+
+void DedispersionBackend::setDMList(const std::vector<float> &dmList) {
+    this->dmList = dmList;
+    this->maxDelaySamples = 0;
+    if (this->dmList.empty()) return;
+
+    float maxDM = *std::max_element(this->dmList.begin(), this->dmList.end());
+    float maxDelayPerDM = *std::max_element(delayTable.begin(), delayTable.end());
+    this->maxDelaySamples = static_cast<std::size_t>(maxDM * maxDelayPerDM + 0.5f);
+}
+
+void DedispersionBackend::setKillMask(const std::vector<DEDISP_BOOL> &killmask) {
+    if (killmask.size() != nChans) {
+        throw InvalidInputs("Killmask size does not match the number of channels");
+    }
+    this->killmask = killmask;
+}
@@ -0,0 +1,212 @@
+#include "operations/fdmt.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace OPS;
+
+FDMTDedisperser::FDMTDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads) : CPUDedisperser(searchModeFile, nThreads) {
+    this->maxFDMTDelay = 0;
+    this->maxDM = 0.0f;
+}
+
+/* Delay in samples per unit DM between two frequencies, measured between channel edges. */
+double FDMTDedisperser::getBandDelayPerDM(double fLow, double fHigh) {
+    return DISPERSION_CONSTANT / tsamp * (1.0 / (fLow * fLow) - 1.0 / (fHigh * fHigh));
+}
+
+std::size_t FDMTDedisperser::getSubbandMaxDelay(double fLow, double fHigh) {
+    return static_cast<std::size_t>(std::ceil(maxDM * getBandDelayPerDM(fLow, fHigh)));
+}
+
+void FDMTDedisperser::setDMList(const std::vector<float> &dmList) {
+    DedispersionBackend::setDMList(dmList);
+
+    double halfChannel = 0.5 * std::fabs(foff);
+    double fTop = std::max(fch1, fch1 + (nChans - 1) * foff) + halfChannel;
+    double fBottom = std::min(fch1, fch1 + (nChans - 1) * foff) - halfChannel;
+    double bandDelayPerDM = getBandDelayPerDM(fBottom, fTop);
+
+    maxDM = this->dmList.empty() ? 0.0f : *std::max_element(this->dmList.begin(), this->dmList.end());
+    dmRows.resize(this->dmList.size());
+    maxFDMTDelay = 0;
+    for (std::size_t i = 0; i < this->dmList.size(); i++) {
+        dmRows[i] = static_cast<std::size_t>(std::lround(this->dmList[i] * bandDelayPerDM));
+        maxFDMTDelay = std::max(maxFDMTDelay, dmRows[i]);
+    }
+    maxDelaySamples = std::max(maxDelaySamples, maxFDMTDelay);
+}
+
+void FDMTDedisperser::execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData) {
+    if (nSamplesIn <= maxDelaySamples) {
+        throw InvalidInputs("Number of input samples must exceed the maximum delay");
+    }
+    switch (inNBits)
+    {
+    case 8:
+        executeOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_8_BIT_TYPE *>(inData), outData);
+        break;
+    case 16:
+        executeOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(inData), outData);
+        break;
+    case 32:
+        executeOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(inData), outData);
+        break;
+    default:
+        throw InvalidInputs("FDMT dedispersion supports 8, 16 and 32 bit input only");
+    }
+}
+
+/* Follows the subbands of initialise() and merge() without allocating their rows. */
+std::size_t FDMTDedisperser::getPeakRows() {
+    double halfChannel = 0.5 * std::fabs(foff);
+    std::vector<std::pair<double, double>> bands(nChans);
+    std::size_t rows = 0;
+    for (unsigned int i = 0; i < nChans; i++) {
+        unsigned int chan = foff < 0 ? i : nChans - 1 - i;
+        double f = fch1 + chan * foff;
+        bands[i] = {f + halfChannel, f - halfChannel};
+        rows += getSubbandMaxDelay(bands[i].second, bands[i].first) + 1;
+    }
+
+    std::size_t peakRows = rows;
+    while (bands.size() > 1) {
+        std::size_t nMerged = (bands.size() + 1) / 2;
+        std::vector<std::pair<double, double>> merged(nMerged);
+        std::size_t mergedRows = 0;
+        for (std::size_t s = 0; s < nMerged; s++) {
+            /* A carried-over subband keeps its rows, which are already counted. */
+            if (2 * s + 1 >= bands.size()) {
+                merged[s] = bands[2 * s];
+                continue;
+            }
+            merged[s] = {bands[2 * s].first, bands[2 * s + 1].second};
+            std::size_t maxDelay = getSubbandMaxDelay(merged[s].second, merged[s].first);
+            if (nMerged == 1) maxDelay = std::max(maxDelay, maxFDMTDelay);
+            mergedRows += maxDelay + 1;
+        }
+        peakRows = std::max(peakRows, rows + mergedRows);
+        rows = mergedRows + (bands.size() % 2 ? getSubbandMaxDelay(bands.back().second, bands.back().first) + 1 : 0);
+        bands.swap(merged);
+    }
+    return peakRows;
+}
+
+BackendMemory FDMTDedisperser::getWorkingMemory(unsigned int inNBits) {
+    return BackendMemory{static_cast<std::size_t>(nChans) * inNBits / BITS_PER_BYTE
+                             + (getPeakRows() + threadPool->getNThreads()) * sizeof(float), 0};
+}
+
+template <typename DTYPE>
+void FDMTDedisperser::executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData) {
+    const DTYPE *transposed = transposeGulp<DTYPE>(nSamplesIn, inData);
+    std::size_t nSamplesOut = nSamplesIn - maxDelaySamples;
+
+    std::vector<FDMTSubband> subbands, merged;
+    initialise<DTYPE>(nSamplesIn, transposed, subbands);
+    while (subbands.size() > 1) {
+        merge(nSamplesIn, subbands, merged);
+        subbands.swap(merged);
+    }
+
+    const FDMTSubband &plane = subbands.front();
+    threadPool->parallelFor(0, dmList.size(), [&](std::size_t dmStart, std::size_t dmEnd) {
+        for (std::size_t iDM = dmStart; iDM < dmEnd; iDM++) {
+            const float *row = plane.rows.data() + std::min(dmRows[iDM], plane.maxDelay) * nSamplesIn;
+            std::copy(row, row + nSamplesOut, outData + iDM * nSamplesOut);
+        }
+    });
+}
+
+/**
+ * One subband per channel, ordered from the top of the band down. Row d holds the mean of the d + 1 samples a
+ * dispersed pulse with a delay of d samples across the channel is spread over, so every channel contributes with the
+ * same weight as in brute-force dedispersion. Masked channels are left at zero.
+ */
+template <typename DTYPE>
+void FDMTDedisperser::initialise(std::size_t nSamplesIn, const DTYPE *transposed, std::vector<FDMTSubband> &subbands) {
+    double halfChannel = 0.5 * std::fabs(foff);
+
+    subbands.resize(nChans);
+    for (unsigned int i = 0; i < nChans; i++) {
+        unsigned int chan = foff < 0 ? i : nChans - 1 - i;
+        double f = fch1 + chan * foff;
+        FDMTSubband &subband = subbands[i];
+        subband.fHigh = f + halfChannel;
+        subband.fLow = f - halfChannel;
+        subband.maxDelay = getSubbandMaxDelay(subband.fLow, subband.fHigh);
+        subband.rows.assign((subband.maxDelay + 1) * nSamplesIn, 0.0f);
+    }
+
+    threadPool->parallelFor(0, nChans, [&](std::size_t start, std::size_t end) {
+        std::vector<float> runningSum(nSamplesIn);
+        for (std::size_t i = start; i < end; i++) {
+            unsigned int chan = foff < 0 ? i : nChans - 1 - i;
+            if (!killmask[chan]) continue;
+
+            FDMTSubband &subband = subbands[i];
+            const DTYPE *__restrict__ src = transposed + static_cast<std::size_t>(chan) * nSamplesIn;
+            float *__restrict__ sum = runningSum.data();
+            for (std::size_t t = 0; t < nSamplesIn; t++) sum[t] = static_cast<float>(src[t]);
+
+            for (std::size_t d = 0; d <= subband.maxDelay; d++) {
+                if (d > 0) {
+                    for (std::size_t t = 0; t + d < nSamplesIn; t++) sum[t] += static_cast<float>(src[t + d]);
+                }
+                float norm = 1.0f / (d + 1);
+                float *__restrict__ row = subband.rows.data() + d * nSamplesIn;
+                for (std::size_t t = 0; t + d < nSamplesIn; t++) row[t] = sum[t] * norm;
+            }
+        }
+    });
+}
+
+/**
+ * Merges neighbouring pairs (upper, lower) of subbands. A pulse crossing the merged band with a delay of d samples
+ * crosses the upper half with dHigh of them and enters the lower half dHigh samples later. An odd subband at the
+ * bottom of the band is carried over unchanged.
+ */
+void FDMTDedisperser::merge(std::size_t nSamplesIn, std::vector<FDMTSubband> &subbands, std::vector<FDMTSubband> &merged) {
+    std::size_t nMerged = (subbands.size() + 1) / 2;
+    bool isLast = nMerged == 1;
+
+    merged.clear();
+    merged.resize(nMerged);
+
+    /* Flattened (subband, delay) jobs so that the few rows of early iterations still spread over all threads. */
+    std::vector<std::pair<std::size_t, std::size_t>> jobs;
+    for (std::size_t s = 0; s < nMerged; s++) {
+        FDMTSubband &out = merged[s];
+        if (2 * s + 1 >= subbands.size()) {
+            out = std::move(subbands[2 * s]);
+            continue;
+        }
+        out.fHigh = subbands[2 * s].fHigh;
+        out.fLow = subbands[2 * s + 1].fLow;
+        out.maxDelay = getSubbandMaxDelay(out.fLow, out.fHigh);
+        if (isLast) out.maxDelay = std::max(out.maxDelay, maxFDMTDelay);
+        out.rows.assign((out.maxDelay + 1) * nSamplesIn, 0.0f);
+        for (std::size_t d = 0; d <= out.maxDelay; d++) jobs.emplace_back(s, d);
+    }
+
+    threadPool->parallelFor(0, jobs.size(), [&](std::size_t jobStart, std::size_t jobEnd) {
+        for (std::size_t j = jobStart; j < jobEnd; j++) {
+            std::size_t s = jobs[j].first;
+            std::size_t d = jobs[j].second;
+            const FDMTSubband &upper = subbands[2 * s];
+            const FDMTSubband &lower = subbands[2 * s + 1];
+            FDMTSubband &out = merged[s];
+
+            double fraction = getBandDelayPerDM(upper.fLow, upper.fHigh) / getBandDelayPerDM(out.fLow, out.fHigh);
+            std::size_t dHigh = std::min<std::size_t>(std::lround(d * fraction), upper.maxDelay);
+            std::size_t dLow = std::min(d - dHigh, lower.maxDelay);
+            if (d + 1 > nSamplesIn) continue;
+
+            const float *__restrict__ upperRow = upper.rows.data() + dHigh * nSamplesIn;
+            const float *__restrict__ lowerRow = lower.rows.data() + dLow * nSamplesIn + dHigh;
+            float *__restrict__ row = out.rows.data() + d * nSamplesIn;
+            std::size_t nValid = nSamplesIn - std::max(d, dHigh + dLow);
+            for (std::size_t t = 0; t < nValid; t++) row[t] = upperRow[t] + lowerRow[t];
+        }
+    });
+}
@@ -0,0 +1,214 @@
+#include "operations/fft.hpp"
+#include "exceptions.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace OPS;
+
+namespace {
+
+    const double TWO_PI = 6.283185307179586;
+
+    /* (x + iy) * -i */
+    inline FFT_COMPLEX_TYPE timesMinusI(FFT_COMPLEX_TYPE value) {
+        return FFT_COMPLEX_TYPE(value.imag(), -value.real());
+    }
+
+    inline FFT_COMPLEX_TYPE twiddle(double numerator, double denominator) {
+        double angle = -TWO_PI * numerator / denominator;
+        return FFT_COMPLEX_TYPE(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+
+};
+
+bool ComplexFFT::isSupportedLength(std::size_t length) {
+    if (length == 0) return false;
+    for (std::size_t factor : {2, 3, 5}) {
+        while (length % factor == 0) length /= factor;
+    }
+    return length == 1;
+}
+
+ComplexFFT::ComplexFFT(std::size_t length) : length(length) {
+    if (!isSupportedLength(length)) {
+        throw InvalidInputs("FFT lengths must only have prime factors 2, 3 and 5, not " + std::to_string(length));
+    }
+
+    std::vector<unsigned int> radices;
+    std::size_t remaining = length;
+    for (unsigned int radix : {4u, 2u, 3u, 5u}) {
+        while (remaining % radix == 0) {
+            radices.push_back(radix);
+            remaining /= radix;
+        }
+    }
+
+    std::size_t subLength = length;
+    std::size_t stride = 1;
+    for (unsigned int radix : radices) {
+        Pass pass;
+        pass.radix = radix;
+        pass.length = subLength;
+        pass.stride = stride;
+        std::size_t nButterflies = subLength / radix;
+        pass.twiddles.resize(nButterflies * (radix - 1));
+        for (std::size_t p = 0; p < nButterflies; p++) {
+            for (unsigned int u = 1; u < radix; u++) {
+                pass.twiddles[p * (radix - 1) + u - 1] = twiddle(static_cast<double>(u * p), static_cast<double>(subLength));
+            }
+        }
+        passes.push_back(std::move(pass));
+        subLength /= radix;
+        stride *= radix;
+    }
+}
+
+/**
+ * Splits each of the stride interleaved sub-transforms of the pass into radix sub-transforms of a radix-th of the
+ * length: out[q + s * (r * p + u)] = w^(u * p) * DFT_r(in[q + s * (p + k * m)])[u], with m = length / r.
+ */
+void ComplexFFT::runPass(const Pass &pass, const FFT_COMPLEX_TYPE *in, FFT_COMPLEX_TYPE *out) {
+    const std::size_t s = pass.stride;
+    const std::size_t m = pass.length / pass.radix;
+    const FFT_COMPLEX_TYPE *w = pass.twiddles.data();
+
+    switch (pass.radix)
+    {
+    case 2:
+        for (std::size_t p = 0; p < m; p++) {
+            const FFT_COMPLEX_TYPE w1 = w[p];
+            for (std::size_t q = 0; q < s; q++) {
+                FFT_COMPLEX_TYPE a0 = in[q + s * p];
+                FFT_COMPLEX_TYPE a1 = in[q + s * (p + m)];
+                out[q + s * (2 * p)] = a0 + a1;
+                out[q + s * (2 * p + 1)] = (a0 - a1) * w1;
+            }
+        }
+        break;
+    case 3: {
+        const float sin60 = static_cast<float>(std::sqrt(3.0) / 2);
+        for (std::size_t p = 0; p < m; p++) {
+            const FFT_COMPLEX_TYPE w1 = w[2 * p], w2 = w[2 * p + 1];
+            for (std::size_t q = 0; q < s; q++) {
+                FFT_COMPLEX_TYPE a0 = in[q + s * p];
+                FFT_COMPLEX_TYPE a1 = in[q + s * (p + m)];
+                FFT_COMPLEX_TYPE a2 = in[q + s * (p + 2 * m)];
+                FFT_COMPLEX_TYPE sum = a1 + a2;
+                FFT_COMPLEX_TYPE centre = a0 - 0.5f * sum;
+                FFT_COMPLEX_TYPE rotated = timesMinusI(sin60 * (a1 - a2));
+                out[q + s * (3 * p)] = a0 + sum;
+                out[q + s * (3 * p + 1)] = (centre + rotated) * w1;
+                out[q + s * (3 * p + 2)] = (centre - rotated) * w2;
+            }
+        }
+        break;
+    }
+    case 4:
+        for (std::size_t p = 0; p < m; p++) {
+            const FFT_COMPLEX_TYPE w1 = w[3 * p], w2 = w[3 * p + 1], w3 = w[3 * p + 2];
+            for (std::size_t q = 0; q < s; q++) {
+                FFT_COMPLEX_TYPE a0 = in[q + s * p];
+                FFT_COMPLEX_TYPE a1 = in[q + s * (p + m)];
+                FFT_COMPLEX_TYPE a2 = in[q + s * (p + 2 * m)];
+                FFT_COMPLEX_TYPE a3 = in[q + s * (p + 3 * m)];
+                FFT_COMPLEX_TYPE t0 = a0 + a2, t1 = a0 - a2;
+                FFT_COMPLEX_TYPE t2 = a1 + a3, t3 = timesMinusI(a1 - a3);
+                out[q + s * (4 * p)] = t0 + t2;
+                out[q + s * (4 * p + 1)] = (t1 + t3) * w1;
+                out[q + s * (4 * p + 2)] = (t0 - t2) * w2;
+                out[q + s * (4 * p + 3)] = (t1 - t3) * w3;
+            }
+        }
+        break;
+    case 5: {
+        const float c1 = static_cast<float>(std::cos(TWO_PI / 5)), c2 = static_cast<float>(std::cos(2 * TWO_PI / 5));
+        const float s1 = static_cast<float>(std::sin(TWO_PI / 5)), s2 = static_cast<float>(std::sin(2 * TWO_PI / 5));
+        for (std::size_t p = 0; p < m; p++) {
+            const FFT_COMPLEX_TYPE *wp = w + 4 * p;
+            for (std::size_t q = 0; q < s; q++) {
+                FFT_COMPLEX_TYPE a0 = in[q + s * p];
+                FFT_COMPLEX_TYPE a1 = in[q + s * (p + m)];
+                FFT_COMPLEX_TYPE a2 = in[q + s * (p + 2 * m)];
+                FFT_COMPLEX_TYPE a3 = in[q + s * (p + 3 * m)];
+                FFT_COMPLEX_TYPE a4 = in[q + s * (p + 4 * m)];
+                FFT_COMPLEX_TYPE t1 = a1 + a4, t2 = a2 + a3, t3 = a1 - a4, t4 = a2 - a3;
+                FFT_COMPLEX_TYPE r1 = a0 + c1 * t1 + c2 * t2;
+                FFT_COMPLEX_TYPE r2 = a0 + c2 * t1 + c1 * t2;
+                FFT_COMPLEX_TYPE i1 = timesMinusI(s1 * t3 + s2 * t4);
+                FFT_COMPLEX_TYPE i2 = timesMinusI(s2 * t3 - s1 * t4);
+                out[q + s * (5 * p)] = a0 + t1 + t2;
+                out[q + s * (5 * p + 1)] = (r1 + i1) * wp[0];
+                out[q + s * (5 * p + 2)] = (r2 + i2) * wp[1];
+                out[q + s * (5 * p + 3)] = (r2 - i2) * wp[2];
+                out[q + s * (5 * p + 4)] = (r1 - i1) * wp[3];
+            }
+        }
+        break;
+    }
+    default:
+        throw FunctionalityNotImplemented("FFT radix " + std::to_string(pass.radix));
+    }
+}
+
+void ComplexFFT::forward(FFT_COMPLEX_TYPE *data, FFT_COMPLEX_TYPE *work) const {
+    FFT_COMPLEX_TYPE *in = data, *out = work;
+    for (const Pass &pass : passes) {
+        runPass(pass, in, out);
+        std::swap(in, out);
+    }
+    if (in != data) std::copy(in, in + length, data);
+}
+
+void ComplexFFT::inverse(FFT_COMPLEX_TYPE *data, FFT_COMPLEX_TYPE *work) const {
+    for (std::size_t i = 0; i < length; i++) data[i] = std::conj(data[i]);
+    forward(data, work);
+    for (std::size_t i = 0; i < length; i++) data[i] = std::conj(data[i]);
+}
+
+RealFFT::RealFFT(std::size_t length) : length(length), halfFFT(length / 2) {
+    if (length % 2 != 0) throw InvalidInputs("Real FFT lengths must be even");
+    twiddles.resize(length / 2 + 1);
+    for (std::size_t k = 0; k <= length / 2; k++) twiddles[k] = twiddle(static_cast<double>(k), static_cast<double>(length));
+}
+
+std::size_t RealFFT::goodLength(std::size_t maxLength) {
+    for (std::size_t length = maxLength - maxLength % 2; length >= 2; length -= 2) {
+        if (ComplexFFT::isSupportedLength(length)) return length;
+    }
+    return 0;
+}
+
+/**
+ * The even samples go in the real and the odd samples in the imaginary parts of a half-length transform Z, whose
+ * Hermitian and anti-Hermitian parts are the spectra E and O of the even and odd samples: X[k] = E[k] + w^k O[k].
+ */
+void RealFFT::forward(const float *in, FFT_COMPLEX_TYPE *out, FFT_COMPLEX_TYPE *work) const {
+    const std::size_t m = length / 2;
+    for (std::size_t k = 0; k < m; k++) out[k] = FFT_COMPLEX_TYPE(in[2 * k], in[2 * k + 1]);
+    halfFFT.forward(out, work);
+
+    for (std::size_t k = 1; k <= m / 2; k++) {
+        FFT_COMPLEX_TYPE a = out[k], b = out[m - k];
+        FFT_COMPLEX_TYPE evenA = 0.5f * (a + std::conj(b)), oddA = timesMinusI(0.5f * (a - std::conj(b)));
+        FFT_COMPLEX_TYPE evenB = 0.5f * (b + std::conj(a)), oddB = timesMinusI(0.5f * (b - std::conj(a)));
+        out[k] = evenA + twiddles[k] * oddA;
+        out[m - k] = evenB + twiddles[m - k] * oddB;
+    }
+    FFT_COMPLEX_TYPE zero = out[0];
+    out[0] = FFT_COMPLEX_TYPE(zero.real() + zero.imag(), 0.0f);
+    out[m] = FFT_COMPLEX_TYPE(zero.real() - zero.imag(), 0.0f);
+}
+
+std::shared_ptr<const ComplexFFT> FFTPlanCache::getComplexPlan(std::size_t length) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    std::shared_ptr<const ComplexFFT> &plan = complexPlans[length];
+    if (!plan) plan = std::make_shared<const ComplexFFT>(length);
+    return plan;
+}
+
+std::shared_ptr<const RealFFT> FFTPlanCache::getRealPlan(std::size_t length) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    std::shared_ptr<const RealFFT> &plan = realPlans[length];
+    if (!plan) plan = std::make_shared<const RealFFT>(length);
+    return plan;
+}
@@ -0,0 +1,261 @@
+#include "operations/folder.hpp"
+#include "data/constants.hpp"
+#include "data/candidate_table.hpp"
+#include "utils/gen_utils.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace OPS;
+
+const char Folder::MAGIC[8] = {'P', 'S', 'R', 'F', 'O', 'L', 'D', '1'};
+
+namespace {
+
+    const double SPEED_OF_LIGHT = 299792458.0; // m/s
+
+    /* sigma of a normal distribution over its median absolute deviation */
+    const float MAD_TO_SIGMA = 1.4826f;
+
+};
+
+CandidateFold::CandidateFold(const FoldCandidate &candidate, const FoldingOptions &options, const std::vector<double> &channelFrequencies,
+                             std::size_t totalNSamples, double tsamp)
+    : candidate(candidate), options(options), totalNSamples(totalNSamples), tsamp(tsamp) {
+    if (candidate.period <= 0) throw InvalidInputs("Candidate periods must be positive");
+    if (options.nBins == 0 || options.nSubints == 0 || options.nSubbands == 0) {
+        throw InvalidInputs("The numbers of bins, sub-integrations and subbands must be positive");
+    }
+    if (channelFrequencies.size() % options.nSubbands != 0) {
+        throw InvalidInputs("The number of subbands must divide the number of channels");
+    }
+
+    double fMax = *std::max_element(channelFrequencies.begin(), channelFrequencies.end());
+    channelDelays.resize(channelFrequencies.size());
+    for (std::size_t c = 0; c < channelFrequencies.size(); c++) {
+        double f = channelFrequencies[c];
+        double delay = DISPERSION_CONSTANT * candidate.dm * (1.0 / (f * f) - 1.0 / (fMax * fMax));
+        channelDelays[c] = static_cast<std::size_t>(std::lround(std::max(delay, 0.0) / tsamp));
+    }
+    maxDelay = *std::max_element(channelDelays.begin(), channelDelays.end());
+
+    std::size_t nCells = static_cast<std::size_t>(options.nSubints) * options.nSubbands * options.nBins;
+    sums.assign(nCells, 0.0);
+    counts.assign(nCells, 0);
+}
+
+void CandidateFold::fold(std::size_t startSample, std::size_t nSamples, const uint8_t *data, unsigned int nBits) {
+    switch (nBits)
+    {
+    case 8:
+        foldOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(startSample, nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_8_BIT_TYPE *>(data));
+        break;
+    case 16:
+        foldOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(startSample, nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(data));
+        break;
+    case 32:
+        foldOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(startSample, nSamples, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(data));
+        break;
+    default:
+        throw InvalidInputs("Folding supports 8, 16 and 32 bit input only");
+    }
+}
+
+/**
+ * Emission sample j = startSample + i - delay(c) of data sample i of channel c is entry i + maxDelay - delay(c) of
+ * cellOf, which covers the maxDelay emission samples before the gulp as well.
+ */
+template <typename DTYPE>
+void CandidateFold::foldOfType(std::size_t startSample, std::size_t nSamples, const DTYPE *data) {
+    const std::size_t nChans = channelDelays.size();
+    const std::size_t nBins = options.nBins, nSubbands = options.nSubbands, nSubints = options.nSubints;
+    const std::size_t chansPerSubband = nChans / nSubbands;
+    const std::size_t nEmission = nSamples + maxDelay;
+
+    const double referenceTime = 0.5 * totalNSamples * tsamp;
+    const double chirp = candidate.acceleration / (2.0 * SPEED_OF_LIGHT);
+    cellOf.resize(nEmission);
+    for (std::size_t k = 0; k < nEmission; k++) {
+        int64_t j = static_cast<int64_t>(startSample + k) - static_cast<int64_t>(maxDelay);
+        double t = j * tsamp;
+        double phase = (t - chirp * ((t - referenceTime) * (t - referenceTime) - referenceTime * referenceTime)) / candidate.period;
+        std::size_t bin = std::min(static_cast<std::size_t>((phase - std::floor(phase)) * nBins), nBins - 1);
+        int64_t subint = j < 0 ? 0 : std::min<int64_t>(j * static_cast<int64_t>(nSubints) / static_cast<int64_t>(totalNSamples), nSubints - 1);
+        cellOf[k] = static_cast<std::size_t>(subint) * nSubbands * nBins + bin;
+    }
+
+    std::vector<std::size_t> shifts(nChans), offsets(nChans);
+    for (std::size_t c = 0; c < nChans; c++) {
+        shifts[c] = maxDelay - channelDelays[c];
+        offsets[c] = (c / chansPerSubband) * nBins;
+    }
+
+    double *cube = sums.data();
+    const std::size_t *cells = cellOf.data();
+    for (std::size_t i = 0; i < nSamples; i++) {
+        const DTYPE *row = data + i * nChans;
+        for (std::size_t c = 0; c < nChans; c++) {
+            cube[cells[i + shifts[c]] + offsets[c]] += row[c];
+        }
+    }
+
+    /* Every channel of a subband covers emission samples shifts[c] .. shifts[c] + nSamples - 1. */
+    coverage.resize(nEmission + 1);
+    for (std::size_t s = 0; s < nSubbands; s++) {
+        std::fill(coverage.begin(), coverage.end(), 0);
+        for (std::size_t c = s * chansPerSubband; c < (s + 1) * chansPerSubband; c++) {
+            coverage[shifts[c]]++;
+            coverage[shifts[c] + nSamples]--;
+        }
+        int64_t covering = 0;
+        for (std::size_t k = 0; k < nEmission; k++) {
+            covering += coverage[k];
+            counts[cells[k] + s * nBins] += covering;
+        }
+    }
+}
+
+std::vector<float> CandidateFold::getCube() const {
+    std::vector<float> cube(sums.size(), 0.0f);
+    for (std::size_t i = 0; i < sums.size(); i++) {
+        if (counts[i] > 0) cube[i] = static_cast<float>(sums[i] / counts[i]);
+    }
+    return cube;
+}
+
+std::vector<float> CandidateFold::getProfile() const {
+    std::size_t nBins = options.nBins;
+    std::vector<double> profileSums(nBins, 0.0);
+    std::vector<uint64_t> profileCounts(nBins, 0);
+    for (std::size_t i = 0; i < sums.size(); i++) {
+        profileSums[i % nBins] += sums[i];
+        profileCounts[i % nBins] += counts[i];
+    }
+    std::vector<float> profile(nBins, 0.0f);
+    for (std::size_t b = 0; b < nBins; b++) {
+        if (profileCounts[b] > 0) profile[b] = static_cast<float>(profileSums[b] / profileCounts[b]);
+    }
+    return profile;
+}
+
+float CandidateFold::getProfileSNR() const {
+    std::vector<float> profile = getProfile();
+    std::size_t nBins = profile.size();
+
+    std::vector<float> sorted(profile);
+    std::nth_element(sorted.begin(), sorted.begin() + nBins / 2, sorted.end());
+    float median = sorted[nBins / 2];
+    for (float &value : sorted) value = std::fabs(value - median);
+    std::nth_element(sorted.begin(), sorted.begin() + nBins / 2, sorted.end());
+    float sigma = MAD_TO_SIGMA * sorted[nBins / 2];
+    if (sigma <= 0.0f) return 0.0f;
+
+    /* Boxcars of every width up to half the profile, at every start, wrapping around. */
+    float best = 0.0f;
+    for (std::size_t start = 0; start < nBins; start++) {
+        double sum = 0.0;
+        for (std::size_t width = 1; width <= std::max<std::size_t>(1, nBins / 2); width++) {
+            sum += profile[(start + width - 1) % nBins] - median;
+            best = std::max(best, static_cast<float>(sum / (sigma * std::sqrt(static_cast<double>(width)))));
+        }
+    }
+    return best;
+}
+
+Folder::Folder(const std::vector<FoldCandidate> &candidates, const FoldingOptions &options, unsigned int nChans, double fch1,
+               double foff, std::size_t totalNSamples, double tsamp)
+    : options(options), totalNSamples(totalNSamples), tsamp(tsamp), fch1(fch1) {
+    if (totalNSamples == 0) throw InvalidInputs("There are no samples to fold");
+    if (tsamp <= 0) throw InvalidInputs("The sampling time must be positive");
+    if (options.nSubbands == 0 || nChans % options.nSubbands != 0) {
+        throw InvalidInputs("The number of subbands must divide the number of channels");
+    }
+    this->subbandBW = foff * nChans / options.nSubbands;
+
+    std::vector<double> channelFrequencies(nChans);
+    for (unsigned int c = 0; c < nChans; c++) channelFrequencies[c] = fch1 + c * foff;
+    for (const FoldCandidate &candidate : candidates) {
+        folds.push_back(std::make_unique<CandidateFold>(candidate, options, channelFrequencies, totalNSamples, tsamp));
+    }
+    this->threadPool = std::make_unique<UTILS::ThreadPool>(options.nThreads);
+}
+
+void Folder::fold(std::size_t startSample, std::size_t nSamples, const uint8_t *data, unsigned int nBits) {
+    threadPool->parallelFor(0, folds.size(), [&](std::size_t start, std::size_t end) {
+        for (std::size_t i = start; i < end; i++) folds[i]->fold(startSample, nSamples, data, nBits);
+    });
+}
+
+void Folder::write(const std::string &fileName) const {
+    FILE *file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr) throw FileIOError(0, 0, "open " + fileName);
+
+    FoldFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.nCandidates = folds.size();
+    header.nSubints = options.nSubints;
+    header.nSubbands = options.nSubbands;
+    header.nBins = options.nBins;
+    header.nSamples = totalNSamples;
+    header.tsamp = tsamp;
+    header.fch1 = fch1;
+    header.subbandBW = subbandBW;
+
+    try {
+        writeToFileAndVerify<FoldFileHeader>(file, 1, &header);
+        for (const std::unique_ptr<CandidateFold> &fold : folds) {
+            FoldedCandidateHeader candidateHeader;
+            std::memset(&candidateHeader, 0, sizeof(candidateHeader));
+            candidateHeader.period = fold->getCandidate().period;
+            candidateHeader.dm = fold->getCandidate().dm;
+            candidateHeader.acceleration = fold->getCandidate().acceleration;
+            candidateHeader.snr = fold->getProfileSNR();
+            std::vector<float> cube = fold->getCube();
+            writeToFileAndVerify<FoldedCandidateHeader>(file, 1, &candidateHeader);
+            writeToFileAndVerify<float>(file, cube.size(), cube.data());
+        }
+    }
+    catch (...) {
+        fclose(file);
+        throw;
+    }
+    if (fclose(file) != 0) throw FileIOError(0, 0, "close " + fileName);
+}
+
+std::vector<FoldCandidate> Folder::readCandidates(const std::string &fileName) {
+    std::vector<FoldCandidate> candidates;
+
+    /* Read in one pass, so that pipes and process substitutions work too. */
+    std::ifstream input(fileName, std::ios::binary);
+    if (!input.is_open()) throw FileIOError(0, 0, "open " + fileName);
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (input.bad()) throw FileIOError(0, contents.size(), "read " + fileName);
+
+    if (contents.compare(0, sizeof(IO::CandidateTable::MAGIC), IO::CandidateTable::MAGIC, sizeof(IO::CandidateTable::MAGIC)) == 0) {
+        std::vector<IO::PeriodicityRecord> records;
+        IO::CandidateTable::parse(contents, fileName, records);
+        for (const IO::PeriodicityRecord &record : records) {
+            candidates.push_back(FoldCandidate{1.0 / record.frequency, record.dm, record.acceleration});
+        }
+        return candidates;
+    }
+
+    std::istringstream file(contents);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream columns(line);
+        double periodMs;
+        float dm, acceleration = 0.0f;
+        if (!(columns >> periodMs >> dm)) throw FileFormatNotRecognised(fileName);
+        columns >> acceleration;
+        candidates.push_back(FoldCandidate{periodMs / 1000.0, dm, acceleration});
+    }
+    return candidates;
+}
@@ -0,0 +1,280 @@
+#include "operations/fourier_domain_search.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <cmath>
+
+using namespace OPS;
+
+namespace {
+
+    const double SPEED_OF_LIGHT = 299792458.0; // m/s
+
+    std::size_t nextPowerOfTwo(std::size_t value) {
+        std::size_t power = 1;
+        while (power < value) power *= 2;
+        return power;
+    }
+
+};
+
+FourierTemplateBank::FourierTemplateBank(float zMax, float zStep, float wMax, float wStep, FFTPlanCache &planCache,
+                                         UTILS::ThreadPool &threadPool)
+    : zStep(zStep), wStep(wStep) {
+    if (zMax < 0 || wMax < 0) throw InvalidInputs("The largest z and w cannot be negative");
+    if (zStep <= 0 || wStep <= 0) throw InvalidInputs("The z and w steps must be positive");
+
+    std::size_t zHalf = static_cast<std::size_t>(zMax / zStep);
+    std::size_t wHalf = static_cast<std::size_t>(wMax / wStep);
+    nZ = 2 * zHalf + 1;
+    nW = 2 * wHalf + 1;
+
+    templates.resize(nZ * nW);
+    std::size_t largestHalfWidth = 0;
+    for (std::size_t wi = 0; wi < nW; wi++) {
+        for (std::size_t zi = 0; zi < nZ; zi++) {
+            Template &response = templates[zi + nZ * wi];
+            response.z = (static_cast<long>(zi) - static_cast<long>(zHalf)) * zStep;
+            response.w = (static_cast<long>(wi) - static_cast<long>(wHalf)) * wStep;
+            response.halfWidth = static_cast<std::size_t>(std::ceil(std::fabs(response.z) / 2 + std::fabs(response.w) / 3)) + HALF_WIDTH_MARGIN;
+            largestHalfWidth = std::max(largestHalfWidth, response.halfWidth);
+        }
+    }
+
+    /* Blocks at least four times the widest template keep the overlap, which is recomputed, below a quarter. */
+    blockLength = std::max(MIN_BLOCK_LENGTH, nextPowerOfTwo(4 * (2 * largestHalfWidth + 1)));
+    blockFFT = planCache.getComplexPlan(blockLength);
+
+    threadPool.parallelFor(0, templates.size(), [&](std::size_t start, std::size_t end) {
+        for (std::size_t i = start; i < end; i++) makeTemplate(templates[i], planCache);
+    });
+}
+
+/**
+ * The chirp is sampled at the midpoints u_m = (m + 1/2) / M, so R(k + offset) = D[k mod M] exp(-pi i k / M) / M with D
+ * the DFT of exp(2 pi i (psi(u_m) - offset u_m)). M is a power of two well above the template width, so that the
+ * sidelobes aliased from the far side of the DFT are negligible.
+ */
+void FourierTemplateBank::makeTemplate(Template &response, FFTPlanCache &planCache) {
+    const std::size_t halfWidth = response.halfWidth;
+    const std::size_t width = 2 * halfWidth + 1;
+    const std::size_t nChirp = std::max<std::size_t>(1024, nextPowerOfTwo(16 * width));
+    std::shared_ptr<const ComplexFFT> chirpFFT = planCache.getComplexPlan(nChirp);
+    std::vector<FFT_COMPLEX_TYPE> chirp(nChirp), work(std::max(nChirp, blockLength));
+    const double z = response.z, w = response.w;
+
+    /* The second kernel is R(k - 1/2): correlated at bin b it matches a signal at b + 1/2, the half-bin above. */
+    for (unsigned int half = 0; half < 2; half++) {
+        double offset = -0.5 * half;
+        for (std::size_t m = 0; m < nChirp; m++) {
+            double u = (m + 0.5) / nChirp;
+            double cycles = z * u * u / 2 + w * u * u * u / 6 - (z / 2 + w / 6) * u - offset * u;
+            double phase = 2.0 * M_PI * (cycles - std::floor(cycles));
+            chirp[m] = FFT_COMPLEX_TYPE(static_cast<float>(std::cos(phase)), static_cast<float>(std::sin(phase)));
+        }
+        chirpFFT->forward(chirp.data(), work.data());
+
+        std::vector<std::complex<double>> values(width);
+        double energy = 0.0;
+        for (std::size_t j = 0; j < width; j++) {
+            long k = static_cast<long>(j) - static_cast<long>(halfWidth);
+            std::size_t index = static_cast<std::size_t>((k % static_cast<long>(nChirp) + static_cast<long>(nChirp)) % static_cast<long>(nChirp));
+            values[j] = std::complex<double>(chirp[index]) * std::polar(1.0 / nChirp, -M_PI * k / nChirp);
+            energy += std::norm(values[j]);
+        }
+
+        /* kernel(j) = conj(R(halfWidth - j)), so that the convolution of a block puts the correlation at bin
+           blockStart + j - halfWidth into output j; the 1 / blockLength of the inverse transform is folded in. */
+        std::vector<FFT_COMPLEX_TYPE> &kernel = response.kernels[half];
+        kernel.assign(blockLength, FFT_COMPLEX_TYPE(0.0f, 0.0f));
+        double scale = 1.0 / (std::sqrt(energy) * blockLength);
+        for (std::size_t j = 0; j < width; j++) {
+            kernel[j] = FFT_COMPLEX_TYPE(std::conj(values[width - 1 - j]) * scale);
+        }
+        blockFFT->forward(kernel.data(), work.data());
+    }
+}
+
+std::size_t FourierTemplateBank::findTemplate(float z, float w) const {
+    long zHalf = static_cast<long>(nZ / 2), wHalf = static_cast<long>(nW / 2);
+    long zi = std::min(std::max(std::lround(z / zStep), -zHalf), zHalf) + zHalf;
+    long wi = std::min(std::max(std::lround(w / wStep), -wHalf), wHalf) + wHalf;
+    return static_cast<std::size_t>(zi) + nZ * static_cast<std::size_t>(wi);
+}
+
+std::size_t FourierTemplateBank::getBytes() const {
+    std::size_t bytes = 0;
+    for (const Template &response : templates) {
+        bytes += (response.kernels[0].size() + response.kernels[1].size()) * sizeof(FFT_COMPLEX_TYPE);
+    }
+    return bytes;
+}
+
+FourierDomainSearch::FourierDomainSearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                                         const PeriodicitySearchOptions &options, float zMax, float wMax)
+    : PeriodicitySearch(dmList, totalNSamples, tsamp, options) {
+    this->templateBank = std::make_unique<FourierTemplateBank>(zMax, Z_STEP, wMax, W_STEP, *planCache, *threadPool);
+    this->spectra.resize(dmList.size());
+}
+
+void FourierDomainSearch::makeSpectrum(const float *timeSeries, std::size_t nSamples, std::vector<FFT_COMPLEX_TYPE> &spectrum) {
+    std::size_t fftLength = RealFFT::goodLength(nSamples);
+    spectrum.clear();
+    if (fftLength < 2) return;
+    std::shared_ptr<const RealFFT> plan = planCache->getRealPlan(fftLength);
+
+    std::vector<float> samples(timeSeries, timeSeries + fftLength);
+    float mean = static_cast<float>(std::accumulate(samples.begin(), samples.end(), 0.0) / fftLength);
+    for (float &sample : samples) sample -= mean;
+
+    std::vector<FFT_COMPLEX_TYPE> work(plan->getWorkLength());
+    spectrum.resize(fftLength / 2 + 1);
+    plan->forward(samples.data(), spectrum.data(), work.data());
+    if (spectrumCleaner) spectrumCleaner->clean(spectrum.data(), spectrum.size(), fftLength * tsamp);
+
+    std::size_t firstHalfBin, lastHalfBin;
+    if (!getSearchRange(2 * spectrum.size() - 1, fftLength * tsamp, firstHalfBin, lastHalfBin)) return;
+    std::vector<float> powers;
+    for (std::size_t k = firstHalfBin / 2; k <= lastHalfBin / 2; k++) powers.push_back(std::norm(spectrum[k]));
+    std::size_t middle = powers.size() / 2;
+    std::nth_element(powers.begin(), powers.begin() + middle, powers.end());
+    if (powers[middle] <= 0.0f) return;
+
+    float scale = static_cast<float>(std::sqrt(std::log(2.0) / powers[middle]));
+    for (FFT_COMPLEX_TYPE &bin : spectrum) bin *= scale;
+}
+
+/**
+ * Overlap-save: a block of blockLength bins starting halfWidth before the first output is transformed once, multiplied
+ * by both kernels and transformed back, and its last blockLength - 2 * halfWidth outputs are valid correlations.
+ */
+void FourierDomainSearch::correlate(const std::vector<FFT_COMPLEX_TYPE> &spectrum, const FourierTemplateBank::Template &response,
+                                    std::size_t binStart, std::size_t binEnd, float *powers) const {
+    const ComplexFFT &blockFFT = templateBank->getBlockFFT();
+    const std::size_t blockLength = templateBank->getBlockLength();
+    const std::size_t halfWidth = response.halfWidth;
+    const std::size_t step = blockLength - 2 * halfWidth;
+    const long nBins = static_cast<long>(spectrum.size());
+
+    std::vector<FFT_COMPLEX_TYPE> block(blockLength), product(blockLength), work(blockLength);
+    for (std::size_t outStart = binStart; outStart < binEnd; outStart += step) {
+        long first = static_cast<long>(outStart) - static_cast<long>(halfWidth);
+        for (std::size_t n = 0; n < blockLength; n++) {
+            long bin = first + static_cast<long>(n);
+            block[n] = bin >= 0 && bin < nBins ? spectrum[bin] : FFT_COMPLEX_TYPE(0.0f, 0.0f);
+        }
+        blockFFT.forward(block.data(), work.data());
+
+        std::size_t nOut = std::min(step, binEnd - outStart);
+        for (unsigned int half = 0; half < 2; half++) {
+            const FFT_COMPLEX_TYPE *__restrict__ kernel = response.kernels[half].data();
+            for (std::size_t n = 0; n < blockLength; n++) product[n] = block[n] * kernel[n];
+            blockFFT.inverse(product.data(), work.data());
+            for (std::size_t n = 0; n < nOut; n++) {
+                powers[2 * (outStart - binStart + n) + half] = std::norm(product[2 * halfWidth + n]);
+            }
+        }
+    }
+}
+
+/**
+ * Stage s sums, for every half-bin R of the highest harmonic, the slices of harmonics j / s at R j / s, j = 1 .. s.
+ * These are the slices h / nHarmonics with h = j nHarmonics / s, so the nHarmonics slices of a chunk serve every stage.
+ */
+void FourierDomainSearch::searchSpectrum(const std::vector<FFT_COMPLEX_TYPE> &spectrum, float dm, std::size_t trial,
+                                         std::vector<PeriodicityCandidate> &found) {
+    if (spectrum.size() < 2) return;
+    const std::size_t nBins = spectrum.size();
+    const double observationLength = 2 * (nBins - 1) * tsamp;
+    std::size_t firstHalfBin, lastHalfBin;
+    if (!getSearchRange(2 * nBins - 1, observationLength, firstHalfBin, lastHalfBin)) return;
+
+    const FourierTemplateBank::Template &top = templateBank->getTemplate(trial);
+    const unsigned int nHarmonics = options.nHarmonics;
+    std::vector<std::vector<float>> slices(nHarmonics + 1);
+    std::vector<std::size_t> sliceStarts(nHarmonics + 1);
+    std::vector<float> sums;
+    std::vector<PeriodicityCandidate> trialCandidates;
+
+    for (std::size_t chunkStart = firstHalfBin; chunkStart <= lastHalfBin; chunkStart += CHUNK_HALF_BINS) {
+        std::size_t chunkEnd = std::min(lastHalfBin + 1, chunkStart + CHUNK_HALF_BINS);
+
+        for (unsigned int h = 1; h <= nHarmonics; h++) {
+            std::size_t binStart = chunkStart * h / nHarmonics / 2;
+            std::size_t binEnd = std::min(nBins, ((chunkEnd - 1) * h + nHarmonics / 2) / nHarmonics / 2 + 1);
+            float fraction = static_cast<float>(h) / nHarmonics;
+            const FourierTemplateBank::Template &response = templateBank->getTemplate(templateBank->findTemplate(top.z * fraction, top.w * fraction));
+            slices[h].resize(2 * (binEnd - binStart));
+            sliceStarts[h] = 2 * binStart;
+            correlate(spectrum, response, binStart, binEnd, slices[h].data());
+        }
+
+        unsigned int stageIndex = 0;
+        for (unsigned int stage = 1; stage <= nHarmonics; stage *= 2, stageIndex++) {
+            std::size_t first = std::max(chunkStart, stage * firstHalfBin);
+            if (first >= chunkEnd) continue;
+            sums.assign(chunkEnd - first, 0.0f);
+            for (unsigned int j = 1; j <= stage; j++) {
+                unsigned int h = j * (nHarmonics / stage);
+                const float *slice = slices[h].data() - sliceStarts[h];
+                for (std::size_t R = first; R < chunkEnd; R++) sums[R - first] += slice[(R * j + stage / 2) / stage];
+            }
+
+            float threshold = powerThresholds[stageIndex];
+            for (std::size_t i = 0; i < sums.size(); i++) {
+                if (sums[i] < threshold) continue;
+                if ((i > 0 && sums[i] < sums[i - 1]) || (i + 1 < sums.size() && sums[i] <= sums[i + 1])) continue;
+                double R = static_cast<double>(first + i);
+                PeriodicityCandidate candidate;
+                candidate.dm = dm;
+                /* a = -c fdot / f, with fdot = z / T^2 at frequency R / 2T */
+                candidate.acceleration = static_cast<float>(-2.0 * top.z * SPEED_OF_LIGHT / (R * observationLength));
+                candidate.jerk = static_cast<float>(-2.0 * top.w * SPEED_OF_LIGHT / (R * observationLength * observationLength));
+                candidate.frequency = 0.5 * R / stage / observationLength;
+                candidate.nHarmonics = stage;
+                candidate.power = sums[i];
+                candidate.sigma = powerToSigma(sums[i], stage);
+                trialCandidates.push_back(candidate);
+            }
+        }
+    }
+
+    keepStrongest(trialCandidates, observationLength, found);
+}
+
+void FourierDomainSearch::searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t trial,
+                                      std::vector<PeriodicityCandidate> &found) {
+    std::vector<FFT_COMPLEX_TYPE> spectrum;
+    makeSpectrum(timeSeries, nSamples, spectrum);
+    searchSpectrum(spectrum, dm, trial, found);
+}
+
+/**
+ * Each spectrum replaces its time series, which takes as much memory, so the search needs no more than the collection.
+ */
+void FourierDomainSearch::finish() {
+    threadPool->parallelFor(0, series.size(), [this](std::size_t dmStart, std::size_t dmEnd) {
+        for (std::size_t i = dmStart; i < dmEnd; i++) {
+            makeSpectrum(series[i].data(), series[i].size(), spectra[i]);
+            std::vector<float>().swap(series[i]);
+        }
+    });
+
+    std::size_t nTrials = getNTrials();
+    std::vector<std::atomic<std::size_t>> trialsLeft(spectra.size());
+    for (std::atomic<std::size_t> &left : trialsLeft) left = nTrials;
+
+    threadPool->parallelFor(0, spectra.size() * nTrials, [&](std::size_t pairStart, std::size_t pairEnd) {
+        std::vector<PeriodicityCandidate> found;
+        for (std::size_t pair = pairStart; pair < pairEnd; pair++) {
+            std::size_t i = pair / nTrials;
+            searchSpectrum(spectra[i], dmList[i], pair % nTrials, found);
+            if (--trialsLeft[i] == 0) std::vector<FFT_COMPLEX_TYPE>().swap(spectra[i]);
+        }
+        std::unique_lock<std::mutex> lock(candidatesMutex);
+        candidates.insert(candidates.end(), found.begin(), found.end());
+    });
+
+    sortCandidates();
+}
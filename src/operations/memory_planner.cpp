@@ -0,0 +1,89 @@
+#include "operations/memory_planner.hpp"
+#include "data/constants.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace OPS;
+
+namespace {
+
+    /* Gulps are rounded down to a multiple of this many samples, which keeps sub-byte gulps whole bytes. */
+    const std::size_t GULP_ALIGNMENT = 8;
+
+    std::string toGB(std::size_t bytes) {
+        std::ostringstream gb;
+        gb << std::fixed << std::setprecision(2) << bytes / 1e9 << " GB";
+        return gb.str();
+    }
+
+};
+
+MemoryPlanner::MemoryPlanner(unsigned int nChans, unsigned int nBits, std::size_t nDMs, std::size_t maxDelaySamples, std::size_t nSamples)
+    : nDMs(nDMs), maxDelaySamples(maxDelaySamples), nSamples(nSamples) {
+    if (nChans == 0 || nDMs == 0 || nSamples == 0) throw InvalidInputs("There is nothing to dedisperse");
+    this->bytesPerInputSample = static_cast<std::size_t>(nChans) * std::max(nBits, static_cast<unsigned int>(BITS_PER_BYTE)) / BITS_PER_BYTE;
+}
+
+std::size_t MemoryPlanner::getBytes(std::size_t gulpNSamples, unsigned int readAhead, std::size_t maxBufferedGulps) const {
+    bool gulping = gulpNSamples < nSamples;
+    std::size_t inputBuffers = gulping ? std::max(readAhead, 1u) : 1;
+    std::size_t nGulps = (nSamples + gulpNSamples - 1) / gulpNSamples;
+    std::size_t outputBuffers = std::min(maxBufferedGulps + 1, nGulps);
+    return fixedBytes + inputBuffers * gulpNSamples * bytesPerInputSample
+         + (gulpNSamples + maxDelaySamples) * (bytesPerInputSample + backendBytesPerSample)
+         + outputBuffers * nDMs * gulpNSamples * sizeof(DEDISP_OUTPUT_TYPE);
+}
+
+std::size_t MemoryPlanner::getMaxGulp(std::size_t budget, unsigned int readAhead, std::size_t maxBufferedGulps) const {
+    std::size_t constantBytes = fixedBytes + maxDelaySamples * (bytesPerInputSample + backendBytesPerSample);
+    std::size_t bytesPerSample = (std::max(readAhead, 1u) + 1) * bytesPerInputSample + backendBytesPerSample
+                               + (maxBufferedGulps + 1) * nDMs * sizeof(DEDISP_OUTPUT_TYPE);
+    if (budget <= constantBytes) return 0;
+    std::size_t gulpNSamples = (budget - constantBytes) / bytesPerSample;
+    return std::min(gulpNSamples / GULP_ALIGNMENT * GULP_ALIGNMENT, nSamples);
+}
+
+MemoryPlan MemoryPlanner::plan(std::size_t ramLimitBytes, unsigned int readAhead, std::size_t maxBufferedGulps) const {
+    std::size_t budget = static_cast<std::size_t>((1.0 - HEADROOM) * ramLimitBytes);
+    maxBufferedGulps = std::max<std::size_t>(maxBufferedGulps, 1);
+    if (getBytes(nSamples, readAhead, maxBufferedGulps) <= budget) {
+        return MemoryPlan{nSamples, false, 0, maxBufferedGulps, getBytes(nSamples, readAhead, maxBufferedGulps)};
+    }
+
+    std::size_t minGulp = std::max(MIN_GULP_DELAYS * maxDelaySamples, GULP_ALIGNMENT);
+    std::size_t preferredGulp = std::min(std::max(PREFERRED_GULP_DELAYS * maxDelaySamples, GULP_ALIGNMENT), nSamples);
+    std::size_t gulpNSamples = getMaxGulp(budget, readAhead, maxBufferedGulps);
+    while (gulpNSamples < preferredGulp && (maxBufferedGulps > 1 || readAhead > 0)) {
+        if (maxBufferedGulps > 1) maxBufferedGulps--;
+        else readAhead--;
+        gulpNSamples = getMaxGulp(budget, readAhead, maxBufferedGulps);
+    }
+    if (gulpNSamples < minGulp) {
+        throw InvalidInputs("A RAM limit of " + toGB(ramLimitBytes) + " cannot hold gulps of " + std::to_string(minGulp) +
+                            " samples, which need " + toGB(static_cast<std::size_t>(getBytes(minGulp, 0, 1) / (1.0 - HEADROOM))));
+    }
+    return MemoryPlan{gulpNSamples, gulpNSamples < nSamples, readAhead, maxBufferedGulps,
+                      getBytes(gulpNSamples, readAhead, maxBufferedGulps)};
+}
+
+MemoryPlan MemoryPlanner::plan(std::size_t ramLimitBytes, std::size_t gulpNSamples, unsigned int readAhead,
+                               std::size_t maxBufferedGulps) const {
+    std::size_t budget = static_cast<std::size_t>((1.0 - HEADROOM) * ramLimitBytes);
+    gulpNSamples = std::min(gulpNSamples, nSamples);
+    maxBufferedGulps = std::max<std::size_t>(maxBufferedGulps, 1);
+    bool gulping = gulpNSamples < nSamples;
+    if (!gulping) readAhead = 0;
+
+    while (getBytes(gulpNSamples, readAhead, maxBufferedGulps) > budget && (maxBufferedGulps > 1 || readAhead > 0)) {
+        if (maxBufferedGulps > 1) maxBufferedGulps--;
+        else readAhead--;
+    }
+    std::size_t bytes = getBytes(gulpNSamples, readAhead, maxBufferedGulps);
+    if (bytes > budget) {
+        throw InvalidInputs("Gulps of " + std::to_string(gulpNSamples) + " samples need " + toGB(static_cast<std::size_t>(bytes / (1.0 - HEADROOM))) +
+                            ", more than the RAM limit of " + toGB(ramLimitBytes));
+    }
+    return MemoryPlan{gulpNSamples, gulping, readAhead, maxBufferedGulps, bytes};
+}
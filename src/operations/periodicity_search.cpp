@@ -0,0 +1,262 @@
+#include "operations/periodicity_search.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <atomic>
+
+using namespace OPS;
+
+namespace {
+
+    /* log of the probability that a standard normal variable exceeds x */
+    double logNormalSurvival(double x) {
+        if (x < 30.0) return std::log(0.5 * std::erfc(x / std::sqrt(2.0)));
+        return -0.5 * x * x - std::log(x) - 0.5 * std::log(2.0 * M_PI);
+    }
+
+    /* log of the probability that a gamma variable of integer shape n and unit scale exceeds x:
+       Q(n, x) = exp(-x) * sum_{k < n} x^k / k! */
+    double logGammaSurvival(double x, unsigned int n) {
+        if (x <= 0.0) return 0.0;
+        double logX = std::log(x);
+        double largest = -INFINITY;
+        std::vector<double> terms(n);
+        for (unsigned int k = 0; k < n; k++) {
+            terms[k] = k * logX - std::lgamma(k + 1.0);
+            largest = std::max(largest, terms[k]);
+        }
+        double sum = 0.0;
+        for (double term : terms) sum += std::exp(term - largest);
+        return -x + largest + std::log(sum);
+    }
+
+    /* The x at which the standard normal tail probability is exp(logP), by bisection. */
+    double logProbabilityToSigma(double logP) {
+        if (logP >= std::log(0.5)) return 0.0;
+        double low = 0.0, high = 1.0;
+        while (logNormalSurvival(high) > logP) high *= 2.0;
+        for (int i = 0; i < 100; i++) {
+            double middle = 0.5 * (low + high);
+            if (logNormalSurvival(middle) > logP) low = middle;
+            else high = middle;
+        }
+        return 0.5 * (low + high);
+    }
+
+};
+
+PeriodicitySearch::PeriodicitySearch(const std::vector<float> &dmList, std::size_t totalNSamples, double tsamp,
+                                     const PeriodicitySearchOptions &options)
+    : options(options), tsamp(tsamp), dmList(dmList), totalNSamples(totalNSamples) {
+    unsigned int nHarmonics = options.nHarmonics;
+    if (nHarmonics == 0 || nHarmonics > MAX_HARMONICS || (nHarmonics & (nHarmonics - 1)) != 0) {
+        throw InvalidInputs("The number of harmonics must be 1, 2, 4, 8, 16 or 32");
+    }
+    if (tsamp <= 0) throw InvalidInputs("The sampling time must be positive");
+    if (options.minFrequency < 0 || options.maxFrequency < 0) throw InvalidInputs("Search frequencies cannot be negative");
+
+    this->series.resize(dmList.size());
+    this->planCache = std::make_shared<FFTPlanCache>();
+    this->threadPool = std::make_unique<UTILS::ThreadPool>(options.nThreads);
+
+    /* The summed power at which each stage reaches the threshold, found by bisection as the significance grows with it. */
+    for (unsigned int stage = 1; stage <= nHarmonics; stage *= 2) {
+        double low = 0.0, high = stage + 10.0;
+        while (powerToSigma(high, stage) < options.sigmaThreshold) high *= 2.0;
+        for (int i = 0; i < 60; i++) {
+            double middle = 0.5 * (low + high);
+            if (powerToSigma(middle, stage) < options.sigmaThreshold) low = middle;
+            else high = middle;
+        }
+        powerThresholds.push_back(static_cast<float>(high));
+    }
+}
+
+float PeriodicitySearch::powerToSigma(double power, unsigned int nHarmonics) {
+    return static_cast<float>(logProbabilityToSigma(logGammaSurvival(power, nHarmonics)));
+}
+
+void PeriodicitySearch::consume(const IO::DedispersedBlock &block) {
+    for (std::size_t i = 0; i < block.nDMs; i++) {
+        std::vector<float> &dmSeries = series[block.dmStart + i];
+        if (dmSeries.capacity() == 0) dmSeries.reserve(totalNSamples);
+        const DEDISP_OUTPUT_TYPE *samples = block.getSeries(i);
+        if (barycentre) barycentre->append(samples, block.startSample, block.nSamples, dmSeries);
+        else dmSeries.insert(dmSeries.end(), samples, samples + block.nSamples);
+    }
+}
+
+/**
+ * DM and trial pairs are numbered DM after DM, so every thread takes a contiguous run of trials of few DMs, and the
+ * last thread to finish a DM releases its time series.
+ */
+void PeriodicitySearch::finish() {
+    std::size_t nTrials = getNTrials();
+    std::vector<std::atomic<std::size_t>> trialsLeft(series.size());
+    for (std::atomic<std::size_t> &left : trialsLeft) left = nTrials;
+
+    threadPool->parallelFor(0, series.size() * nTrials, [&](std::size_t pairStart, std::size_t pairEnd) {
+        std::vector<PeriodicityCandidate> found;
+        for (std::size_t pair = pairStart; pair < pairEnd; pair++) {
+            std::size_t i = pair / nTrials;
+            searchTrial(series[i].data(), series[i].size(), dmList[i], pair % nTrials, found);
+            if (--trialsLeft[i] == 0) std::vector<float>().swap(series[i]);
+        }
+        std::unique_lock<std::mutex> lock(candidatesMutex);
+        candidates.insert(candidates.end(), found.begin(), found.end());
+    });
+
+    sortCandidates();
+}
+
+void PeriodicitySearch::sortCandidates() {
+    std::stable_sort(candidates.begin(), candidates.end(), [](const PeriodicityCandidate &a, const PeriodicityCandidate &b) {
+        return a.sigma > b.sigma;
+    });
+}
+
+void PeriodicitySearch::formPowerSpectrum(const FFT_COMPLEX_TYPE *bins, std::size_t nBins, std::vector<float> &powers) {
+    const float interbinScale = static_cast<float>(M_PI * M_PI / 16.0);
+    powers.resize(2 * nBins - 1);
+    for (std::size_t k = 0; k + 1 < nBins; k++) {
+        powers[2 * k] = std::norm(bins[k]);
+        powers[2 * k + 1] = interbinScale * std::norm(bins[k] - bins[k + 1]);
+    }
+    powers[2 * nBins - 2] = std::norm(bins[nBins - 1]);
+}
+
+/**
+ * The power of a noise bin is exponentially distributed, so its mean is its median / ln 2. Only the integer bins are
+ * used, as interbinned powers of noise are correlated with their neighbours and have a different mean.
+ */
+void PeriodicitySearch::normalisePowers(std::vector<float> &powers, std::size_t firstHalfBin, std::size_t lastHalfBin) {
+    std::vector<float> integerBins;
+    integerBins.reserve((lastHalfBin - firstHalfBin) / 2 + 1);
+    for (std::size_t j = firstHalfBin + firstHalfBin % 2; j <= lastHalfBin; j += 2) integerBins.push_back(powers[j]);
+    if (integerBins.empty()) return;
+
+    std::size_t middle = integerBins.size() / 2;
+    std::nth_element(integerBins.begin(), integerBins.begin() + middle, integerBins.end());
+    float median = integerBins[middle];
+    if (median <= 0.0f) return;
+
+    float scale = static_cast<float>(std::log(2.0)) / median;
+    for (float &power : powers) power *= scale;
+}
+
+void PeriodicitySearch::searchSeries(const float *timeSeries, std::size_t nSamples, float dm, std::vector<PeriodicityCandidate> &found) {
+    for (std::size_t trial = 0; trial < getNTrials(); trial++) searchTrial(timeSeries, nSamples, dm, trial, found);
+}
+
+void PeriodicitySearch::searchTrial(const float *timeSeries, std::size_t nSamples, float dm, std::size_t,
+                                    std::vector<PeriodicityCandidate> &found) {
+    std::vector<float> samples(timeSeries, timeSeries + RealFFT::goodLength(nSamples));
+    searchSamples(samples, dm, 0.0f, found);
+}
+
+void PeriodicitySearch::searchSamples(std::vector<float> &samples, float dm, float acceleration, std::vector<PeriodicityCandidate> &found) {
+    std::size_t fftLength = samples.size();
+    if (fftLength < 2) return;
+    std::shared_ptr<const RealFFT> plan = planCache->getRealPlan(fftLength);
+
+    float mean = static_cast<float>(std::accumulate(samples.begin(), samples.end(), 0.0) / fftLength);
+    for (float &sample : samples) sample -= mean;
+
+    std::vector<FFT_COMPLEX_TYPE> bins(fftLength / 2 + 1), work(plan->getWorkLength());
+    plan->forward(samples.data(), bins.data(), work.data());
+    if (spectrumCleaner) spectrumCleaner->clean(bins.data(), bins.size(), fftLength * tsamp);
+
+    std::vector<float> powers;
+    formPowerSpectrum(bins.data(), bins.size(), powers);
+    searchPowers(powers, fftLength * tsamp, dm, acceleration, found);
+}
+
+/**
+ * The sums are indexed by the half-bin R of the highest harmonic of each stage, as in FourierDomainSearch, so that
+ * harmonic k of stage s is at half-bin round(R * k / s) and no harmonic is more than half a half-bin off, however far
+ * the fundamental is from a half-bin. The even harmonics of stage s are those of stage s / 2 at the same R, so each
+ * stage only adds its odd harmonics to the running sums. Stage s starts at R = s * firstHalfBin, the lowest fundamental.
+ */
+void PeriodicitySearch::searchPowers(std::vector<float> &powers, double observationLength, float dm, float acceleration,
+                                     std::vector<PeriodicityCandidate> &found) {
+    std::size_t firstHalfBin, lastHalfBin;
+    if (!getSearchRange(powers.size(), observationLength, firstHalfBin, lastHalfBin)) return;
+
+    normalisePowers(powers, firstHalfBin, lastHalfBin);
+
+    std::vector<float> sums(powers.begin(), powers.begin() + lastHalfBin + 1);
+    std::vector<PeriodicityCandidate> seriesCandidates;
+
+    unsigned int stageIndex = 0;
+    for (unsigned int stage = 1; stage <= options.nHarmonics; stage *= 2, stageIndex++) {
+        std::size_t first = stage * firstHalfBin;
+        if (first + 2 > lastHalfBin) break;
+
+        for (unsigned int harmonic = 1; stage > 1 && harmonic < stage; harmonic += 2) {
+            float *__restrict__ sum = sums.data();
+            const float *__restrict__ power = powers.data();
+            for (std::size_t R = first; R <= lastHalfBin; R++) sum[R] += power[(R * harmonic + stage / 2) / stage];
+        }
+
+        float threshold = powerThresholds[stageIndex];
+        for (std::size_t R = first; R <= lastHalfBin; R++) {
+            if (sums[R] < threshold) continue;
+            if ((R > first && sums[R] < sums[R - 1]) || (R < lastHalfBin && sums[R] <= sums[R + 1])) continue;
+            PeriodicityCandidate candidate;
+            candidate.dm = dm;
+            candidate.acceleration = acceleration;
+            candidate.jerk = 0.0f;
+            candidate.frequency = 0.5 * R / stage / observationLength;
+            candidate.nHarmonics = stage;
+            candidate.power = sums[R];
+            candidate.sigma = powerToSigma(sums[R], stage);
+            seriesCandidates.push_back(candidate);
+        }
+    }
+
+    keepStrongest(seriesCandidates, observationLength, found);
+}
+
+bool PeriodicitySearch::getSearchRange(std::size_t nHalfBins, double observationLength, std::size_t &firstHalfBin,
+                                       std::size_t &lastHalfBin) const {
+    lastHalfBin = nHalfBins - 1;
+    if (options.maxFrequency > 0) {
+        lastHalfBin = std::min(lastHalfBin, static_cast<std::size_t>(2.0 * options.maxFrequency * observationLength));
+    }
+    firstHalfBin = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(2.0 * options.minFrequency * observationLength)));
+    return firstHalfBin + 2 <= lastHalfBin;
+}
+
+/**
+ * Keeps the strongest detection within a Fourier bin of every frequency, whatever the number of harmonics.
+ */
+void PeriodicitySearch::keepStrongest(std::vector<PeriodicityCandidate> &trialCandidates, double observationLength,
+                                      std::vector<PeriodicityCandidate> &found) const {
+    std::sort(trialCandidates.begin(), trialCandidates.end(), [](const PeriodicityCandidate &a, const PeriodicityCandidate &b) {
+        return a.sigma > b.sigma;
+    });
+    double binWidth = 1.0 / observationLength;
+    std::size_t firstKept = found.size();
+    for (const PeriodicityCandidate &candidate : trialCandidates) {
+        if (found.size() - firstKept >= options.maxCandidatesPerSeries) break;
+        bool duplicate = std::any_of(found.begin() + firstKept, found.end(), [&](const PeriodicityCandidate &kept) {
+            return std::fabs(kept.frequency - candidate.frequency) < binWidth;
+        });
+        if (!duplicate) found.push_back(candidate);
+    }
+}
+
+void PeriodicitySearch::writeCandidates(const std::string &fileName) const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) throw FileIOError(0, 0, "open " + fileName);
+
+    file << "# DM acceleration(m/s^2) jerk(m/s^3) frequency(Hz) period(ms) nharm power sigma" << std::endl;
+    for (const PeriodicityCandidate &candidate : candidates) {
+        file << std::fixed << std::setprecision(3) << candidate.dm << " " << candidate.acceleration << " " << candidate.jerk << " "
+             << std::setprecision(9) << candidate.frequency << " " << 1000.0 / candidate.frequency << " "
+             << candidate.nHarmonics << " " << std::setprecision(2) << candidate.power << " " << candidate.sigma << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+#include "operations/rfi_flagger.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace OPS;
+
+namespace {
+
+    float medianOf(std::vector<float> &values) {
+        std::size_t middle = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + middle, values.end());
+        return values[middle];
+    }
+
+};
+
+RFIFlagger::RFIFlagger(unsigned int nChans, float threshold, unsigned int nThreads, std::size_t window)
+    : nChans(nChans), threshold(threshold), window(std::max<std::size_t>(window, 3)), statistics(nChans, nThreads) {
+    if (threshold <= 0) throw InvalidInputs("The RFI flagging threshold must be positive");
+    this->mask.assign(nChans, 1);
+    this->nGulps = 0;
+    this->nChannelsFlagged = 0;
+}
+
+/**
+ * Compares every usable channel with the running median of the usable channels around it, so that the smooth shape of
+ * the band is not mistaken for RFI.
+ */
+void RFIFlagger::flagOutliers(const std::vector<float> &values, const std::vector<bool> &usable) {
+    std::vector<float> residuals(nChans, 0.0f);
+    std::vector<float> neighbours, spread;
+    neighbours.reserve(window);
+    spread.reserve(nChans);
+
+    for (unsigned int c = 0; c < nChans; c++) {
+        if (!usable[c]) continue;
+        std::size_t first = c > window / 2 ? c - window / 2 : 0;
+        std::size_t last = std::min<std::size_t>(nChans, c + window / 2 + 1);
+        neighbours.clear();
+        for (std::size_t n = first; n < last; n++) {
+            if (usable[n]) neighbours.push_back(values[n]);
+        }
+        residuals[c] = values[c] - medianOf(neighbours);
+        spread.push_back(residuals[c]);
+    }
+    if (spread.size() < 3) return;
+
+    float centre = medianOf(spread);
+    for (float &value : spread) value = std::fabs(value - centre);
+    float sigma = 1.4826f * medianOf(spread);
+    if (sigma <= 0.0f) return;
+
+    for (unsigned int c = 0; c < nChans; c++) {
+        if (usable[c] && std::fabs(residuals[c] - centre) > threshold * sigma) mask[c] = 0;
+    }
+}
+
+const std::vector<DEDISP_BOOL> &RFIFlagger::flag(const BandpassStatistics &stats) {
+    if (stats.mean.size() != nChans) throw InvalidInputs("Channel statistics do not match the number of channels");
+
+    double nSamples = static_cast<double>(stats.nSamples);
+    double skScale = nSamples > 1 ? (nSamples + 1) / (nSamples - 1) : 1.0;
+    std::vector<float> kurtosis(nChans, 0.0f);
+    std::vector<bool> live(nChans), positive(nChans);
+
+    mask.assign(nChans, 1);
+    for (unsigned int c = 0; c < nChans; c++) {
+        live[c] = stats.rms[c] > 0.0f;
+        positive[c] = live[c] && stats.mean[c] > 0.0f;
+        if (!live[c]) mask[c] = 0;
+        if (positive[c]) {
+            double ratio = static_cast<double>(stats.rms[c]) / stats.mean[c];
+            kurtosis[c] = static_cast<float>(skScale * ratio * ratio);
+        }
+    }
+
+    flagOutliers(kurtosis, positive);
+    flagOutliers(stats.mean, live);
+
+    nGulps++;
+    nChannelsFlagged += std::count(mask.begin(), mask.end(), 0);
+    return mask;
+}
+
+const std::vector<DEDISP_BOOL> &RFIFlagger::flag(std::size_t nSamples, const uint8_t *data, unsigned int inNBits) {
+    statistics.compute(nSamples, data, inNBits, gulpStatistics);
+    return flag(gulpStatistics);
+}
+
+float RFIFlagger::getFlaggedFraction() const {
+    return static_cast<float>(std::count(mask.begin(), mask.end(), 0)) / nChans;
+}
+
+float RFIFlagger::getTotalFlaggedFraction() const {
+    return nGulps > 0 ? static_cast<float>(nChannelsFlagged) / (nGulps * nChans) : 0.0f;
+}
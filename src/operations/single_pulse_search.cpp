@@ -0,0 +1,174 @@
+#include "operations/single_pulse_search.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+using namespace OPS;
+
+namespace {
+
+    /* sigma of a normal distribution over its median absolute deviation */
+    const float MAD_TO_SIGMA = 1.4826f;
+
+};
+
+SinglePulseSearch::SinglePulseSearch(const std::vector<float> &dmList, double tsamp, const SinglePulseSearchOptions &options)
+    : options(options), tsamp(tsamp), dmList(dmList) {
+    unsigned int maxWidth = options.maxWidth;
+    if (maxWidth == 0 || (maxWidth & (maxWidth - 1)) != 0) throw InvalidInputs("The widest boxcar must be a power of two");
+    if (tsamp <= 0) throw InvalidInputs("The sampling time must be positive");
+    if (options.sigmaThreshold <= 0) throw InvalidInputs("The single pulse threshold must be positive");
+
+    for (unsigned int width = 1; width <= maxWidth; width *= 2) widths.push_back(width);
+    this->states.resize(dmList.size());
+}
+
+bool SinglePulseSearch::robustStatistics(const float *values, std::size_t nValues, std::vector<float> &scratch,
+                                         float &median, float &sigma) {
+    if (nValues == 0) return false;
+    std::size_t stride = (nValues + STATISTICS_SAMPLES - 1) / STATISTICS_SAMPLES;
+    scratch.clear();
+    for (std::size_t i = 0; i < nValues; i += stride) scratch.push_back(values[i]);
+
+    std::size_t middle = scratch.size() / 2;
+    std::nth_element(scratch.begin(), scratch.begin() + middle, scratch.end());
+    median = scratch[middle];
+    for (float &value : scratch) value = std::fabs(value - median);
+    std::nth_element(scratch.begin(), scratch.begin() + middle, scratch.end());
+    sigma = MAD_TO_SIGMA * scratch[middle];
+    return sigma > 0.0f;
+}
+
+void SinglePulseSearch::consume(const IO::DedispersedBlock &block) {
+    Workspace workspace;
+    std::vector<SinglePulseEvent> found;
+    for (std::size_t i = 0; i < block.nDMs; i++) {
+        searchSeries(block.dmStart + i, block.getSeries(i), block.nSamples, block.startSample, workspace, found);
+    }
+    if (found.empty()) return;
+    std::unique_lock<std::mutex> lock(eventsMutex);
+    events.insert(events.end(), found.begin(), found.end());
+}
+
+/**
+ * The buffer holds the nTail carried-over samples followed by the new ones, all normalised with the statistics of the
+ * new ones, and the boxcars searched are those that end on a new sample: the others were searched with the previous
+ * gulp. Boxcar outputs are indexed by their last new sample, so all widths line up and the best of them is a
+ * vectorised select per sample.
+ */
+void SinglePulseSearch::searchSeries(std::size_t iDM, const float *samples, std::size_t nSamples, std::size_t startSample,
+                                     Workspace &workspace, std::vector<SinglePulseEvent> &found) {
+    DMState &state = states[iDM];
+    float median, sigma;
+    if (!robustStatistics(samples, nSamples, workspace.statistics, median, sigma)) return;
+
+    const std::size_t nTail = state.tail.size();
+    const std::size_t nBuffer = nTail + nSamples;
+    workspace.normalised.resize(nBuffer);
+    {
+        float *__restrict__ out = workspace.normalised.data();
+        const float *__restrict__ tail = state.tail.data();
+        const float *__restrict__ in = samples;
+        const float scale = 1.0f / sigma;
+        for (std::size_t i = 0; i < nTail; i++) out[i] = (tail[i] - median) * scale;
+        for (std::size_t i = 0; i < nSamples; i++) out[nTail + i] = (in[i] - median) * scale;
+    }
+
+    /* Double prefix sums keep the boxcars exact however far the sums wander over a long gulp. */
+    workspace.prefixSums.resize(nBuffer + 1);
+    double *prefix = workspace.prefixSums.data();
+    prefix[0] = 0.0;
+    for (std::size_t i = 0; i < nBuffer; i++) prefix[i + 1] = prefix[i] + workspace.normalised[i];
+
+    workspace.boxcar.resize(nSamples);
+    workspace.bestSNR.assign(nSamples, -INFINITY);
+    workspace.bestWidth.assign(nSamples, 0);
+    for (unsigned int width : widths) {
+        /* output j is the boxcar ending at buffer index nTail + j + 1, and needs width samples before that */
+        std::size_t first = width > nTail + 1 ? width - nTail - 1 : 0;
+        if (first >= nSamples) break;
+        std::size_t nOut = nSamples - first;
+
+        {
+            float *__restrict__ box = workspace.boxcar.data() + first;
+            const double *__restrict__ ends = prefix + nTail + 1 + first;
+            const double *__restrict__ starts = ends - width;
+            for (std::size_t j = 0; j < nOut; j++) box[j] = static_cast<float>(ends[j] - starts[j]);
+        }
+
+        float boxMedian, boxSigma;
+        if (!robustStatistics(workspace.boxcar.data() + first, nOut, workspace.statistics, boxMedian, boxSigma)) continue;
+
+        float *__restrict__ best = workspace.bestSNR.data() + first;
+        unsigned int *__restrict__ bestWidth = workspace.bestWidth.data() + first;
+        const float *__restrict__ box = workspace.boxcar.data() + first;
+        const float scale = 1.0f / boxSigma;
+        for (std::size_t j = 0; j < nOut; j++) {
+            float snr = (box[j] - boxMedian) * scale;
+            bool better = snr > best[j];
+            best[j] = better ? snr : best[j];
+            bestWidth[j] = better ? width : bestWidth[j];
+        }
+    }
+
+    /* One event per run of samples above the threshold, at its peak. A run open at the end of the previous gulp
+       either ended there or continues from the first sample, and one open at the end of this gulp waits for the next. */
+    const float threshold = options.sigmaThreshold;
+    const float *best = workspace.bestSNR.data();
+    if (state.runOpen && best[0] < threshold) {
+        found.push_back(state.runPeak);
+        state.runOpen = false;
+    }
+    for (std::size_t j = 0; j < nSamples; j++) {
+        if (best[j] < threshold) continue;
+        std::size_t runStart = j, peak = j;
+        for (; j < nSamples && best[j] >= threshold; j++) {
+            if (best[j] > best[peak]) peak = j;
+        }
+        unsigned int width = workspace.bestWidth[peak];
+        SinglePulseEvent event{dmList[iDM], startSample + peak + 1 - width, width, best[peak]};
+        if (runStart == 0 && state.runOpen) {
+            if (state.runPeak.snr >= event.snr) event = state.runPeak;
+            state.runOpen = false;
+        }
+        if (j == nSamples) {
+            state.runPeak = event;
+            state.runOpen = true;
+        }
+        else {
+            found.push_back(event);
+        }
+    }
+
+    std::size_t nKeep = std::min<std::size_t>(options.maxWidth - 1, nBuffer);
+    if (nKeep <= nSamples) {
+        state.tail.assign(samples + nSamples - nKeep, samples + nSamples);
+    }
+    else {
+        state.tail.erase(state.tail.begin(), state.tail.begin() + (nBuffer - nKeep));
+        state.tail.insert(state.tail.end(), samples, samples + nSamples);
+    }
+}
+
+void SinglePulseSearch::finish() {
+    for (DMState &state : states) {
+        if (state.runOpen) events.push_back(state.runPeak);
+        state.runOpen = false;
+    }
+    std::sort(events.begin(), events.end(), [](const SinglePulseEvent &a, const SinglePulseEvent &b) {
+        return a.sample != b.sample ? a.sample < b.sample : a.dm < b.dm;
+    });
+}
+
+void SinglePulseSearch::writeEvents(const std::string &fileName) const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) throw FileIOError(0, 0, "open " + fileName);
+
+    file << "# DM sample time(s) width(samples) snr" << std::endl;
+    for (const SinglePulseEvent &event : events) {
+        file << std::fixed << std::setprecision(3) << event.dm << " " << event.sample << " " << std::setprecision(6)
+             << event.sample * tsamp << " " << event.width << " " << std::setprecision(2) << event.snr << std::endl;
+    }
+}
@@ -0,0 +1,99 @@
+#include "operations/spectrum_cleaner.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+using namespace OPS;
+
+SpectrumCleaner::SpectrumCleaner(bool whiten, const std::vector<Birdie> &birdies) : whiten(whiten) {
+    std::vector<std::pair<double, double>> intervals;
+    for (const Birdie &birdie : birdies) {
+        if (birdie.frequency <= 0 || birdie.width < 0) throw InvalidInputs("Birdies need a positive frequency and width");
+        for (unsigned int h = 1; h <= birdie.nHarmonics; h++) {
+            double centre = h * birdie.frequency;
+            intervals.emplace_back(centre - 0.5 * birdie.width, centre + 0.5 * birdie.width);
+        }
+    }
+    std::sort(intervals.begin(), intervals.end());
+    for (const std::pair<double, double> &interval : intervals) {
+        if (!zapIntervals.empty() && interval.first <= zapIntervals.back().second) {
+            zapIntervals.back().second = std::max(zapIntervals.back().second, interval.second);
+        }
+        else {
+            zapIntervals.push_back(interval);
+        }
+    }
+}
+
+void SpectrumCleaner::clean(FFT_COMPLEX_TYPE *bins, std::size_t nBins, double observationLength) const {
+    if (whiten) whitenSpectrum(bins, nBins);
+    if (!zapIntervals.empty()) zapBirdies(bins, nBins, observationLength);
+}
+
+/**
+ * The DC bin is left alone. Bins below the first block centre and above the last take the nearest block's level.
+ */
+void SpectrumCleaner::whitenSpectrum(FFT_COMPLEX_TYPE *bins, std::size_t nBins) const {
+    std::vector<double> centres, levels;
+    std::vector<float> blockPowers;
+    for (std::size_t start = 1; start < nBins;) {
+        std::size_t width = static_cast<std::size_t>(BLOCK_GROWTH * start);
+        width = std::min(std::max(width, MIN_BLOCK_BINS), MAX_BLOCK_BINS);
+        std::size_t end = std::min(start + width, nBins);
+
+        blockPowers.clear();
+        for (std::size_t k = start; k < end; k++) blockPowers.push_back(std::norm(bins[k]));
+        std::size_t middle = blockPowers.size() / 2;
+        std::nth_element(blockPowers.begin(), blockPowers.begin() + middle, blockPowers.end());
+        if (blockPowers[middle] > 0.0f) {
+            centres.push_back(0.5 * (start + end - 1));
+            levels.push_back(blockPowers[middle] / std::log(2.0));
+        }
+        start = end;
+    }
+    if (levels.empty()) return;
+
+    std::size_t block = 0;
+    for (std::size_t k = 1; k < nBins; k++) {
+        while (block + 1 < centres.size() && centres[block + 1] <= k) block++;
+        double level = levels[block];
+        if (block + 1 < centres.size() && k > centres[block]) {
+            double fraction = (k - centres[block]) / (centres[block + 1] - centres[block]);
+            level += fraction * (levels[block + 1] - levels[block]);
+        }
+        bins[k] *= static_cast<float>(1.0 / std::sqrt(level));
+    }
+}
+
+void SpectrumCleaner::zapBirdies(FFT_COMPLEX_TYPE *bins, std::size_t nBins, double observationLength) const {
+    /* The first interval whose upper edge reaches bin 0, found by binary search over the upper edges. */
+    auto interval = std::lower_bound(zapIntervals.begin(), zapIntervals.end(), 0.0,
+                                     [](const std::pair<double, double> &zap, double frequency) { return zap.second < frequency; });
+    for (; interval != zapIntervals.end(); ++interval) {
+        double low = std::max(0.0, interval->first * observationLength);
+        if (low >= nBins) break;
+        std::size_t first = static_cast<std::size_t>(std::floor(low));
+        std::size_t last = std::min(nBins - 1, static_cast<std::size_t>(std::ceil(interval->second * observationLength)));
+        std::fill(bins + first, bins + last + 1, FFT_COMPLEX_TYPE(0.0f, 0.0f));
+    }
+}
+
+std::vector<Birdie> SpectrumCleaner::readBirdies(const std::string &fileName) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) throw FileIOError(0, 0, "open " + fileName);
+
+    std::vector<Birdie> birdies;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream columns(line);
+        Birdie birdie{0.0, 0.0, 1};
+        if (!(columns >> birdie.frequency >> birdie.width)) throw FileFormatNotRecognised(fileName);
+        unsigned int nHarmonics;
+        if (columns >> nHarmonics) birdie.nHarmonics = nHarmonics;
+        birdies.push_back(birdie);
+    }
+    return birdies;
+}
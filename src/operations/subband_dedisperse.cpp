@@ -0,0 +1,205 @@
+#include "operations/subband_dedisperse.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+using namespace OPS;
+
+SubbandDedisperser::SubbandDedisperser(std::shared_ptr<IO::SearchModeFile> searchModeFile, unsigned int nThreads, unsigned int nSubbands, float maxSmearingSamples)
+    : CPUDedisperser(searchModeFile, nThreads) {
+
+    if (nSubbands == 0) nSubbands = static_cast<unsigned int>(std::lround(std::sqrt(static_cast<double>(nChans))));
+    this->nSubbands = std::max(1u, std::min(nSubbands, nChans));
+    this->maxSmearingSamples = maxSmearingSamples;
+    generateSubbands();
+}
+
+void SubbandDedisperser::generateSubbands() {
+    subbandStart.resize(nSubbands + 1);
+    for (unsigned int s = 0; s <= nSubbands; s++) {
+        subbandStart[s] = static_cast<unsigned int>((static_cast<std::size_t>(s) * nChans) / nSubbands);
+    }
+}
+
+/**
+ * The reference channel of a subband is its highest frequency (smallest delay), so that all intra-subband offsets are
+ * non-negative. The delay span of the widest subband sets how far a trial may sit from its nominal DM.
+ */
+void SubbandDedisperser::generateNominalDMs() {
+    float maxSpan = 0.0f;
+    for (unsigned int s = 0; s < nSubbands; s++) {
+        auto first = delayTable.begin() + subbandStart[s];
+        auto last = delayTable.begin() + subbandStart[s + 1];
+        maxSpan = std::max(maxSpan, *std::max_element(first, last) - *std::min_element(first, last));
+    }
+
+    std::vector<std::size_t> order(dmList.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return dmList[a] < dmList[b]; });
+
+    nominalDMs.clear();
+    dmGroups.clear();
+    smearingSamples.assign(dmList.size(), 0.0f);
+
+    std::size_t i = 0;
+    while (i < order.size()) {
+        float groupStart = dmList[order[i]];
+        std::size_t j = i;
+        while (j + 1 < order.size() && 0.5f * (dmList[order[j + 1]] - groupStart) * maxSpan <= maxSmearingSamples) j++;
+
+        float nominalDM = 0.5f * (groupStart + dmList[order[j]]);
+        nominalDMs.push_back(nominalDM);
+        dmGroups.emplace_back(order.begin() + i, order.begin() + j + 1);
+        for (std::size_t k = i; k <= j; k++) {
+            smearingSamples[order[k]] = std::fabs(dmList[order[k]] - nominalDM) * maxSpan;
+        }
+        i = j + 1;
+    }
+}
+
+void SubbandDedisperser::setDMList(const std::vector<float> &dmList) {
+    DedispersionBackend::setDMList(dmList);
+    generateNominalDMs();
+
+    /* Rounding the two stages separately can reach a sample or so past the single-stage maximum delay. */
+    for (std::size_t k = 0; k < nominalDMs.size(); k++) {
+        for (unsigned int s = 0; s < nSubbands; s++) {
+            unsigned int refChan = subbandStart[s];
+            std::size_t maxOffset = 0;
+            for (unsigned int c = subbandStart[s]; c < subbandStart[s + 1]; c++) {
+                if (delayTable[c] < delayTable[refChan]) refChan = c;
+            }
+            for (unsigned int c = subbandStart[s]; c < subbandStart[s + 1]; c++) {
+                maxOffset = std::max(maxOffset, getDelaySamples(nominalDMs[k], c) - getDelaySamples(nominalDMs[k], refChan));
+            }
+            for (std::size_t iDM : dmGroups[k]) {
+                maxDelaySamples = std::max(maxDelaySamples, getDelaySamples(this->dmList[iDM], refChan) + maxOffset);
+            }
+        }
+    }
+    printSmearingReport();
+}
+
+void SubbandDedisperser::printSmearingReport() {
+    if (smearingSamples.empty()) return;
+    float maxSmearing = *std::max_element(smearingSamples.begin(), smearingSamples.end());
+    float meanSmearing = std::accumulate(smearingSamples.begin(), smearingSamples.end(), 0.0f) / smearingSamples.size();
+
+    std::cout << "Subband dedispersion: " << nSubbands << " subbands, " << nominalDMs.size() << " nominal DMs for "
+              << dmList.size() << " DM trials" << std::endl;
+    std::cout << "Subband smearing penalty: max " << std::setprecision(3) << maxSmearing << " samples ("
+              << maxSmearing * tsamp * 1e3 << " ms), mean " << meanSmearing << " samples" << std::endl;
+}
+
+void SubbandDedisperser::execute(std::size_t nSamplesIn, const uint8_t *inData, unsigned int inNBits, DEDISP_OUTPUT_TYPE *outData) {
+    if (nSamplesIn <= maxDelaySamples) {
+        throw InvalidInputs("Number of input samples must exceed the maximum delay");
+    }
+    switch (inNBits)
+    {
+    case 8:
+        executeOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_8_BIT_TYPE *>(inData), outData);
+        break;
+    case 16:
+        executeOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_16_BIT_TYPE *>(inData), outData);
+        break;
+    case 32:
+        executeOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamplesIn, reinterpret_cast<const SIGPROC_FILTERBANK_32_BIT_TYPE *>(inData), outData);
+        break;
+    default:
+        throw InvalidInputs("Subband dedispersion supports 8, 16 and 32 bit input only");
+    }
+}
+
+BackendMemory SubbandDedisperser::getWorkingMemory(unsigned int inNBits) {
+    BackendMemory memory = CPUDedisperser::getWorkingMemory(inNBits);
+    memory.bytesPerSample += nSubbands * sizeof(float);
+    return memory;
+}
+
+template <typename DTYPE>
+void SubbandDedisperser::executeOfType(std::size_t nSamplesIn, const DTYPE *inData, DEDISP_OUTPUT_TYPE *outData) {
+    const DTYPE *transposed = transposeGulp<DTYPE>(nSamplesIn, inData);
+    std::size_t nSamplesOut = nSamplesIn - maxDelaySamples;
+
+    if (subbandData.size() < nSubbands * nSamplesIn) subbandData.resize(nSubbands * nSamplesIn);
+
+    std::vector<unsigned int> refChans(nSubbands);
+    for (unsigned int s = 0; s < nSubbands; s++) {
+        refChans[s] = subbandStart[s];
+        for (unsigned int c = subbandStart[s]; c < subbandStart[s + 1]; c++) {
+            if (delayTable[c] < delayTable[refChans[s]]) refChans[s] = c;
+        }
+    }
+
+    for (std::size_t k = 0; k < nominalDMs.size(); k++) {
+        float nominalDM = nominalDMs[k];
+
+        /* Stage one: each subband dedispersed to its own reference channel at the nominal DM. */
+        threadPool->parallelFor(0, nSubbands, [&](std::size_t subStart, std::size_t subEnd) {
+            std::vector<float> accumulator(SAMPLES_PER_BLOCK);
+            std::vector<unsigned int> chans;
+            std::vector<std::size_t> offsets;
+
+            for (std::size_t s = subStart; s < subEnd; s++) {
+                chans.clear();
+                offsets.clear();
+                std::size_t refDelay = getDelaySamples(nominalDM, refChans[s]);
+                for (unsigned int c = subbandStart[s]; c < subbandStart[s + 1]; c++) {
+                    if (!killmask[c]) continue;
+                    chans.push_back(c);
+                    offsets.push_back(getDelaySamples(nominalDM, c) - refDelay);
+                }
+                std::size_t maxOffset = offsets.empty() ? 0 : *std::max_element(offsets.begin(), offsets.end());
+                std::size_t nSubSamples = nSamplesIn - maxOffset;
+                float *subOut = subbandData.data() + s * nSamplesIn;
+
+                for (std::size_t t0 = 0; t0 < nSubSamples; t0 += SAMPLES_PER_BLOCK) {
+                    std::size_t blockLength = std::min(SAMPLES_PER_BLOCK, nSubSamples - t0);
+                    float *__restrict__ acc = accumulator.data();
+                    std::fill(acc, acc + blockLength, 0.0f);
+
+                    for (std::size_t i = 0; i < chans.size(); i++) {
+                        const DTYPE *__restrict__ src = transposed + chans[i] * nSamplesIn + t0 + offsets[i];
+                        for (std::size_t t = 0; t < blockLength; t++) {
+                            acc[t] += static_cast<float>(src[t]);
+                        }
+                    }
+                    std::copy(acc, acc + blockLength, subOut + t0);
+                }
+            }
+        });
+
+        /* Stage two: every fine trial of this nominal DM is a shift-and-add of the subband series. */
+        const std::vector<std::size_t> &group = dmGroups[k];
+        threadPool->parallelFor(0, group.size(), [&](std::size_t groupStart, std::size_t groupEnd) {
+            std::vector<float> accumulator(SAMPLES_PER_BLOCK);
+            std::vector<std::size_t> delays(nSubbands);
+
+            for (std::size_t g = groupStart; g < groupEnd; g++) {
+                std::size_t iDM = group[g];
+                for (unsigned int s = 0; s < nSubbands; s++) {
+                    delays[s] = getDelaySamples(dmList[iDM], refChans[s]);
+                }
+                DEDISP_OUTPUT_TYPE *dmOut = outData + iDM * nSamplesOut;
+
+                for (std::size_t t0 = 0; t0 < nSamplesOut; t0 += SAMPLES_PER_BLOCK) {
+                    std::size_t blockLength = std::min(SAMPLES_PER_BLOCK, nSamplesOut - t0);
+                    float *__restrict__ acc = accumulator.data();
+                    std::fill(acc, acc + blockLength, 0.0f);
+
+                    for (unsigned int s = 0; s < nSubbands; s++) {
+                        const float *__restrict__ src = subbandData.data() + s * nSamplesIn + t0 + delays[s];
+                        for (std::size_t t = 0; t < blockLength; t++) {
+                            acc[t] += src[t];
+                        }
+                    }
+                    std::copy(acc, acc + blockLength, dmOut + t0);
+                }
+            }
+        });
+    }
+}
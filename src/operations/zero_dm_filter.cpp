@@ -0,0 +1,121 @@
+#include "operations/zero_dm_filter.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+using namespace OPS;
+
+namespace {
+
+    float medianOf(std::vector<float> &values) {
+        std::size_t middle = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + middle, values.end());
+        return values[middle];
+    }
+
+};
+
+ZeroDMFilter::ZeroDMFilter(unsigned int nChans, bool subtractZeroDM, float clipSigma, unsigned int nThreads)
+    : nChans(nChans), subtractZeroDM(subtractZeroDM), clipSigma(clipSigma) {
+    if (clipSigma < 0) throw InvalidInputs("The clipping threshold cannot be negative");
+    this->threadPool = std::make_unique<UTILS::ThreadPool>(nThreads);
+    this->weights.resize(nChans);
+    this->channelMeans.resize(nChans);
+    this->nSamplesSeen = 0;
+    this->nSamplesClipped = 0;
+}
+
+void ZeroDMFilter::apply(std::size_t nSamples, uint8_t *data, unsigned int inNBits, const std::vector<DEDISP_BOOL> &mask) {
+    if (mask.size() != nChans) throw InvalidInputs("Mask size does not match the number of channels");
+    if (nSamples == 0) return;
+
+    for (unsigned int c = 0; c < nChans; c++) weights[c] = mask[c] ? 1.0f : 0.0f;
+
+    switch (inNBits)
+    {
+    case 8:
+        applyOfType<SIGPROC_FILTERBANK_8_BIT_TYPE>(nSamples, data, 255.0f);
+        break;
+    case 16:
+        applyOfType<SIGPROC_FILTERBANK_16_BIT_TYPE>(nSamples, reinterpret_cast<SIGPROC_FILTERBANK_16_BIT_TYPE *>(data), 65535.0f);
+        break;
+    case 32:
+        applyOfType<SIGPROC_FILTERBANK_32_BIT_TYPE>(nSamples, reinterpret_cast<SIGPROC_FILTERBANK_32_BIT_TYPE *>(data), 0.0f);
+        break;
+    default:
+        throw InvalidInputs("The zero-DM filter supports 8, 16 and 32 bit data only");
+    }
+}
+
+template <typename DTYPE>
+void ZeroDMFilter::applyOfType(std::size_t nSamples, DTYPE *data, float maxValue) {
+    const std::size_t nChans = this->nChans;
+    float nActive = static_cast<float>(std::count(weights.begin(), weights.end(), 1.0f));
+    if (nActive == 0) return;
+
+    /* One block of samples per thread, each with its own channel sums. */
+    std::size_t nBlocks = std::min<std::size_t>(threadPool->getNThreads(), (nSamples + SAMPLES_PER_CHUNK - 1) / SAMPLES_PER_CHUNK);
+    std::size_t blockLength = (nSamples + nBlocks - 1) / nBlocks;
+    std::vector<double> partialSums(nBlocks * nChans, 0.0);
+    zeroDM.resize(nSamples);
+
+    threadPool->parallelFor(0, nBlocks, [&](std::size_t blockStart, std::size_t blockEnd) {
+        for (std::size_t block = blockStart; block < blockEnd; block++) {
+            double *__restrict__ sums = partialSums.data() + block * nChans;
+            const float *__restrict__ weight = weights.data();
+            std::size_t sampleEnd = std::min(nSamples, (block + 1) * blockLength);
+            for (std::size_t t = block * blockLength; t < sampleEnd; t++) {
+                const DTYPE *__restrict__ row = data + t * nChans;
+                float total = 0.0f;
+                for (std::size_t c = 0; c < nChans; c++) {
+                    float value = static_cast<float>(row[c]);
+                    total += value * weight[c];
+                    sums[c] += value;
+                }
+                zeroDM[t] = total / nActive;
+            }
+        }
+    });
+
+    for (std::size_t c = 0; c < nChans; c++) {
+        double sum = 0.0;
+        for (std::size_t block = 0; block < nBlocks; block++) sum += partialSums[block * nChans + c];
+        channelMeans[c] = static_cast<float>(sum / nSamples);
+    }
+
+    std::vector<float> spread(zeroDM.begin(), zeroDM.end());
+    float median = medianOf(spread);
+    for (float &value : spread) value = std::fabs(value - median);
+    float sigma = 1.4826f * medianOf(spread);
+
+    clipped.assign(nSamples, 0);
+    std::size_t nClipped = 0;
+    if (clipSigma > 0 && sigma > 0) {
+        for (std::size_t t = 0; t < nSamples; t++) {
+            clipped[t] = zeroDM[t] - median > clipSigma * sigma;
+            nClipped += clipped[t];
+        }
+    }
+    nSamplesSeen += nSamples;
+    nSamplesClipped += nClipped;
+    if (!subtractZeroDM && nClipped == 0) return;
+
+    threadPool->parallelFor(0, nSamples, [&](std::size_t sampleStart, std::size_t sampleEnd) {
+        const float *__restrict__ means = channelMeans.data();
+        for (std::size_t t = sampleStart; t < sampleEnd; t++) {
+            DTYPE *__restrict__ row = data + t * nChans;
+            float shift = subtractZeroDM ? zeroDM[t] - median : 0.0f;
+            if (!clipped[t] && shift == 0.0f) continue;
+            for (std::size_t c = 0; c < nChans; c++) {
+                float value = clipped[t] ? means[c] : static_cast<float>(row[c]) - shift;
+                if constexpr (std::is_floating_point<DTYPE>::value) {
+                    row[c] = value;
+                }
+                else {
+                    row[c] = static_cast<DTYPE>(std::min(std::max(value, 0.0f), maxValue) + 0.5f);
+                }
+            }
+        }
+    }, SAMPLES_PER_CHUNK);
+}
@@ -0,0 +1,264 @@
+#include "utils/bit_unpack.hpp"
+#include "exceptions.hpp"
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UNPACK_HAVE_X86 1
+#endif
+
+using namespace UTILS;
+
+namespace {
+
+    /* Bytes handed to one thread at a time; below this, threading costs more than it saves. */
+    const std::size_t UNPACK_CHUNK_BYTES = 1 << 18;
+
+    struct UnpackTables
+    {
+        uint8_t values[5][256][8]; /**< values[nBits][byte] holds the 8 / nBits samples of byte, for nBits = 1, 2, 4. */
+
+        UnpackTables() {
+            for (unsigned int nBits : {1u, 2u, 4u}) {
+                for (unsigned int byte = 0; byte < 256; byte++) {
+                    for (unsigned int s = 0; s < 8 / nBits; s++) {
+                        values[nBits][byte][s] = (byte >> (s * nBits)) & ((1u << nBits) - 1);
+                    }
+                }
+            }
+        }
+    };
+
+    const UnpackTables tables;
+
+    template <unsigned int NBITS>
+    void unpackLookup(const uint8_t *packed, std::size_t nBytes, uint8_t *unpacked) {
+        const std::size_t perByte = 8 / NBITS;
+        for (std::size_t i = 0; i < nBytes; i++) {
+            std::memcpy(unpacked + i * perByte, tables.values[NBITS][packed[i]], perByte);
+        }
+    }
+
+    void unpackLookup(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        switch (nBits)
+        {
+        case 1: unpackLookup<1>(packed, nBytes, unpacked); break;
+        case 2: unpackLookup<2>(packed, nBytes, unpacked); break;
+        case 4: unpackLookup<4>(packed, nBytes, unpacked); break;
+        }
+    }
+
+#ifdef UNPACK_HAVE_X86
+
+/*
+ * One kernel body for every instruction set. Each sample plane (x >> s * nBits) & mask is interleaved back into sample
+ * order with byte, then 16 and 32 bit unpacks. Those unpacks work within 128 bit lanes, so every lane holds the samples
+ * of its own 16 input bytes and is stored separately. Returns the number of bytes done; the caller finishes the rest.
+ */
+#define UNPACK_KERNEL_BODY                                                                                              \
+    const V_TYPE mask = V_SET1(static_cast<char>((1 << nBits) - 1));                                                    \
+    const std::size_t perByte = 8 / nBits;                                                                              \
+    std::size_t i = 0;                                                                                                  \
+    for (; i + V_BYTES <= nBytes; i += V_BYTES) {                                                                       \
+        V_TYPE x = V_LOAD(packed + i);                                                                                  \
+        V_TYPE r[8];                                                                                                    \
+        if (nBits == 4) {                                                                                               \
+            V_TYPE a0 = V_AND(x, mask), a1 = V_AND(V_SRL(x, 4), mask);                                                  \
+            r[0] = V_LO8(a0, a1); r[1] = V_HI8(a0, a1);                                                                 \
+        }                                                                                                               \
+        else if (nBits == 2) {                                                                                          \
+            V_TYPE a0 = V_AND(x, mask), a1 = V_AND(V_SRL(x, 2), mask);                                                  \
+            V_TYPE a2 = V_AND(V_SRL(x, 4), mask), a3 = V_AND(V_SRL(x, 6), mask);                                        \
+            V_TYPE l0 = V_LO8(a0, a1), h0 = V_HI8(a0, a1), l1 = V_LO8(a2, a3), h1 = V_HI8(a2, a3);                      \
+            r[0] = V_LO16(l0, l1); r[1] = V_HI16(l0, l1); r[2] = V_LO16(h0, h1); r[3] = V_HI16(h0, h1);                 \
+        }                                                                                                               \
+        else {                                                                                                          \
+            V_TYPE a0 = V_AND(x, mask), a1 = V_AND(V_SRL(x, 1), mask);                                                  \
+            V_TYPE a2 = V_AND(V_SRL(x, 2), mask), a3 = V_AND(V_SRL(x, 3), mask);                                        \
+            V_TYPE a4 = V_AND(V_SRL(x, 4), mask), a5 = V_AND(V_SRL(x, 5), mask);                                        \
+            V_TYPE a6 = V_AND(V_SRL(x, 6), mask), a7 = V_AND(V_SRL(x, 7), mask);                                        \
+            V_TYPE p0l = V_LO8(a0, a1), p0h = V_HI8(a0, a1), p1l = V_LO8(a2, a3), p1h = V_HI8(a2, a3);                  \
+            V_TYPE p2l = V_LO8(a4, a5), p2h = V_HI8(a4, a5), p3l = V_LO8(a6, a7), p3h = V_HI8(a6, a7);                  \
+            V_TYPE q0[4] = {V_LO16(p0l, p1l), V_HI16(p0l, p1l), V_LO16(p0h, p1h), V_HI16(p0h, p1h)};                    \
+            V_TYPE q1[4] = {V_LO16(p2l, p3l), V_HI16(p2l, p3l), V_LO16(p2h, p3h), V_HI16(p2h, p3h)};                    \
+            for (int m = 0; m < 4; m++) {                                                                               \
+                r[2 * m] = V_LO32(q0[m], q1[m]);                                                                        \
+                r[2 * m + 1] = V_HI32(q0[m], q1[m]);                                                                    \
+            }                                                                                                           \
+        }                                                                                                               \
+        uint8_t *dst = unpacked + i * perByte;                                                                          \
+        for (std::size_t k = 0; k < perByte; k++) {                                                                     \
+            V_STORE_LANES(dst, r[k], k, perByte);                                                                       \
+        }                                                                                                               \
+    }                                                                                                                   \
+    return i;
+
+#define STORE_128(p, v) _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v)
+
+    /* SSE2 is part of x86-64, so this kernel needs no runtime check there. */
+#define V_TYPE __m128i
+#define V_BYTES 16
+#define V_LOAD(p) _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+#define V_SET1 _mm_set1_epi8
+#define V_AND _mm_and_si128
+#define V_SRL _mm_srli_epi16
+#define V_LO8 _mm_unpacklo_epi8
+#define V_HI8 _mm_unpackhi_epi8
+#define V_LO16 _mm_unpacklo_epi16
+#define V_HI16 _mm_unpackhi_epi16
+#define V_LO32 _mm_unpacklo_epi32
+#define V_HI32 _mm_unpackhi_epi32
+#define V_STORE_LANES(dst, v, k, perByte) STORE_128(dst + 16 * (k), v)
+
+    __attribute__((target("sse2")))
+    std::size_t unpackSSE2(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        UNPACK_KERNEL_BODY
+    }
+
+#undef V_TYPE
+#undef V_BYTES
+#undef V_LOAD
+#undef V_SET1
+#undef V_AND
+#undef V_SRL
+#undef V_LO8
+#undef V_HI8
+#undef V_LO16
+#undef V_HI16
+#undef V_LO32
+#undef V_HI32
+#undef V_STORE_LANES
+
+#define V_TYPE __m256i
+#define V_BYTES 32
+#define V_LOAD(p) _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+#define V_SET1 _mm256_set1_epi8
+#define V_AND _mm256_and_si256
+#define V_SRL _mm256_srli_epi16
+#define V_LO8 _mm256_unpacklo_epi8
+#define V_HI8 _mm256_unpackhi_epi8
+#define V_LO16 _mm256_unpacklo_epi16
+#define V_HI16 _mm256_unpackhi_epi16
+#define V_LO32 _mm256_unpacklo_epi32
+#define V_HI32 _mm256_unpackhi_epi32
+#define V_STORE_LANES(dst, v, k, perByte)                                                                               \
+    STORE_128(dst + 16 * (k), _mm256_castsi256_si128(v));                                                               \
+    STORE_128(dst + 16 * ((perByte) + (k)), _mm256_extracti128_si256(v, 1))
+
+    __attribute__((target("avx2")))
+    std::size_t unpackAVX2(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        UNPACK_KERNEL_BODY
+    }
+
+#undef V_TYPE
+#undef V_BYTES
+#undef V_LOAD
+#undef V_SET1
+#undef V_AND
+#undef V_SRL
+#undef V_LO8
+#undef V_HI8
+#undef V_LO16
+#undef V_HI16
+#undef V_LO32
+#undef V_HI32
+#undef V_STORE_LANES
+
+#define V_TYPE __m512i
+#define V_BYTES 64
+#define V_LOAD(p) _mm512_loadu_si512(reinterpret_cast<const void *>(p))
+#define V_SET1 _mm512_set1_epi8
+#define V_AND _mm512_and_si512
+#define V_SRL _mm512_srli_epi16
+#define V_LO8 _mm512_unpacklo_epi8
+#define V_HI8 _mm512_unpackhi_epi8
+#define V_LO16 _mm512_unpacklo_epi16
+#define V_HI16 _mm512_unpackhi_epi16
+#define V_LO32 _mm512_unpacklo_epi32
+#define V_HI32 _mm512_unpackhi_epi32
+#define V_STORE_LANES(dst, v, k, perByte)                                                                               \
+    STORE_128(dst + 16 * (k), _mm512_extracti32x4_epi32(v, 0));                                                         \
+    STORE_128(dst + 16 * ((perByte) + (k)), _mm512_extracti32x4_epi32(v, 1));                                           \
+    STORE_128(dst + 16 * (2 * (perByte) + (k)), _mm512_extracti32x4_epi32(v, 2));                                       \
+    STORE_128(dst + 16 * (3 * (perByte) + (k)), _mm512_extracti32x4_epi32(v, 3))
+
+    __attribute__((target("avx512f,avx512bw")))
+    std::size_t unpackAVX512(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        UNPACK_KERNEL_BODY
+    }
+
+#undef V_TYPE
+#undef V_BYTES
+#undef V_LOAD
+#undef V_SET1
+#undef V_AND
+#undef V_SRL
+#undef V_LO8
+#undef V_HI8
+#undef V_LO16
+#undef V_HI16
+#undef V_LO32
+#undef V_HI32
+#undef V_STORE_LANES
+#undef STORE_128
+#undef UNPACK_KERNEL_BODY
+
+#endif
+
+    typedef std::size_t (*UnpackKernel)(const uint8_t *, std::size_t, unsigned int, uint8_t *);
+
+    struct UnpackDispatch
+    {
+        UnpackKernel kernel;
+        std::string isa;
+
+        UnpackDispatch() : kernel(nullptr), isa("lookup") {
+#ifdef UNPACK_HAVE_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512bw")) {
+                kernel = unpackAVX512;
+                isa = "avx512";
+            }
+            else if (__builtin_cpu_supports("avx2")) {
+                kernel = unpackAVX2;
+                isa = "avx2";
+            }
+            else if (__builtin_cpu_supports("sse2")) {
+                kernel = unpackSSE2;
+                isa = "sse2";
+            }
+#endif
+        }
+    };
+
+    const UnpackDispatch dispatch;
+
+    void unpackSerial(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked) {
+        std::size_t done = dispatch.kernel ? dispatch.kernel(packed, nBytes, nBits, unpacked) : 0;
+        unpackLookup(packed + done, nBytes - done, nBits, unpacked + done * (8 / nBits));
+    }
+
+};
+
+void UTILS::unpackBits(const uint8_t *packed, std::size_t nBytes, unsigned int nBits, uint8_t *unpacked, ThreadPool *threadPool) {
+    if (nBits != 1 && nBits != 2 && nBits != 4) {
+        throw InvalidInputs("Only 1, 2 and 4 bit samples can be unpacked");
+    }
+
+    if (!threadPool || threadPool->getNThreads() < 2 || nBytes < 2 * UNPACK_CHUNK_BYTES) {
+        unpackSerial(packed, nBytes, nBits, unpacked);
+        return;
+    }
+
+    std::size_t nChunks = (nBytes + UNPACK_CHUNK_BYTES - 1) / UNPACK_CHUNK_BYTES;
+    threadPool->parallelFor(0, nChunks, [&](std::size_t chunkStart, std::size_t chunkEnd) {
+        std::size_t start = chunkStart * UNPACK_CHUNK_BYTES;
+        std::size_t end = std::min(nBytes, chunkEnd * UNPACK_CHUNK_BYTES);
+        unpackSerial(packed + start, end - start, nBits, unpacked + start * (8 / nBits));
+    });
+}
+
+std::string UTILS::unpackBitsISA() {
+    return dispatch.isa;
+}
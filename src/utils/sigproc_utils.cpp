@@ -4,10 +4,13 @@
 #include <sstream>
 #include <vector>
 
+/**
+ * Extracts bits b1 (inclusive) to b2 (exclusive) of a byte, e.g. (byte, 2, 4) returns the second 2-bit sample.
+ */
 uint8_t extractBitsFromByte(uint8_t byte, uint8_t b1, uint8_t b2)
 {
-    // Create a mask with ones in the positions from b1 to b2
-    uint8_t mask = ((1 << (b2 - b1 + 1)) - 1) << b1;
+    // Create a mask with ones in the positions from b1 to b2 - 1
+    uint8_t mask = ((1 << (b2 - b1)) - 1) << b1;
 
     // Apply the mask to the byte and shift the result to the rightmost position
     uint8_t result = (byte & mask) >> b1;
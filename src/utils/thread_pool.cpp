@@ -0,0 +1,65 @@
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+
+using namespace UTILS;
+
+unsigned int UTILS::resolveNThreads(unsigned int nThreads) {
+    if (nThreads > 0) return nThreads;
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 0 ? hardwareThreads : 1;
+}
+
+ThreadPool::ThreadPool(unsigned int nThreads) : stopping(false) {
+    nThreads = resolveNThreads(nThreads);
+    workers.reserve(nThreads);
+    for (unsigned int i = 0; i < nThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (std::thread &worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, const std::function<void(std::size_t, std::size_t)> &fn, std::size_t minChunk) {
+    if (end <= begin) return;
+
+    std::size_t total = end - begin;
+    std::size_t nChunks = std::min<std::size_t>(workers.size(), (total + minChunk - 1) / std::max<std::size_t>(minChunk, 1));
+
+    if (nChunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    std::size_t chunkSize = (total + nChunks - 1) / nChunks;
+    std::vector<std::future<void>> pending;
+    pending.reserve(nChunks);
+
+    for (std::size_t chunkStart = begin; chunkStart < end; chunkStart += chunkSize) {
+        std::size_t chunkEnd = std::min(end, chunkStart + chunkSize);
+        pending.push_back(submit([&fn, chunkStart, chunkEnd]() { fn(chunkStart, chunkEnd); }));
+    }
+    for (std::future<void> &result : pending) result.get();
+}
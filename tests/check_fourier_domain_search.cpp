@@ -0,0 +1,78 @@
+/*
+ * Checks that FourierDomainSearch recovers the Fourier frequency r and drift z of drifting sinusoids, one between two
+ * bins and one on a bin, to the half-bin and the z step, i.e. that the half-bin correlations land where they belong.
+ *
+ * Build and run with `make check`. Exits with 1 if the check fails.
+ */
+#include "operations/fourier_domain_search.hpp"
+#include "operations/fft.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+    const double SPEED_OF_LIGHT = 299792458.0; // m/s
+
+    struct Injection
+    {
+        double r; /**< Mean Fourier frequency in bins. */
+        double z; /**< Drift over the observation in bins. */
+    };
+
+};
+
+int main() {
+    const double tsamp = 0.001;
+    const std::size_t nSamples = 32768;
+    const double observationLength = nSamples * tsamp;
+    const float zMax = 20.0f;
+
+    if (OPS::RealFFT::goodLength(nSamples) != nSamples) {
+        std::cerr << "FAIL: " << nSamples << " samples is not a length RealFFT supports" << std::endl;
+        return 1;
+    }
+
+    OPS::PeriodicitySearchOptions options;
+    options.nHarmonics = 1;
+    options.nThreads = 1;
+
+    bool failed = false;
+    for (const Injection &injection : {Injection{1000.5, 10.0}, Injection{1000.0, -6.0}}) {
+        /* phase in cycles (r - z / 2) u + z u^2 / 2 over u = t / T, whose mean frequency is r bins */
+        std::mt19937 generator(42);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        std::vector<float> timeSeries(nSamples);
+        for (std::size_t i = 0; i < nSamples; i++) {
+            double u = static_cast<double>(i) / nSamples;
+            double cycles = (injection.r - injection.z / 2) * u + injection.z * u * u / 2;
+            timeSeries[i] = noise(generator) + 0.1f * static_cast<float>(std::cos(2.0 * M_PI * (cycles - std::floor(cycles))));
+        }
+
+        OPS::FourierDomainSearch search({0.0f}, nSamples, tsamp, options, zMax, 0.0f);
+        std::vector<OPS::PeriodicityCandidate> found;
+        search.searchSeries(timeSeries.data(), nSamples, 0.0f, found);
+        if (found.empty()) {
+            std::cerr << "FAIL: no candidates for r = " << injection.r << ", z = " << injection.z << std::endl;
+            failed = true;
+            continue;
+        }
+
+        const OPS::PeriodicityCandidate &best = *std::max_element(found.begin(), found.end(),
+            [](const OPS::PeriodicityCandidate &a, const OPS::PeriodicityCandidate &b) { return a.power < b.power; });
+        double r = best.frequency * observationLength;
+        double z = -best.acceleration * best.frequency * observationLength * observationLength / SPEED_OF_LIGHT;
+        std::cout << "Injected r = " << injection.r << ", z = " << injection.z << ": strongest candidate at r = " << r
+                  << ", z = " << z << ", power " << best.power << std::endl;
+        if (std::fabs(r - injection.r) > 0.25 || std::fabs(z - injection.z) > OPS::FourierDomainSearch::Z_STEP / 2) {
+            std::cerr << "FAIL: the strongest candidate is not at the injected r and z" << std::endl;
+            failed = true;
+        }
+    }
+
+    if (failed) return 1;
+    std::cout << "PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Checks that the harmonic summing of PeriodicitySearch reports a pulse train whose frequency falls between Fourier
+ * bins at its fundamental, and not at a harmonic whose summed power the misplaced higher harmonics let win.
+ *
+ * Build and run with `make check`. Exits with 1 if the check fails.
+ */
+#include "operations/periodicity_search.hpp"
+#include "operations/fft.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main() {
+    const double tsamp = 0.001;
+    const std::size_t nSamples = 39366;
+    const double observationLength = nSamples * tsamp;
+    /* at half-bin 1574.64, a third of a bin from the nearest half-bin */
+    const double frequency = 20.0;
+    const double pulseWidth = 0.001;
+
+    if (OPS::RealFFT::goodLength(nSamples) != nSamples) {
+        std::cerr << "FAIL: " << nSamples << " samples is not a length RealFFT supports" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 generator(42);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> timeSeries(nSamples);
+    for (std::size_t i = 0; i < nSamples; i++) {
+        double phase = std::fmod(i * tsamp * frequency, 1.0);
+        double offset = std::min(phase, 1.0 - phase) / frequency / pulseWidth;
+        timeSeries[i] = noise(generator) + 2.0f * static_cast<float>(std::exp(-0.5 * offset * offset));
+    }
+
+    OPS::PeriodicitySearchOptions options;
+    options.nHarmonics = 16;
+    options.nThreads = 1;
+    OPS::PeriodicitySearch search({0.0f}, nSamples, tsamp, options);
+    std::vector<OPS::PeriodicityCandidate> found;
+    search.searchSeries(timeSeries.data(), nSamples, 0.0f, found);
+    if (found.empty()) {
+        std::cerr << "FAIL: no candidates" << std::endl;
+        return 1;
+    }
+
+    const OPS::PeriodicityCandidate &best = found.front();
+    std::cout << "Strongest candidate: " << best.frequency << " Hz, " << best.nHarmonics << " harmonics, sigma "
+              << best.sigma << " (true frequency " << frequency << " Hz)" << std::endl;
+    if (std::fabs(best.frequency - frequency) > 1.0 / observationLength) {
+        std::cerr << "FAIL: the strongest candidate is not at the fundamental" << std::endl;
+        return 1;
+    }
+    std::cout << "PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Checks that SinglePulseSearch reports a pulse straddling the boundary of two gulps once, at its position.
+ *
+ * Build and run with `make check`. Exits with 1 if the check fails.
+ */
+#include "operations/single_pulse_search.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main() {
+    const double tsamp = 0.001;
+    const std::size_t gulpNSamples = 10000;
+    const std::size_t nGulps = 2;
+    const std::size_t pulseStart = gulpNSamples - 8;
+    const unsigned int pulseWidth = 16;
+
+    std::mt19937 generator(42);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> timeSeries(nGulps * gulpNSamples);
+    for (std::size_t i = 0; i < timeSeries.size(); i++) timeSeries[i] = noise(generator);
+    for (std::size_t i = pulseStart; i < pulseStart + pulseWidth; i++) timeSeries[i] += 4.0f;
+
+    OPS::SinglePulseSearchOptions options;
+    options.maxWidth = 32;
+    options.sigmaThreshold = 8.0f;
+    std::vector<float> dmList{0.0f};
+    OPS::SinglePulseSearch search(dmList, tsamp, options);
+    for (std::size_t gulp = 0; gulp < nGulps; gulp++) {
+        IO::DedispersedBlock block{timeSeries.data() + gulp * gulpNSamples, dmList.data(), 0, 1, gulp * gulpNSamples, gulpNSamples};
+        search.consume(block);
+    }
+    search.finish();
+
+    const std::vector<OPS::SinglePulseEvent> &events = search.getEvents();
+    for (const OPS::SinglePulseEvent &event : events) {
+        std::cout << "Event at sample " << event.sample << ", width " << event.width << ", S/N " << event.snr << std::endl;
+    }
+    if (events.size() != 1) {
+        std::cerr << "FAIL: " << events.size() << " events instead of one for a pulse at sample " << pulseStart << std::endl;
+        return 1;
+    }
+    const OPS::SinglePulseEvent &event = events.front();
+    if (event.sample + event.width <= pulseStart || event.sample >= pulseStart + pulseWidth) {
+        std::cerr << "FAIL: the event does not overlap the pulse at sample " << pulseStart << std::endl;
+        return 1;
+    }
+    std::cout << "PASS" << std::endl;
+    return 0;
+}